@@ -0,0 +1,486 @@
+/*!
+	@file	assignment.cpp
+	@brief	Compact storage, verification and comparison of assignments
+
+	@author Bastian Rieck
+*/
+
+#include <new>
+#include <vector>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "assignment.h"
+
+/*!
+	Size of the buffer of an unmapped writer.
+*/
+
+static const size_t buffer_size = 1 << 16;
+
+/*!
+	Writes all bytes of a buffer to a file descriptor.
+*/
+
+static bool write_bytes(int fd, const unsigned char* p, size_t bytes)
+{
+	while(bytes > 0)
+	{
+		ssize_t w = ::write(fd, p, bytes);
+		if(w < 0 && errno == EINTR)
+			continue;
+		if(w <= 0)
+			return(false);
+
+		p     += w;
+		bytes -= w;
+	}
+
+	return(true);
+}
+
+/*!
+	Encodes bins as zigzag varints of their differences.
+
+	@param bins		Bins to encode
+	@param count		Number of bins
+	@param previous		Bin preceding the first one; updated to the
+				last bin
+	@param out		Buffer of at least count*max_varint_bytes bytes
+
+	@return Number of bytes written.
+*/
+
+size_t encode_bins(const unsigned int* bins, size_t count, unsigned int& previous, unsigned char* out)
+{
+	unsigned char* p = out;
+	for(size_t i = 0; i < count; i++)
+	{
+		// Zigzag encoding maps small negative and positive differences
+		// to small unsigned numbers
+		int32_t delta	= static_cast<int32_t>(bins[i]-previous);
+		uint32_t value	= (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+
+		while(value >= 0x80)
+		{
+			*p++ = static_cast<unsigned char>(value | 0x80);
+			value >>= 7;
+		}
+
+		*p++ = static_cast<unsigned char>(value);
+		previous = bins[i];
+	}
+
+	return(p-out);
+}
+
+/*!
+	Decodes bins that have been encoded by encode_bins().
+
+	@param data		Encoded data
+	@param size		Size of the data
+	@param position		Offset of the first byte to decode; updated
+	@param bins		Will contain the decoded bins
+	@param count		Number of bins to decode
+	@param previous		Bin preceding the first one; updated to the
+				last bin
+
+	@return false if the data ends prematurely or is malformed.
+*/
+
+bool decode_bins(const unsigned char* data, size_t size, size_t& position, unsigned int* bins, size_t count, unsigned int& previous)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		uint32_t value = 0;
+		unsigned int shift = 0;
+
+		for(;;)
+		{
+			if(position >= size || shift > 28)
+				return(false);
+
+			unsigned char byte = data[position++];
+			value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+			shift += 7;
+
+			if(byte < 0x80)
+				break;
+		}
+
+		int32_t delta = static_cast<int32_t>((value >> 1) ^ (~(value & 1)+1));
+		previous += delta;
+		bins[i]   = previous;
+	}
+
+	return(true);
+}
+
+assignment_writer::assignment_writer()
+	: fd(-1), map(false), buffer(NULL), capacity(0), length(0), n(0), written(0), previous(0)
+{
+}
+
+assignment_writer::~assignment_writer()
+{
+	if(fd >= 0)
+		close();
+}
+
+/*!
+	Creates an assignment file and writes its header.
+
+	@param path		Path of the file
+	@param n		Number of items that will be written
+	@param num_bins		Number of bins of the assignment
+	@param map		Whether to encode directly into a mapped file. The
+				file is mapped with its maximum size and truncated
+				when it is closed.
+
+	@return true on success.
+*/
+
+bool assignment_writer::open(const char* path, size_t n, unsigned int num_bins, bool map)
+{
+	if(fd >= 0)
+		return(false);
+
+	fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+		return(false);
+
+	this->map	= map;
+	this->n		= n;
+	this->written	= 0;
+	this->previous	= 0;
+	this->length	= 0;
+
+	if(map)
+	{
+		capacity = sizeof(assignment_header) + n*max_varint_bytes;
+		if(ftruncate(fd, capacity) != 0)
+		{
+			::close(fd);
+			fd = -1;
+			return(false);
+		}
+
+		void* p = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if(p == MAP_FAILED)
+		{
+			::close(fd);
+			fd = -1;
+			return(false);
+		}
+
+		buffer = static_cast<unsigned char*>(p);
+	}
+	else
+	{
+		capacity = buffer_size;
+		buffer	 = new(std::nothrow) unsigned char[capacity];
+		if(buffer == NULL)
+		{
+			::close(fd);
+			fd = -1;
+			return(false);
+		}
+	}
+
+	assignment_header header;
+	header.magic	= assignment_magic;
+	header.num_bins	= num_bins;
+	header.n	= n;
+
+	memcpy(buffer, &header, sizeof(header));
+	length = sizeof(header);
+
+	return(true);
+}
+
+/*!
+	Appends the bins of the next items.
+
+	@param bins	Bins of the items
+	@param count	Number of items
+
+	@return true on success, false on an I/O error or if more items than
+	announced are written.
+*/
+
+bool assignment_writer::write(const unsigned int* bins, size_t count)
+{
+	if(fd < 0 || written+count > n)
+		return(false);
+
+	written += count;
+	while(count > 0)
+	{
+		if(length+max_varint_bytes > capacity && !flush())
+			return(false);
+
+		// Encode as many bins as are guaranteed to fit
+		size_t chunk = (capacity-length)/max_varint_bytes;
+		if(chunk > count)
+			chunk = count;
+
+		length += encode_bins(bins, chunk, previous, buffer+length);
+		bins   += chunk;
+		count  -= chunk;
+	}
+
+	return(true);
+}
+
+/*!
+	Writes the buffer to the file. Mapped files never need to be flushed.
+*/
+
+bool assignment_writer::flush()
+{
+	if(map)
+		return(length <= capacity);
+
+	if(!write_bytes(fd, buffer, length))
+		return(false);
+
+	length = 0;
+	return(true);
+}
+
+/*!
+	Finishes the file.
+
+	@return true if all announced items have been written and the file
+	has been stored successfully.
+*/
+
+bool assignment_writer::close()
+{
+	if(fd < 0)
+		return(false);
+
+	bool success = (written == n);
+	if(map)
+	{
+		success = (munmap(buffer, capacity) == 0) && success;
+		success = (ftruncate(fd, length) == 0) && success;
+	}
+	else
+	{
+		success = flush() && success;
+		delete[] buffer;
+	}
+
+	success = (::close(fd) == 0) && success;
+
+	fd	 = -1;
+	buffer	 = NULL;
+	return(success);
+}
+
+/*!
+	Reads an assignment file.
+
+	@param path		Path of the file
+	@param bins		Array that will contain the bins of all items. If
+				NULL, only the header is read.
+	@param capacity		Number of entries of the array
+	@param n		Will contain the number of items
+	@param num_bins		Will contain the number of bins
+
+	@return true on success, false if the file cannot be read, is not an
+	assignment file, is truncated, or has more items than the array.
+*/
+
+bool read_assignment(const char* path, unsigned int* bins, size_t capacity, size_t& n, unsigned int& num_bins)
+{
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0)
+		return(false);
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(assignment_header))
+	{
+		::close(fd);
+		return(false);
+	}
+
+	size_t size = info.st_size;
+	void* p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if(p == MAP_FAILED)
+		return(false);
+
+	const unsigned char* data = static_cast<const unsigned char*>(p);
+
+	assignment_header header;
+	memcpy(&header, data, sizeof(header));
+
+	bool success = (header.magic == assignment_magic);
+	if(success)
+	{
+		n	 = header.n;
+		num_bins = header.num_bins;
+	}
+
+	if(success && bins != NULL)
+	{
+		success = (n <= capacity);
+
+		size_t position	  = sizeof(header);
+		unsigned int previous = 0;
+
+		success = success && decode_bins(data, size, position, bins, n, previous);
+	}
+
+	munmap(p, size);
+	return(success);
+}
+
+/*!
+	Checks an assignment in linear time: every item has to be assigned to
+	one of the bins, no bin may exceed the capacity, and no bin may be
+	empty.
+
+	@param items		Array of item sizes
+	@param n		Number of items
+	@param K		Capacity of bins
+	@param bins		Bin of every item
+	@param num_bins		Number of bins
+	@param item		Will contain the offending item, if any
+	@param bin		Will contain the offending bin, if any
+	@param load		Will contain the load of the offending bin, if any
+
+	@return Type of the first violation that has been found. Throws
+	std::bad_alloc if no memory is available for the loads of all bins.
+*/
+
+assignment_violation verify_assignment(	const unsigned int* items, size_t n, unsigned int K,
+					const unsigned int* bins, unsigned int num_bins,
+					size_t& item, unsigned int& bin, unsigned long long& load)
+{
+	std::vector<unsigned long long> loads(num_bins, 0);
+	std::vector<bool> used(num_bins, false);
+
+	for(size_t i = 0; i < n; i++)
+	{
+		if(bins[i] >= num_bins)
+		{
+			item = i;
+			bin  = bins[i];
+			load = 0;
+
+			return(VIOLATION_BIN_OUT_OF_RANGE);
+		}
+
+		loads[bins[i]] += items[i];
+		used[bins[i]]   = true;
+	}
+
+	for(unsigned int j = 0; j < num_bins; j++)
+	{
+		if(loads[j] > K || !used[j])
+		{
+			item = n;
+			bin  = j;
+			load = loads[j];
+
+			return(loads[j] > K ? VIOLATION_OVER_CAPACITY : VIOLATION_EMPTY_BIN);
+		}
+	}
+
+	return(VIOLATION_NONE);
+}
+
+/*!
+	Compares the assignment of an optimized implementation of a heuristic
+	to the one of its reference implementation. Both have to be valid.
+
+	Whenever several bins suit an item equally well, two implementations
+	may pick different ones without packing any worse, so identical bins
+	are too strict a requirement. Instead, the items are replayed in the
+	order in which the heuristic places them, and every item has to go
+	to a bin with the same load in both assignments, or to a new bin in
+	both. By induction, the loads of all bins then agree as a multiset
+	after every item, and both implementations make equivalent decisions
+	throughout.
+
+	@param items		Array of item sizes
+	@param n		Number of items
+	@param order		Items in the order of placement, or NULL if the
+				items are placed in their original order
+	@param reference	Bin of every item in the reference
+	@param reference_bins	Number of bins of the reference
+	@param variant		Bin of every item in the variant
+	@param variant_bins	Number of bins of the variant
+	@param item		Will contain the first item, in the order of
+				placement, that goes to a bin of another load,
+				or n if there is none
+	@param reference_load	Will contain the load of its bin in the
+				reference before the item has been placed
+	@param variant_load	Will contain the load of its bin in the
+				variant before the item has been placed
+
+	@return Most severe difference. Throws std::bad_alloc if no memory is
+	available for the loads of all bins.
+*/
+
+assignment_difference compare_assignments(	const unsigned int* items, size_t n, const unsigned int* order,
+						const unsigned int* reference, unsigned int reference_bins,
+						const unsigned int* variant, unsigned int variant_bins,
+						size_t& item, unsigned long long& reference_load, unsigned long long& variant_load)
+{
+	// Loads are kept per bin; bins that have not been opened yet are
+	// told apart from open bins that only hold items of size 0
+	std::vector<unsigned long long> loads_reference(reference_bins, 0);
+	std::vector<unsigned long long> loads_variant(variant_bins, 0);
+	std::vector<bool> open_reference(reference_bins, false);
+	std::vector<bool> open_variant(variant_bins, false);
+
+	bool identical = true;
+
+	item		= n;
+	reference_load	= 0;
+	variant_load	= 0;
+
+	for(size_t k = 0; k < n; k++)
+	{
+		size_t i	 = order != NULL ? order[k] : k;
+		unsigned int r	 = reference[i];
+		unsigned int v	 = variant[i];
+
+		identical = identical && (r == v);
+
+		if(	open_reference[r] != open_variant[v] ||
+			loads_reference[r] != loads_variant[v])
+		{
+			item		= i;
+			reference_load	= loads_reference[r];
+			variant_load	= loads_variant[v];
+			break;
+		}
+
+		loads_reference[r] += items[i];
+		loads_variant[v]   += items[i];
+		open_reference[r]   = true;
+		open_variant[v]	    = true;
+	}
+
+	if(reference_bins != variant_bins)
+		return(DIFFERENCE_BINS);
+	else if(item < n)
+		return(DIFFERENCE_PLACEMENT);
+	else if(!identical)
+		return(DIFFERENCE_TIES);
+	else
+		return(DIFFERENCE_NONE);
+}
@@ -0,0 +1,101 @@
+/*!
+	@file	assignment.h
+	@brief	Compact storage, verification and comparison of assignments
+
+	An assignment file starts with a header, followed by the bins of all
+	items in their original order. Every bin is stored as the difference
+	to the bin of the previous item, zigzag-encoded and written as a
+	varint of 1 to 5 bytes. Heuristics tend to put consecutive items into
+	the same or nearby bins, so most items take a single byte.
+
+	@author Bastian Rieck
+*/
+
+#ifndef ASSIGNMENT_H
+#define ASSIGNMENT_H
+
+#include <cstddef>
+#include <stdint.h>
+
+static const uint32_t assignment_magic = 0x53415042;	///< "BPAS"
+
+struct assignment_header
+{
+	uint32_t magic;
+	uint32_t num_bins;
+	uint64_t n;		///< Number of items
+};
+
+/*!
+	Writes an assignment to a file, either through a buffer or by
+	encoding directly into a memory-mapped file. The bins may be written
+	in several chunks; the total number of items is fixed in advance.
+*/
+
+class assignment_writer
+{
+	public:
+		assignment_writer();
+		~assignment_writer();
+
+		bool open(const char* path, size_t n, unsigned int num_bins, bool map);
+		bool write(const unsigned int* bins, size_t count);
+		bool close();
+
+	private:
+		bool flush();
+
+		int fd;
+		bool map;
+
+		unsigned char* buffer;	///< Write buffer or mapped file
+		size_t capacity;	///< Size of the buffer
+		size_t length;		///< Bytes used in the buffer
+
+		size_t n;		///< Announced number of items
+		size_t written;		///< Number of items written so far
+		unsigned int previous;	///< Bin of the previous item
+};
+
+static const size_t max_varint_bytes = 5;	///< Maximum size of an encoded bin
+
+size_t encode_bins(const unsigned int* bins, size_t count, unsigned int& previous, unsigned char* out);
+bool decode_bins(const unsigned char* data, size_t size, size_t& position, unsigned int* bins, size_t count, unsigned int& previous);
+
+bool read_assignment(const char* path, unsigned int* bins, size_t capacity, size_t& n, unsigned int& num_bins);
+
+/*!
+	Describes the first problem found by verify_assignment().
+*/
+
+enum assignment_violation
+{
+	VIOLATION_NONE,
+	VIOLATION_BIN_OUT_OF_RANGE,	///< An item refers to a bin >= num_bins
+	VIOLATION_OVER_CAPACITY,	///< The items of a bin exceed the capacity
+	VIOLATION_EMPTY_BIN		///< A bin does not contain any item
+};
+
+assignment_violation verify_assignment(	const unsigned int* items, size_t n, unsigned int K,
+					const unsigned int* bins, unsigned int num_bins,
+					size_t& item, unsigned int& bin, unsigned long long& load);
+
+/*!
+	Describes how two assignments of the same items differ; see
+	compare_assignments().
+*/
+
+enum assignment_difference
+{
+	DIFFERENCE_NONE,	///< Every item is in the same bin
+	DIFFERENCE_TIES,	///< Items only go to other bins of the same load
+	DIFFERENCE_PLACEMENT,	///< An item goes to a bin of another load
+	DIFFERENCE_BINS		///< The number of bins differs
+};
+
+assignment_difference compare_assignments(	const unsigned int* items, size_t n, const unsigned int* order,
+						const unsigned int* reference, unsigned int reference_bins,
+						const unsigned int* variant, unsigned int variant_bins,
+						size_t& item, unsigned long long& reference_load, unsigned long long& variant_load);
+
+#endif
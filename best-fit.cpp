@@ -14,45 +14,51 @@
 #include <cmath>
 
 #include "bin-packing.h"
+#include "run-control.h"
 #include "simple-heap.h"
+#include "bin-scan.h"
+#include "workspace.h"
+#include "fixed-capacity.h"
+#include "trace.h"
 
 /*!
-	Performs the "Best-Fit" heuristic for the current problem. Worst-case
-	running time is O(n^2).
+	Implementation of the "Best-Fit" heuristic for bins whose fill levels
+	are stored using a certain unsigned integer type.
 */
 
-unsigned int best_fit(const unsigned* objects, unsigned int* positions, double& time)
+template<typename bin_t> static unsigned int best_fit_bins(const problem& p, unsigned int* positions, double& time)
 {
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = p.K;
+	const unsigned int min_size = p.min_size;
+
 	unsigned int num_open_bins = 1;
 	unsigned int num_full_bins = 0;
-	unsigned int* bins = new unsigned int[n];
-	
-	memset(bins, 0, n*sizeof(unsigned int));
-	memset(positions, 0, n*sizeof(unsigned int));
+	bin_t* bins = p.ws->borrow_zeroed<bin_t>(WS_BINS, n);
+
+	// Open bins are moved around when full bins are removed, so their
+	// original indices are kept separately
+	unsigned int* ids = p.ws->borrow_zeroed<unsigned int>(WS_NEXT, n);
 
 	unsigned int limit_capacity = K-min_size;
 	
 	clock_t start = clock();
+	long long traced = trace_begin();
 	for(unsigned int i = 0; i < n; i++)
 	{
-		unsigned int best_bin = n; // best bin that has been determined so far
-		unsigned int best_cap = 0; // capacity for said bin if the object has been added
+		if(stop_requested(p, i, num_open_bins+num_full_bins))
+			break;
 
-		for(unsigned int j = 0; j < num_open_bins; j++)
-		{
-			unsigned int temp_cap = bins[j]+objects[i];
-			if(temp_cap <= K && temp_cap > best_cap)
-			{
-				best_bin = j;
-				best_cap = temp_cap;
-			}
-		}
+		// Bin with the highest fill level that is still able to
+		// take the object
+		unsigned int best_bin = scan_best_fit(bins, num_open_bins, K-objects[i]);
 
 		// Best bin has been found...
-		if(best_bin < n)
+		if(best_bin < num_open_bins)
 		{
 			bins[best_bin] += objects[i];
-			positions[i] = best_bin;
+			positions[i] = ids[best_bin];
 
 			// Remove (almost) full bins
 			if(bins[best_bin] > limit_capacity)
@@ -60,6 +66,7 @@ unsigned int best_fit(const unsigned* objects, unsigned int* positions, double&
 				num_open_bins--;
 				num_full_bins++;
 				bins[best_bin] = bins[num_open_bins];
+				ids[best_bin]  = ids[num_open_bins];
 			}
 		}
 
@@ -67,47 +74,76 @@ unsigned int best_fit(const unsigned* objects, unsigned int* positions, double&
 		else
 		{
 			bins[num_open_bins] = objects[i];
-			positions[i] = num_open_bins++;
+			ids[num_open_bins]  = num_open_bins+num_full_bins;
+			positions[i] = ids[num_open_bins++];
 		}
 	}
 
 	clock_t end = clock();
+	trace_end("pack", "pack", traced);
 	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
 
-	delete[] bins;
 	return(num_open_bins+num_full_bins);
 
 }
 
+/*!
+	Performs the "Best-Fit" heuristic for the current problem. Worst-case
+	running time is O(n^2). The bins are scanned using vectorized kernels;
+	if K permits it, fill levels are stored as 16 bit integers.
+*/
+
+unsigned int best_fit(const problem& p, unsigned int* positions, double& time)
+{
+	if(p.K < 0xFFFF)
+		return(best_fit_bins<unsigned short>(p, positions, time));
+	else
+		return(best_fit_bins<unsigned int>(p, positions, time));
+}
+
 /*!
 	An implementation of the "Best-Fit" heuristic that uses a heap in order
-	to determine the best bin more rapidly.
+	to determine the best bin more rapidly. If positions are requested, the
+	heap stores the id of every bin along with its fill level. The
+	positions array may be NULL.
 */
 
-unsigned int best_fit_heap(const unsigned* objects, double& time)
+unsigned int best_fit_heap(const problem& p, unsigned int* positions, double& time)
 {
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = p.K;
+
 	unsigned int num_bins = 0;
 
-	simple_heap bins(n);
+	simple_heap bins(*p.ws, n, positions != NULL);
 	std::queue<unsigned int> heap_queue;
 	
 	clock_t start = clock();
+	long long traced = trace_begin();
 	for(unsigned int i = 0; i < n; i++)
 	{
+		if(stop_requested(p, i, num_bins))
+			break;
+
 		unsigned int best_bin = n; // best bin that has been determined so far
 		unsigned int best_cap = 0; // capacity for said bin if the object has been added
 
-    		if(num_bins != 0 && (bins.elements[1] + objects[i]) <= K)
+		// Minimum capacity that is required in order to fit the object
+		// into a bin; comparing with it cannot overflow
+		unsigned int required_capacity = K-objects[i];
+
+    		if(num_bins != 0 && bins.elements[1] <= required_capacity)
                 {
 			// Perform a breadth-first-search through the bin
                         heap_queue.push(1);
                         while(!heap_queue.empty())
                         {
                                 unsigned int j = heap_queue.front();
-                                unsigned int temp_cap = bins.elements[j]+objects[i];
-                                if(temp_cap <= K)
+                                if(bins.elements[j] <= required_capacity)
                                 {
-                                        if(temp_cap > best_cap)
+                                        unsigned int temp_cap = bins.elements[j]+objects[i];
+                                        if(best_bin == n || temp_cap > best_cap)
                                         {
                                                 best_bin = j;
                                                 best_cap = temp_cap;
@@ -130,18 +166,25 @@ unsigned int best_fit_heap(const unsigned* objects, double& time)
 		if(best_bin < n)
 		{
 			bins.elements[best_bin] += objects[i];
+			if(positions != NULL)
+				positions[i] = bins.ids[best_bin];
+
 			bins.reheap_down(best_bin);
 		}
 
 		// ...else create a new one
 		else
 		{
-			bins.push(objects[i]);
+			if(positions != NULL)
+				positions[i] = num_bins;
+
+			bins.push(objects[i], num_bins);
 			num_bins++;
 		}
 	}
 
 	clock_t end = clock();
+	trace_end("pack", "pack", traced);
 	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
 
 	return(num_bins);
@@ -151,26 +194,68 @@ unsigned int best_fit_heap(const unsigned* objects, double& time)
 	An implementation of the "Best-Fit" heuristic that uses a lookup table
 	to determine the proper bin more rapidly. The running time thus
 	decreases to O(n*K).
+
+	The table only counts the bins per remaining capacity. If positions
+	are recorded, the bins of every remaining capacity are additionally
+	kept in a linked list, which is unnecessary for the count alone.
+
+	C is the capacity if it is known at compile time, else 0. For a fixed
+	capacity, the per-capacity tables live on the stack.
 */
 
-unsigned int best_fit_lookup(const unsigned* objects, double& time)
+template<bool record, unsigned int C> static unsigned int best_fit_lookup_bins(const problem& p, unsigned int* positions, double& time)
 {
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = C ? C : p.K;
+
         unsigned int num_bins = 0;
-        unsigned int* bin_count = new unsigned int[K+1];
-        memset(bin_count, 0, (K+1)*sizeof(unsigned int));
+
+	unsigned int local_count[C+1];
+	unsigned int* bin_count = local_count;
+
+	if(C)
+		memset(bin_count, 0, sizeof(local_count));
+	else
+		bin_count = p.ws->borrow_zeroed<unsigned int>(WS_SIZES, static_cast<size_t>(K)+1);
 
 	// At the beginning of the algorithm, there are n bins with a remaining
 	// capacity of K.
         bin_count[K] = n;
 
+	// Bins that have been opened by objects of size 0 still have a
+	// remaining capacity of K, so they are counted separately
+	unsigned int num_empty = 0;
+
+	// Lists of opened bins per remaining capacity. Bins that have not
+	// been opened yet are not part of any list.
+	const unsigned int no_bin = 0xFFFFFFFF;
+	unsigned int local_first[record ? C+1 : 1];
+	unsigned int* first = local_first;
+	unsigned int* next  = NULL;
+	unsigned int num_opened = 0;
+
+	if(record)
+	{
+		if(!C)
+			first = p.ws->borrow<unsigned int>(WS_NEXT, static_cast<size_t>(K)+1);
+
+		next = p.ws->borrow<unsigned int>(WS_BINS, n);
+		memset(first, 0xFF, (static_cast<size_t>(K)+1)*sizeof(unsigned int));
+	}
+
         unsigned int req_size = 0; 	// Minimum required remaining capacity; finding a bin
 					// with this capacity would be optimal.
         unsigned int cur_size = 0; 	// Stores current capacity while searching for a 
 					// suitable bin. 
 
         clock_t start = clock();
+        long long traced = trace_begin();
         for(unsigned int i = 0; i < n; i++)
         {
+		if(stop_requested(p, i, n-bin_count[K]+num_empty))
+			break;
+
                 req_size  = objects[i];
                 cur_size  = objects[i];
 
@@ -179,14 +264,59 @@ unsigned int best_fit_lookup(const unsigned* objects, double& time)
 
                 bin_count[cur_size]--;
                 bin_count[cur_size-req_size]++;
+
+		// Opened bins are preferred to new ones
+		if(cur_size == K)
+		{
+			if(req_size > 0 && num_empty > 0)
+				num_empty--;
+			else if(req_size == 0 && num_empty == 0)
+				num_empty++;
+		}
+
+		if(record)
+		{
+			unsigned int bin = first[cur_size];
+			if(bin == no_bin)
+				bin = num_opened++;
+			else
+				first[cur_size] = next[bin];
+
+			next[bin] = first[cur_size-req_size];
+			first[cur_size-req_size] = bin;
+
+			positions[i] = bin;
+		}
         }
 
         clock_t end = clock();
+        trace_end("pack", "pack", traced);
         time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
         
+	num_bins = num_empty;
 	for(unsigned int i = 0; i < K; i++)
                 num_bins += bin_count[i];
 
-        delete[] bin_count;
         return(num_bins);
 }
+
+struct best_fit_lookup_kernel
+{
+	template<unsigned int C> static unsigned int run(const problem& p, unsigned int* positions, double& time)
+	{
+		if(positions != NULL)
+			return(best_fit_lookup_bins<true, C>(p, positions, time));
+		else
+			return(best_fit_lookup_bins<false, C>(p, positions, time));
+	}
+};
+
+/*!
+	Performs the "Best-Fit" heuristic using a lookup table. The positions
+	array may be NULL, in which case only the bins are counted.
+*/
+
+unsigned int best_fit_lookup(const problem& p, unsigned int* positions, double& time)
+{
+	return(dispatch_capacity<best_fit_lookup_kernel>(p, positions, time));
+}
@@ -8,8 +8,10 @@
 #ifndef BEST_FIT_H
 #define BEST_FIT_H
 
-unsigned int best_fit(const unsigned int*, unsigned int*, double&);
-unsigned int best_fit_heap(const unsigned* objects, double&);
-unsigned int best_fit_lookup(const unsigned* objects, double&);
+struct problem;
+
+unsigned int best_fit(const problem&, unsigned int*, double&);
+unsigned int best_fit_heap(const problem&, unsigned int*, double&);
+unsigned int best_fit_lookup(const problem&, unsigned int*, double&);
 
 #endif
@@ -0,0 +1,2264 @@
+/*!
+	@file	bin-packing-api.cpp
+	@brief	Implementation of the public C interface of the library
+
+	@author Bastian Rieck
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <new>
+#include <vector>
+
+#include "bin-packing-api.h"
+#include "bin-packing.h"
+#include "workspace.h"
+#include "sorted-view.h"
+#include "bin-scan.h"
+#include "assignment.h"
+#include "fixed-capacity.h"
+#include "result-cache.h"
+#include "online-packing.h"
+#include "external-packing.h"
+#include "concurrent-packing.h"
+#include "run-control.h"
+#include "heuristic-selection.h"
+#include "lower-bound.h"
+#include "trace.h"
+
+#include "first-fit.h"
+#include "next-fit.h"
+#include "best-fit.h"
+#include "max-rest.h"
+#include "vector-packing.h"
+
+/*!
+	Describes a heuristic of the library.
+*/
+
+struct heuristic_entry
+{
+	const char* name;
+	unsigned int (*f)(const problem&, unsigned int*, double&);
+
+	bool needs_positions;	///< Heuristic always fills the positions array
+	bool decreasing;	///< Positions refer to the sorted view
+
+	bp_heuristic reference;	///< Implementation whose bins it has to reproduce
+};
+
+/*!
+	All heuristics, in the order of the bp_heuristic enumeration.
+*/
+
+static const heuristic_entry heuristics[BP_NUM_HEURISTICS] =
+{
+	{ "Max-Rest",			max_rest,			true,	false,	BP_MAX_REST },
+	{ "Max-Rest+",			max_rest_pq,			false,	false,	BP_MAX_REST },
+	{ "First-Fit",			first_fit,			true,	false,	BP_FIRST_FIT },
+	{ "First-Fit+",			first_fit_vec,			false,	false,	BP_FIRST_FIT },
+	{ "First-Fit++",		first_fit_map,			false,	false,	BP_FIRST_FIT },
+	{ "First-Fit-Decreasing",	first_fit_decreasing,		true,	true,	BP_FIRST_FIT_DECREASING },
+	{ "First-Fit-Decreasing+",	first_fit_decreasing_vec,	false,	true,	BP_FIRST_FIT_DECREASING },
+	{ "First-Fit-Decreasing++",	first_fit_decreasing_map,	false,	true,	BP_FIRST_FIT_DECREASING },
+	{ "Next-Fit",			next_fit,			true,	false,	BP_NEXT_FIT },
+	{ "Next-Fit-Decreasing",	next_fit_decreasing,		true,	true,	BP_NEXT_FIT_DECREASING },
+	{ "Best-Fit",			best_fit,			true,	false,	BP_BEST_FIT },
+	{ "Best-Fit+",			best_fit_heap,			false,	false,	BP_BEST_FIT },
+	{ "Best-Fit++",			best_fit_lookup,		false,	false,	BP_BEST_FIT },
+	{ "Next-Fit (parallel)",	next_fit_parallel,		false,	false,	BP_NEXT_FIT },
+	{ "First-Fit-Decreasing (sharded)", first_fit_decreasing_sharded, true,	true,	BP_FIRST_FIT_DECREASING_SHARDED }
+};
+
+/*!
+	Describes a vector packing heuristic of the library.
+*/
+
+struct vector_heuristic_entry
+{
+	const char* name;
+	unsigned int (*f)(const vector_problem&, unsigned int*, double&);
+};
+
+/*!
+	All vector packing heuristics, in the order of the bp_vector_heuristic
+	enumeration.
+*/
+
+static const vector_heuristic_entry vector_heuristics[BP_NUM_VECTOR_HEURISTICS] =
+{
+	{ "Vector First-Fit",			vector_first_fit },
+	{ "Vector First-Fit-Decreasing",	vector_first_fit_decreasing },
+	{ "Vector Best-Fit (dot)",		vector_best_fit_dot },
+	{ "Vector Best-Fit (L2)",		vector_best_fit_l2 }
+};
+
+/*!
+	State of the library: the current instance and the memory that is
+	shared by all heuristics running on it. A context holds a scalar and
+	a vector instance independently of each other.
+*/
+
+struct bp_context
+{
+	problem p;
+	unsigned long long sum_size;
+	bool has_instance;
+
+	vector_problem vp;
+	std::vector<unsigned int> vector_capacity;
+	bool has_vector_instance;
+
+	workspace ws;
+	sorted_view view;
+
+	// Instance that is being streamed, see bp_begin_instance()
+	bool streaming;
+	int stream_status;			///< First error while streaming
+	std::vector<unsigned int> histogram;	///< Objects per size; empty if K is too large
+	double histogram_time;
+
+	online_next_fit next_fit;
+	online_max_rest max_rest;
+
+	// Results of the heuristics that ran while the instance was streamed
+	bool online[BP_NUM_HEURISTICS];
+	bool record_online;
+	bp_result online_results[BP_NUM_HEURISTICS];
+	std::vector<unsigned int> online_assignments[BP_NUM_HEURISTICS];
+
+	// Limits of every run, see bp_set_deadline()
+	run_control control;
+	double deadline;			///< Seconds per run; 0 if there is none
+
+	bp_context() : next_fit(1), max_rest(1)
+	{
+	}
+};
+
+/*!
+	Cancellation token that may be shared by several contexts.
+*/
+
+struct bp_cancel_token
+{
+	std::atomic<bool> cancelled;
+};
+
+/*!
+	Forgets everything about the instance that has been streamed, if
+	any.
+*/
+
+static void reset_online(bp_context* ctx)
+{
+	ctx->streaming = false;
+	for(int h = 0; h < BP_NUM_HEURISTICS; h++)
+	{
+		ctx->online[h] = false;
+		ctx->online_assignments[h].clear();
+	}
+}
+
+/*!
+	Creates a new context without an instance.
+
+	@return Pointer to the context, or NULL if no memory is available.
+*/
+
+bp_context* bp_context_create(void)
+{
+	bp_context* ctx = new(std::nothrow) bp_context;
+	if(ctx == NULL)
+		return(NULL);
+
+	ctx->p.objects	= NULL;
+	ctx->p.n	= 0;
+	ctx->p.K	= 0;
+	ctx->p.min_size	= 0;
+	ctx->p.max_size	= 0;
+	ctx->p.num_threads = 0;
+	ctx->p.ws	= &ctx->ws;
+	ctx->p.view	= &ctx->view;
+	ctx->p.control	= NULL;
+	ctx->deadline	= 0.0;
+
+	ctx->sum_size	  = 0;
+	ctx->has_instance = false;
+
+	ctx->vp.objects	= NULL;
+	ctx->vp.n	= 0;
+	ctx->vp.d	= 0;
+	ctx->vp.K	= NULL;
+	ctx->vp.ws	= &ctx->ws;
+
+	ctx->has_vector_instance = false;
+
+	reset_online(ctx);
+
+	return(ctx);
+}
+
+/*!
+	Releases a context and all of its memory.
+*/
+
+void bp_context_destroy(bp_context* ctx)
+{
+	delete ctx;
+}
+
+/*!
+	Sets the number of threads that parallel heuristics may use. The
+	threads are started for every run and stopped afterwards; the context
+	itself remains single-threaded.
+
+	@param ctx		Context
+	@param num_threads	Number of threads; 0 uses one thread per core
+
+	@return BP_OK or BP_ERROR_INVALID_ARGUMENT.
+*/
+
+int bp_set_num_threads(bp_context* ctx, unsigned int num_threads)
+{
+	if(ctx == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	ctx->p.num_threads = num_threads;
+	return(BP_OK);
+}
+
+/*!
+	Consults the run control only if a limit or a callback has been set,
+	so that the heuristics skip all checks otherwise.
+*/
+
+static void update_control(bp_context* ctx)
+{
+	const run_control& control = ctx->control;
+	if(control.cancelled != NULL || ctx->deadline > 0.0 || control.progress != NULL)
+		ctx->p.control = &ctx->control;
+	else
+		ctx->p.control = NULL;
+}
+
+/*!
+	Creates a cancellation token that has not been cancelled.
+
+	@return Pointer to the token, or NULL if no memory is available.
+*/
+
+bp_cancel_token* bp_cancel_token_create(void)
+{
+	bp_cancel_token* token = new(std::nothrow) bp_cancel_token;
+	if(token != NULL)
+		token->cancelled = false;
+
+	return(token);
+}
+
+/*!
+	Releases a cancellation token. It must not be used by any context
+	anymore.
+*/
+
+void bp_cancel_token_destroy(bp_cancel_token* token)
+{
+	delete token;
+}
+
+/*!
+	Cancels the current and all following runs of the contexts that use
+	the token, until the token is reset. May be called from any thread,
+	e.g. from a signal handler or a watchdog.
+*/
+
+void bp_cancel(bp_cancel_token* token)
+{
+	if(token != NULL)
+		token->cancelled.store(true, std::memory_order_relaxed);
+}
+
+/*!
+	Resets a cancellation token, so that runs are no longer cancelled.
+*/
+
+void bp_cancel_reset(bp_cancel_token* token)
+{
+	if(token != NULL)
+		token->cancelled.store(false, std::memory_order_relaxed);
+}
+
+/*!
+	Sets the cancellation token that bp_run() checks.
+
+	@param ctx	Context
+	@param token	Token, or NULL to remove it
+
+	@return BP_OK or BP_ERROR_INVALID_ARGUMENT.
+*/
+
+int bp_set_cancel_token(bp_context* ctx, bp_cancel_token* token)
+{
+	if(ctx == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	ctx->control.cancelled = token != NULL ? &token->cancelled : NULL;
+	update_control(ctx);
+
+	return(BP_OK);
+}
+
+/*!
+	Sets a wall-clock deadline for every subsequent run. The time is
+	counted from the start of bp_run(), including sorting, and checked
+	every few thousand items, so a run may take slightly longer.
+
+	@param ctx	Context
+	@param seconds	Time per run; 0 removes the deadline
+
+	@return BP_OK or BP_ERROR_INVALID_ARGUMENT.
+*/
+
+int bp_set_deadline(bp_context* ctx, double seconds)
+{
+	if(ctx == NULL || !(seconds >= 0.0))
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	ctx->deadline = seconds;
+	update_control(ctx);
+
+	return(BP_OK);
+}
+
+/*!
+	Sets a callback that bp_run() calls every few thousand items and once
+	more when the run ends. The callback runs on the thread of bp_run()
+	and should return quickly.
+
+	@param ctx		Context
+	@param callback		Callback, or NULL to remove it
+	@param data		Passed to the callback
+
+	@return BP_OK or BP_ERROR_INVALID_ARGUMENT.
+*/
+
+int bp_set_progress_callback(bp_context* ctx, bp_progress_callback callback, void* data)
+{
+	if(ctx == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	ctx->control.progress = callback;
+	ctx->control.data     = data;
+	update_control(ctx);
+
+	return(BP_OK);
+}
+
+/*!
+	Sets the instance that subsequent calls of bp_run() will pack. The
+	items are not copied; the array has to stay valid and unchanged until
+	another instance is set or the context is destroyed.
+
+	@param ctx		Context
+	@param items		Array of item sizes
+	@param n		Number of items
+	@param capacity		Capacity of bins
+
+	@return BP_OK, BP_ERROR_INVALID_ARGUMENT or BP_ERROR_ITEM_TOO_LARGE.
+*/
+
+int bp_set_instance(bp_context* ctx, const unsigned int* items, size_t n, unsigned int capacity)
+{
+	if(ctx == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	ctx->has_instance = false;
+	ctx->view.reset();
+	reset_online(ctx);
+
+	if(items == NULL || n == 0 || n >= UINT_MAX || capacity == 0)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	trace_span span("set instance", "load");
+
+	unsigned int min_size = capacity;
+	unsigned int max_size = 0;
+	unsigned long long sum_size = 0;
+
+	for(size_t i = 0; i < n; i++)
+	{
+		if(items[i] > capacity)
+			return(BP_ERROR_ITEM_TOO_LARGE);
+
+		if(items[i] > max_size)
+			max_size = items[i];
+
+		if(items[i] < min_size)
+			min_size = items[i];
+
+		sum_size += items[i];
+	}
+
+	ctx->p.objects	= items;
+	ctx->p.n	= static_cast<unsigned int>(n);
+	ctx->p.K	= capacity;
+	ctx->p.min_size	= min_size;
+	ctx->p.max_size	= max_size;
+
+	ctx->sum_size	  = sum_size;
+	ctx->has_instance = true;
+
+	return(BP_OK);
+}
+
+/*!
+	Starts an instance whose items are passed in chunks while they are
+	read, so that reading and packing overlap. As the chunks arrive, the
+	items are counted for the sorted view, and the online heuristics
+	among the given ones pack them right away. After bp_end_instance(),
+	the context holds the instance as if bp_set_instance() had been
+	called, except that the online heuristics and the counting for the
+	Decreasing heuristics are already done.
+
+	Only BP_NEXT_FIT and BP_MAX_REST_PQ can run online. Their results are
+	returned by bp_run() without packing again; the reported time is the
+	time spent on them while streaming.
+
+	@param ctx		Context
+	@param capacity		Capacity of bins
+	@param online		Heuristics to run online; may be NULL
+	@param num_online	Number of heuristics
+	@param flags		BP_ONLINE_ASSIGNMENTS to keep the assignments of
+				the online heuristics, so that bp_run() can
+				report them
+
+	@return BP_OK or BP_ERROR_INVALID_ARGUMENT.
+*/
+
+int bp_begin_instance(	bp_context* ctx, unsigned int capacity,
+			const bp_heuristic* online, size_t num_online, int flags)
+{
+	if(ctx == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	ctx->has_instance = false;
+	ctx->view.reset();
+	reset_online(ctx);
+
+	if(capacity == 0 || (online == NULL && num_online > 0))
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	for(size_t i = 0; i < num_online; i++)
+	{
+		if(online[i] != BP_NEXT_FIT && online[i] != BP_MAX_REST_PQ)
+			return(BP_ERROR_INVALID_ARGUMENT);
+
+		ctx->online[online[i]] = true;
+	}
+
+	ctx->p.objects	= NULL;
+	ctx->p.n	= 0;
+	ctx->p.K	= capacity;
+	ctx->p.min_size	= capacity;
+	ctx->p.max_size	= 0;
+	ctx->sum_size	= 0;
+
+	ctx->streaming	   = true;
+	ctx->stream_status = BP_OK;
+	ctx->record_online = (flags & BP_ONLINE_ASSIGNMENTS) != 0;
+
+	try
+	{
+		ctx->histogram.clear();
+		if(capacity < max_histogram_range)
+			ctx->histogram.resize(static_cast<size_t>(capacity)+1, 0);
+	}
+	catch(std::bad_alloc&)
+	{
+		ctx->histogram.clear();
+	}
+
+	ctx->histogram_time = 0.0;
+	ctx->next_fit = online_next_fit(capacity);
+	ctx->max_rest = online_max_rest(capacity);
+
+	for(int h = 0; h < BP_NUM_HEURISTICS; h++)
+		ctx->online_results[h].time = 0.0;
+
+	return(BP_OK);
+}
+
+/*!
+	Passes the next chunk of items of a streamed instance. The items are
+	not copied: all chunks have to be consecutive parts of one array,
+	which has to stay valid like the array of bp_set_instance().
+
+	@param ctx	Context with a streamed instance
+	@param items	Items of the chunk; they directly follow the items of
+			the previous chunk
+	@param count	Number of items
+
+	@return BP_OK or an error code. After an error, the instance cannot
+	be completed.
+*/
+
+int bp_append_items(bp_context* ctx, const unsigned int* items, size_t count)
+{
+	if(ctx == NULL || !ctx->streaming || (items == NULL && count > 0))
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(ctx->stream_status != BP_OK)
+		return(ctx->stream_status);
+
+	problem& p = ctx->p;
+	if(p.objects == NULL)
+		p.objects = items;
+
+	if(items != p.objects+p.n || static_cast<size_t>(p.n)+count >= UINT_MAX)
+		return(ctx->stream_status = BP_ERROR_INVALID_ARGUMENT);
+
+	trace_span span("append items", "load");
+
+	// Properties and histogram
+	clock_t start = clock();
+
+	unsigned int* counts = ctx->histogram.empty() ? NULL : &ctx->histogram[0];
+	for(size_t i = 0; i < count; i++)
+	{
+		if(items[i] > p.K)
+			return(ctx->stream_status = BP_ERROR_ITEM_TOO_LARGE);
+
+		if(items[i] > p.max_size)
+			p.max_size = items[i];
+
+		if(items[i] < p.min_size)
+			p.min_size = items[i];
+
+		ctx->sum_size += items[i];
+
+		if(counts != NULL)
+			counts[items[i]]++;
+	}
+
+	clock_t end = clock();
+	ctx->histogram_time += (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+
+	// Online heuristics
+	try
+	{
+		const int online[] = { BP_NEXT_FIT, BP_MAX_REST_PQ };
+		for(size_t i = 0; i < sizeof(online)/sizeof(online[0]); i++)
+		{
+			int h = online[i];
+			if(!ctx->online[h])
+				continue;
+
+			unsigned int* positions = NULL;
+			if(ctx->record_online)
+			{
+				ctx->online_assignments[h].resize(static_cast<size_t>(p.n)+count);
+				positions = &ctx->online_assignments[h][p.n];
+			}
+
+			start = clock();
+			long long traced = trace_begin();
+			if(h == BP_NEXT_FIT)
+				ctx->next_fit.add(items, static_cast<unsigned int>(count), positions);
+			else
+				ctx->max_rest.add(items, static_cast<unsigned int>(count), positions);
+			end = clock();
+			trace_end(heuristics[h].name, "pack", traced);
+
+			ctx->online_results[h].time += (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+		}
+	}
+	catch(std::bad_alloc&)
+	{
+		return(ctx->stream_status = BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	p.n += static_cast<unsigned int>(count);
+	return(BP_OK);
+}
+
+/*!
+	Completes a streamed instance. Afterwards, the context holds the
+	instance and bp_run() may be called.
+
+	@return BP_OK or an error code; BP_ERROR_INVALID_ARGUMENT if no items
+	have been passed.
+*/
+
+int bp_end_instance(bp_context* ctx)
+{
+	if(ctx == NULL || !ctx->streaming)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	ctx->streaming = false;
+
+	if(ctx->stream_status != BP_OK || ctx->p.n == 0)
+	{
+		int status = ctx->stream_status != BP_OK ? ctx->stream_status : BP_ERROR_INVALID_ARGUMENT;
+		reset_online(ctx);
+
+		return(status);
+	}
+
+	const problem& p = ctx->p;
+
+	try
+	{
+		if(!ctx->histogram.empty() && p.max_size-p.min_size < max_histogram_range)
+			ctx->view.assign_histogram(p, &ctx->histogram[p.min_size], ctx->histogram_time);
+	}
+	catch(std::bad_alloc&)
+	{
+		ctx->view.reset();
+	}
+
+	ctx->histogram = std::vector<unsigned int>();
+
+	ctx->online_results[BP_NEXT_FIT].num_bins    = ctx->next_fit.num_bins();
+	ctx->online_results[BP_MAX_REST_PQ].num_bins = ctx->max_rest.num_bins();
+
+	ctx->has_instance = true;
+	return(BP_OK);
+}
+
+/*!
+	Retrieves the properties of the current instance.
+*/
+
+int bp_get_instance_info(const bp_context* ctx, bp_instance_info* info)
+{
+	if(ctx == NULL || info == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(!ctx->has_instance)
+		return(BP_ERROR_NO_INSTANCE);
+
+	info->n		= ctx->p.n;
+	info->capacity	= ctx->p.K;
+	info->min_size	= ctx->p.min_size;
+	info->max_size	= ctx->p.max_size;
+	info->sum_size	= ctx->sum_size;
+
+	return(BP_OK);
+}
+
+/*!
+	Runs a heuristic on the current instance.
+
+	@param ctx		Context with an instance
+	@param heuristic	Heuristic to run
+	@param assignment	Optional array of n entries that will contain the
+				bin of every item. Bins are numbered from 0 in the
+				order in which they were opened. May be NULL.
+	@param result		Will contain the number of bins and the time
+
+	@return BP_OK or an error code. If the run has been cancelled or its
+	deadline has passed, BP_ERROR_CANCELLED or BP_ERROR_DEADLINE is
+	returned together with a partial result: the bins of the items that
+	have been placed, and BP_UNASSIGNED for all other items. Only a
+	cancelled token is noticed by every heuristic, before it starts; the
+	"Next-Fit" heuristics run in linear time, and the parallel ones place
+	the items of different threads independently, so they do not check
+	the token and the deadline while packing.
+*/
+
+int bp_run(bp_context* ctx, bp_heuristic heuristic, unsigned int* assignment, bp_result* result)
+{
+	if(ctx == NULL || result == NULL || heuristic < 0 || heuristic >= BP_NUM_HEURISTICS)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(!ctx->has_instance)
+		return(BP_ERROR_NO_INSTANCE);
+
+	const heuristic_entry& entry = heuristics[heuristic];
+
+	// Heuristics that ran while the instance was streamed
+	if(ctx->online[heuristic] && (assignment == NULL || ctx->record_online))
+	{
+		*result = ctx->online_results[heuristic];
+		result->num_placed = ctx->p.n;
+
+		if(assignment != NULL)
+		{
+			const std::vector<unsigned int>& positions = ctx->online_assignments[heuristic];
+			std::copy(positions.begin(), positions.end(), assignment);
+		}
+
+		return(BP_OK);
+	}
+
+	const problem& p = ctx->p;
+	run_control& control = ctx->control;
+
+	control.start(p.n);
+	control.has_deadline = ctx->deadline > 0.0;
+	if(control.has_deadline)
+	{
+		control.deadline = std::chrono::steady_clock::now() +
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(ctx->deadline));
+	}
+
+	// A cancelled token stops all heuristics, including the ones that
+	// do not check it themselves
+	if(control.cancelled != NULL && control.cancelled->load(std::memory_order_relaxed))
+	{
+		result->num_bins   = 0;
+		result->num_placed = 0;
+		result->time	   = 0.0;
+
+		if(assignment != NULL)
+			std::fill(assignment, assignment+p.n, BP_UNASSIGNED);
+
+		return(BP_ERROR_CANCELLED);
+	}
+
+	trace_span span(entry.name, "heuristic");
+
+	try
+	{
+		// Some heuristics record positions unconditionally and always
+		// need somewhere to put them; the others skip all bookkeeping
+		// if no positions are requested. For the Decreasing heuristics,
+		// positions refer to the sorted view and have to be mapped back
+		// to the items.
+		unsigned int* positions = assignment;
+		if(assignment != NULL ? entry.decreasing : entry.needs_positions)
+			positions = ctx->ws.borrow<unsigned int>(WS_POSITIONS, p.n);
+
+		result->num_bins   = entry.f(p, positions, result->time);
+		result->num_placed = control.placed;
+
+		if(control.reason != STOP_NONE)
+		{
+			if(control.placed == 0)
+				result->num_bins = 0;
+
+			if(assignment != NULL)
+				std::fill(positions+control.placed, positions+p.n, BP_UNASSIGNED);
+		}
+
+		if(assignment != NULL && entry.decreasing)
+		{
+			const unsigned int* order = ctx->view.order(p);
+			for(unsigned int i = 0; i < p.n; i++)
+				assignment[order[i]] = positions[i];
+		}
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	if(control.progress != NULL)
+		control.progress(result->num_placed, result->num_bins, control.data);
+
+	switch(control.reason)
+	{
+		case STOP_CANCELLED:
+			return(BP_ERROR_CANCELLED);
+		case STOP_DEADLINE:
+			return(BP_ERROR_DEADLINE);
+		default:
+			return(BP_OK);
+	}
+}
+
+/*!
+	Convenience function that sets an instance and runs a heuristic on it.
+	The parameters are described at bp_set_instance() and bp_run().
+*/
+
+int bp_pack(	bp_context* ctx,
+		const unsigned int* items, size_t n, unsigned int capacity,
+		bp_heuristic heuristic,
+		unsigned int* assignment,
+		bp_result* result)
+{
+	int status = bp_set_instance(ctx, items, n, capacity);
+	if(status != BP_OK)
+		return(status);
+
+	return(bp_run(ctx, heuristic, assignment, result));
+}
+
+/*!
+	Computes a lower bound on the number of bins of the current instance
+	from the LP relaxation of Gilmore and Gomory, by column generation.
+	The pricing problem is a bounded knapsack over the histogram of the
+	item sizes, and the patterns of a First-Fit-Decreasing packing are
+	used as a warm start, so the bound is practical for small
+	capacities. It is never worse than ceil(sum/capacity).
+
+	Every step of the column generation improves a valid bound, so the
+	computation may stop at any time: when the LP has been solved, when
+	the time budget is exhausted, or as soon as the bound reaches the
+	target. A packing with at most target+1 bins is then known to be
+	within one bin of the optimum.
+
+	@param ctx		Context with an instance
+	@param budget		Wall-clock time for the bound, in seconds
+	@param target		Stop as soon as the bound reaches it; 0 to
+				stop only when the LP has been solved or when
+				the bound reaches the First-Fit-Decreasing
+				packing
+	@param bound		Will contain the bound
+
+	@return BP_OK or an error code.
+*/
+
+int bp_lower_bound(bp_context* ctx, double budget, unsigned int target, bp_bound* bound)
+{
+	if(ctx == NULL || bound == NULL || budget < 0.0)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(!ctx->has_instance)
+		return(BP_ERROR_NO_INSTANCE);
+
+	trace_span span("Gilmore-Gomory", "bound");
+
+	lp_bound b;
+	try
+	{
+		b = gilmore_gomory(ctx->p, budget, target);
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	bound->lower_bound  = b.lower_bound;
+	bound->simple_bound = b.simple_bound;
+	bound->upper_bound  = b.upper_bound;
+	bound->lp_value	    = b.lp_value;
+	bound->solved	    = b.solved;
+	bound->converged    = b.converged;
+	bound->columns	    = b.columns;
+	bound->time	    = b.time;
+
+	return(BP_OK);
+}
+
+/*!
+	@return Reference implementation of a heuristic: the straightforward
+	implementation whose bins an optimized one has to reproduce. Reference
+	implementations, and heuristics that pack differently on purpose, are
+	their own reference. Unknown heuristics are returned unchanged.
+*/
+
+bp_heuristic bp_reference_heuristic(bp_heuristic heuristic)
+{
+	if(heuristic < 0 || heuristic >= BP_NUM_HEURISTICS)
+		return(heuristic);
+
+	return(heuristics[heuristic].reference);
+}
+
+/*!
+	Runs a heuristic and its reference implementation on the current
+	instance and compares their packings. Both assignments are verified
+	first, starting with the reference. They are then replayed in the
+	order of placement, and every item has to go to a bin with the same
+	load in both. Bins of the same load are interchangeable, so
+	implementations that break ties differently are reported as
+	BP_MATCH_TIES rather than as a mismatch.
+
+	@param ctx		Context with an instance
+	@param heuristic	Heuristic to check
+	@param comparison	Will contain the outcome; the first item that
+				goes to a bin of another load is reported for
+				BP_MISMATCH_PLACEMENT and BP_MISMATCH_BINS
+
+	@return BP_OK or an error code of either run. A mismatch is not an
+	error; it is reported by the outcome.
+*/
+
+int bp_compare_heuristic(bp_context* ctx, bp_heuristic heuristic, bp_comparison* comparison)
+{
+	if(ctx == NULL || comparison == NULL || heuristic < 0 || heuristic >= BP_NUM_HEURISTICS)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(!ctx->has_instance)
+		return(BP_ERROR_NO_INSTANCE);
+
+	const problem& p = ctx->p;
+	const heuristic_entry& entry = heuristics[heuristic];
+
+	bp_comparison c;
+	c.reference	     = entry.reference;
+	c.outcome	     = BP_MATCH_IDENTICAL;
+	c.item		     = p.n;
+	c.reference_load     = 0;
+	c.variant_load	     = 0;
+	c.violation.kind     = BP_VIOLATION_NONE;
+
+	try
+	{
+		std::vector<unsigned int> reference(p.n);
+		std::vector<unsigned int> variant(p.n);
+
+		bp_result result;
+		int status = bp_run(ctx, entry.reference, &reference[0], &result);
+		if(status != BP_OK)
+			return(status);
+
+		c.reference_bins = result.num_bins;
+		c.reference_time = result.time;
+
+		status = bp_run(ctx, heuristic, &variant[0], &result);
+		if(status != BP_OK)
+			return(status);
+
+		c.variant_bins = result.num_bins;
+		c.variant_time = result.time;
+
+		// Both implementations may share a bug, so the reference is
+		// verified, too
+		status = bp_verify_assignment(p.objects, p.n, p.K, &reference[0], c.reference_bins, &c.violation);
+		if(status == BP_ERROR_INVALID_ASSIGNMENT)
+			c.outcome = BP_MISMATCH_INVALID_REFERENCE;
+		else if(status == BP_OK)
+		{
+			status = bp_verify_assignment(p.objects, p.n, p.K, &variant[0], c.variant_bins, &c.violation);
+			if(status == BP_ERROR_INVALID_ASSIGNMENT)
+				c.outcome = BP_MISMATCH_INVALID;
+		}
+
+		if(status != BP_OK && status != BP_ERROR_INVALID_ASSIGNMENT)
+			return(status);
+		else if(status == BP_OK)
+		{
+			// Both implementations of a heuristic place the items in
+			// the same order
+			const unsigned int* order = entry.decreasing ? ctx->view.order(p) : NULL;
+
+			switch(compare_assignments(	p.objects, p.n, order,
+							&reference[0], c.reference_bins,
+							&variant[0], c.variant_bins,
+							c.item, c.reference_load, c.variant_load))
+			{
+				case DIFFERENCE_NONE:
+					c.outcome = BP_MATCH_IDENTICAL;
+					break;
+				case DIFFERENCE_TIES:
+					c.outcome = BP_MATCH_TIES;
+					break;
+				case DIFFERENCE_PLACEMENT:
+					c.outcome = BP_MISMATCH_PLACEMENT;
+					break;
+				case DIFFERENCE_BINS:
+					c.outcome = BP_MISMATCH_BINS;
+					break;
+			}
+		}
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	*comparison = c;
+	return(BP_OK);
+}
+
+/*!
+	Converts the features of an instance for the interface.
+*/
+
+static void copy_features(const instance_features& f, bp_features* features)
+{
+	features->n	    = f.n;
+	features->capacity  = f.K;
+	features->distinct  = f.distinct;
+	features->sampled   = f.sampled;
+	features->mean	    = f.mean;
+	features->deviation = f.deviation;
+	features->skew	    = f.skew;
+	features->large	    = f.large;
+	features->fill	    = f.fill;
+	features->time	    = f.time;
+}
+
+/*!
+	Extracts the features of the current instance. This requires a
+	single pass over the items, or over their histogram if the instance
+	has been streamed.
+
+	@return BP_OK or an error code.
+*/
+
+int bp_get_features(bp_context* ctx, bp_features* features)
+{
+	if(ctx == NULL || features == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(!ctx->has_instance)
+		return(BP_ERROR_NO_INSTANCE);
+
+	try
+	{
+		copy_features(extract_features(ctx->p), features);
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	return(BP_OK);
+}
+
+/*!
+	Selects the heuristics that are predicted to open the fewest bins for
+	the current instance within a time budget. The features of the
+	instance are extracted, and a cost model that has been calibrated on
+	the instance families of generate-problem predicts the bins and the
+	running time of every heuristic it knows about. The selected
+	heuristics are not run.
+
+	@param ctx		Context with an instance
+	@param budget		Processor time for all selected heuristics, in
+				seconds; if no heuristic fits, the fastest one
+				is selected
+	@param selection	Will contain the predictions for all heuristics
+				the model knows about, best predicted quality
+				first, and whether they have been selected
+
+	@return BP_OK or an error code.
+*/
+
+int bp_select_heuristics(bp_context* ctx, double budget, bp_selection* selection)
+{
+	if(ctx == NULL || selection == NULL || !(budget > 0.0))
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(!ctx->has_instance)
+		return(BP_ERROR_NO_INSTANCE);
+
+	instance_features features;
+	try
+	{
+		features = extract_features(ctx->p);
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	::selection s = select_heuristics(features, budget);
+
+	copy_features(features, &selection->features);
+	selection->reference	      = s.reference;
+	selection->reference_capacity = s.reference_K;
+	selection->distance	      = s.distance;
+	selection->num_predictions    = num_candidates;
+
+	for(unsigned int i = 0; i < num_candidates; i++)
+	{
+		selection->predictions[i].heuristic = s.predictions[i].heuristic;
+		selection->predictions[i].time	    = s.predictions[i].time;
+		selection->predictions[i].ratio	    = s.predictions[i].ratio;
+		selection->predictions[i].decision  = s.predictions[i].decision;
+	}
+
+	return(BP_OK);
+}
+
+/*!
+	Heuristics that can pack an instance out of core. Variants of a
+	heuristic that only differ in their implementation are treated alike.
+*/
+
+enum external_heuristic
+{
+	EXTERNAL_NONE,
+	EXTERNAL_NEXT_FIT,
+	EXTERNAL_BEST_FIT,
+	EXTERNAL_NEXT_FIT_DECREASING,
+	EXTERNAL_FIRST_FIT_DECREASING
+};
+
+/*!
+	@return Out-of-core version of a heuristic, or EXTERNAL_NONE.
+*/
+
+static external_heuristic external_version(bp_heuristic heuristic)
+{
+	switch(heuristic)
+	{
+		case BP_NEXT_FIT:
+		case BP_NEXT_FIT_PARALLEL:
+			return(EXTERNAL_NEXT_FIT);
+		case BP_BEST_FIT:
+		case BP_BEST_FIT_HEAP:
+		case BP_BEST_FIT_LOOKUP:
+			return(EXTERNAL_BEST_FIT);
+		case BP_NEXT_FIT_DECREASING:
+			return(EXTERNAL_NEXT_FIT_DECREASING);
+		case BP_FIRST_FIT_DECREASING:
+		case BP_FIRST_FIT_DECREASING_VEC:
+		case BP_FIRST_FIT_DECREASING_MAP:
+			return(EXTERNAL_FIRST_FIT_DECREASING);
+		default:
+			return(EXTERNAL_NONE);
+	}
+}
+
+/*!
+	Number of items that are assigned at once; bounds the memory of an
+	assignment pass.
+*/
+
+static const size_t external_block = 1 << 16;
+
+/*!
+	State of an instance that is packed out of core.
+*/
+
+struct bp_external
+{
+	bp_external(unsigned int capacity, bool best_fit)
+		: packer(capacity, best_fit), capacity(capacity), best_fit(best_fit), status(BP_OK),
+		  histogram_time(0.0), next_fit_time(0.0), best_fit_time(0.0), assigning(false), num_assigned(0)
+	{
+	}
+
+	external_packer packer;
+	unsigned int capacity;
+	bool best_fit;			///< "Best-Fit" runs while items are appended
+	int status;			///< First error while appending
+
+	double histogram_time;
+	double next_fit_time;
+	double best_fit_time;
+
+	// Assignment pass, see bp_external_begin_assignment()
+	bool assigning;
+	unsigned long long num_assigned;	///< Items passed to bp_external_assign()
+	assignment_writer writer;
+	std::vector<unsigned int> positions;
+};
+
+/*!
+	Starts an instance that is packed out of core: its items are passed
+	in chunks and are not kept, so the instance may be much larger than
+	the memory. The memory of all heuristics depends on the capacity
+	instead of the number of items, which may exceed 32 bits.
+
+	"Next-Fit" and "Best-Fit" pack the items while they are appended;
+	"Next-Fit-Decreasing" and "First-Fit-Decreasing" pack the histogram of
+	all sizes afterwards. The other heuristics require all items at once
+	and are not available.
+
+	@param capacity		Capacity of bins; has to be smaller than 2^24
+	@param heuristics	Heuristics that will be run; only required for
+				"Best-Fit", which does not run otherwise
+	@param num_heuristics	Number of heuristics
+
+	@return Pointer to the state, or NULL if an argument is invalid or no
+	memory is available.
+*/
+
+bp_external* bp_external_create(unsigned int capacity, const bp_heuristic* heuristics, size_t num_heuristics)
+{
+	if(capacity == 0 || capacity >= max_histogram_range || (heuristics == NULL && num_heuristics > 0))
+		return(NULL);
+
+	bool best_fit = false;
+	for(size_t i = 0; i < num_heuristics; i++)
+	{
+		external_heuristic version = external_version(heuristics[i]);
+		if(version == EXTERNAL_NONE)
+			return(NULL);
+
+		best_fit = best_fit || (version == EXTERNAL_BEST_FIT);
+	}
+
+	try
+	{
+		return(new bp_external(capacity, best_fit));
+	}
+	catch(std::bad_alloc&)
+	{
+		return(NULL);
+	}
+}
+
+/*!
+	Releases the state of an instance packed out of core. An unfinished
+	assignment file is closed.
+*/
+
+void bp_external_destroy(bp_external* ext)
+{
+	delete ext;
+}
+
+/*!
+	Passes the next chunk of items. The items are not kept and may be
+	overwritten as soon as the function returns.
+
+	@return BP_OK or an error code. After an error, the instance cannot
+	be packed anymore.
+*/
+
+int bp_external_append(bp_external* ext, const unsigned int* items, size_t count)
+{
+	if(ext == NULL || (items == NULL && count > 0) || ext->assigning)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(ext->status != BP_OK)
+		return(ext->status);
+
+	// The maximum is computed without an early exit, so that the loop
+	// can be vectorized
+	unsigned int max_size = 0;
+	for(size_t i = 0; i < count; i++)
+		max_size = std::max(max_size, items[i]);
+
+	if(max_size > ext->capacity)
+		return(ext->status = BP_ERROR_ITEM_TOO_LARGE);
+
+	clock_t start = clock();
+	long long traced = trace_begin();
+	ext->packer.count(items, count);
+	clock_t end = clock();
+	trace_end("count", "sort", traced);
+	ext->histogram_time += (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+
+	start = clock();
+	traced = trace_begin();
+	ext->packer.add_next_fit(items, count);
+	end = clock();
+	trace_end("Next-Fit", "pack", traced);
+	ext->next_fit_time += (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+
+	if(ext->best_fit)
+	{
+		start = clock();
+		traced = trace_begin();
+		ext->packer.add_best_fit(items, count);
+		end = clock();
+		trace_end("Best-Fit", "pack", traced);
+		ext->best_fit_time += (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+	}
+
+	return(BP_OK);
+}
+
+/*!
+	Retrieves the properties of the items appended so far.
+*/
+
+int bp_external_get_info(const bp_external* ext, bp_external_info* info)
+{
+	if(ext == NULL || info == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	info->n			= ext->packer.num_objects();
+	info->capacity		= ext->capacity;
+	info->min_size		= ext->packer.min_size();
+	info->max_size		= ext->packer.max_size();
+	info->sum_size		= ext->packer.sum_size();
+	info->histogram_time	= ext->histogram_time;
+
+	return(BP_OK);
+}
+
+/*!
+	Reports the result of a heuristic on all items appended so far. For
+	the Decreasing heuristics, the time does not include counting.
+
+	@return BP_OK, BP_ERROR_NO_INSTANCE if no items have been appended,
+	or BP_ERROR_INVALID_ARGUMENT if the heuristic is not available.
+*/
+
+int bp_external_run(bp_external* ext, bp_heuristic heuristic, bp_external_result* result)
+{
+	if(ext == NULL || result == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(ext->status != BP_OK)
+		return(ext->status);
+
+	if(ext->packer.num_objects() == 0)
+		return(BP_ERROR_NO_INSTANCE);
+
+	trace_span span(bp_heuristic_name(heuristic) != NULL ? bp_heuristic_name(heuristic) : "unknown", "heuristic");
+
+	clock_t start = clock();
+	switch(external_version(heuristic))
+	{
+		case EXTERNAL_NEXT_FIT:
+			result->num_bins = ext->packer.next_fit();
+			result->time	 = ext->next_fit_time;
+			return(BP_OK);
+
+		case EXTERNAL_BEST_FIT:
+			if(!ext->best_fit)
+				return(BP_ERROR_INVALID_ARGUMENT);
+
+			result->num_bins = ext->packer.best_fit();
+			result->time	 = ext->best_fit_time;
+			return(BP_OK);
+
+		case EXTERNAL_NEXT_FIT_DECREASING:
+			try
+			{
+				result->num_bins = ext->packer.next_fit_decreasing();
+			}
+			catch(std::bad_alloc&)
+			{
+				return(BP_ERROR_OUT_OF_MEMORY);
+			}
+			break;
+
+		case EXTERNAL_FIRST_FIT_DECREASING:
+			try
+			{
+				result->num_bins = ext->packer.first_fit_decreasing();
+			}
+			catch(std::bad_alloc&)
+			{
+				return(BP_ERROR_OUT_OF_MEMORY);
+			}
+			break;
+
+		default:
+			return(BP_ERROR_INVALID_ARGUMENT);
+	}
+
+	clock_t end = clock();
+	result->time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+
+	return(BP_OK);
+}
+
+/*!
+	Starts a second pass over the items that writes the assignment of a
+	heuristic to a file, in the format of bp_write_assignment(). The
+	items have to be passed to bp_external_assign() again, in the same
+	order; they are assigned and written block by block.
+
+	Only "Next-Fit" and "Next-Fit-Decreasing" can assign items out of
+	core. The other heuristics would have to remember every bin, which
+	takes memory proportional to the number of items.
+
+	@param ext		Instance with all items appended
+	@param heuristic	BP_NEXT_FIT or BP_NEXT_FIT_DECREASING
+	@param path		Path of the assignment file
+	@param flags		BP_WRITE_MMAP to encode into a mapped file
+
+	@return BP_OK, BP_ERROR_IO, BP_ERROR_OUT_OF_MEMORY, or
+	BP_ERROR_INVALID_ARGUMENT if the heuristic cannot assign items out of
+	core or the number of bins does not fit into the assignment file.
+*/
+
+int bp_external_begin_assignment(bp_external* ext, bp_heuristic heuristic, const char* path, int flags)
+{
+	if(ext == NULL || path == NULL || ext->assigning)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(ext->status != BP_OK)
+		return(ext->status);
+
+	if(ext->packer.num_objects() == 0)
+		return(BP_ERROR_NO_INSTANCE);
+
+	external_heuristic version = external_version(heuristic);
+	if(version != EXTERNAL_NEXT_FIT && version != EXTERNAL_NEXT_FIT_DECREASING)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	try
+	{
+		bool decreasing = (version == EXTERNAL_NEXT_FIT_DECREASING);
+		unsigned long long num_bins = decreasing ? ext->packer.next_fit_decreasing() : ext->packer.next_fit();
+		if(num_bins > UINT_MAX)
+			return(BP_ERROR_INVALID_ARGUMENT);
+
+		ext->positions.resize(external_block);
+		ext->packer.begin_assignment(decreasing);
+
+		if(!ext->writer.open(path, ext->packer.num_objects(), static_cast<unsigned int>(num_bins), (flags & BP_WRITE_MMAP) != 0))
+			return(BP_ERROR_IO);
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	ext->assigning    = true;
+	ext->num_assigned = 0;
+	return(BP_OK);
+}
+
+/*!
+	Assigns the next chunk of items and writes their bins.
+
+	@return BP_OK, BP_ERROR_IO, BP_ERROR_ITEM_TOO_LARGE, or
+	BP_ERROR_INVALID_ARGUMENT if no assignment has been started or more
+	items than appended are passed. Nothing is assigned in the latter
+	case.
+*/
+
+int bp_external_assign(bp_external* ext, const unsigned int* items, size_t count)
+{
+	if(ext == NULL || !ext->assigning || (items == NULL && count > 0))
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(count > ext->packer.num_objects()-ext->num_assigned)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	for(size_t i = 0; i < count; i += external_block)
+	{
+		size_t block = std::min(external_block, count-i);
+		for(size_t j = 0; j < block; j++)
+			if(items[i+j] > ext->capacity)
+				return(BP_ERROR_ITEM_TOO_LARGE);
+
+		trace_span span("assign", "output");
+
+		ext->packer.assign(items+i, block, &ext->positions[0]);
+		ext->num_assigned += block;
+
+		if(!ext->writer.write(&ext->positions[0], block))
+			return(BP_ERROR_IO);
+	}
+
+	return(BP_OK);
+}
+
+/*!
+	Finishes the assignment file.
+
+	@return BP_OK, or BP_ERROR_IO if the file could not be written or not
+	all items have been assigned.
+*/
+
+int bp_external_end_assignment(bp_external* ext)
+{
+	if(ext == NULL || !ext->assigning)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	ext->assigning = false;
+	ext->positions = std::vector<unsigned int>();
+
+	return(ext->writer.close() ? BP_OK : BP_ERROR_IO);
+}
+
+/*!
+	State of items that several threads pack at once.
+*/
+
+struct bp_concurrent
+{
+	bp_concurrent(unsigned int capacity, unsigned int num_producers)
+		: packer(capacity, num_producers), capacity(capacity)
+	{
+	}
+
+	concurrent_packer packer;
+	unsigned int capacity;
+};
+
+/*!
+	Starts packing items that several threads produce at once. Every
+	thread acts as one producer and places its items immediately, into
+	bins that all producers share; no lock is taken. Items are placed
+	close to "Best-Fit", but the result depends on how the threads
+	interleave.
+
+	@param capacity		Capacity of bins
+	@param num_producers	Number of producers; at most one thread may
+				use a producer at a time
+
+	@return Pointer to the state, or NULL if an argument is invalid or no
+	memory is available.
+*/
+
+bp_concurrent* bp_concurrent_create(unsigned int capacity, unsigned int num_producers)
+{
+	if(capacity == 0 || num_producers == 0)
+		return(NULL);
+
+	try
+	{
+		return(new bp_concurrent(capacity, num_producers));
+	}
+	catch(std::bad_alloc&)
+	{
+		return(NULL);
+	}
+}
+
+/*!
+	Releases the state of concurrent packing. No producer may be adding
+	items anymore.
+*/
+
+void bp_concurrent_destroy(bp_concurrent* conc)
+{
+	delete conc;
+}
+
+/*!
+	Places items of a producer. Different producers may call the function
+	at the same time.
+
+	@param conc	State of concurrent packing
+	@param producer	Number of the producer, starting from 0
+	@param items	Items to place
+	@param count	Number of items
+	@param bins	Optional array that will contain the bin of every item
+
+	@return BP_OK, BP_ERROR_INVALID_ARGUMENT, BP_ERROR_ITEM_TOO_LARGE, or
+	BP_ERROR_OUT_OF_MEMORY. Items before the first one that is too large
+	have been placed.
+*/
+
+int bp_concurrent_add(bp_concurrent* conc, unsigned int producer, const unsigned int* items, size_t count, unsigned int* bins)
+{
+	if(conc == NULL || (items == NULL && count > 0) || producer >= conc->packer.num_producers())
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	size_t valid = 0;
+	while(valid < count && items[valid] <= conc->capacity)
+		valid++;
+
+	try
+	{
+		conc->packer.add(producer, items, valid, bins);
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	return(valid == count ? BP_OK : BP_ERROR_ITEM_TOO_LARGE);
+}
+
+/*!
+	Retrieves the number of bins and the counters of all producers. While
+	producers are adding items, the values may be slightly out of date.
+*/
+
+int bp_concurrent_get_stats(const bp_concurrent* conc, bp_concurrent_stats* stats)
+{
+	if(conc == NULL || stats == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	concurrent_counters counters = conc->packer.counters();
+
+	stats->num_bins		= conc->packer.num_bins();
+	stats->num_items	= counters.objects;
+	stats->sum_size		= counters.sum;
+	stats->hint_hits	= counters.hint_hits;
+	stats->pool_hits	= counters.pool_hits;
+	stats->cas_failures	= counters.retries;
+
+	return(BP_OK);
+}
+
+/*!
+	Sets the vector instance that subsequent calls of bp_run_vector() will
+	pack. The items are not copied; the array has to stay valid and
+	unchanged until another vector instance is set or the context is
+	destroyed. The capacities are copied.
+
+	@param ctx		Context
+	@param items		Demands of all items as structure of arrays: the
+				demand of item i in dimension k is items[k*n+i]
+	@param n		Number of items
+	@param d		Number of dimensions
+	@param capacity		Capacity of bins in every dimension
+
+	@return BP_OK, BP_ERROR_INVALID_ARGUMENT, BP_ERROR_ITEM_TOO_LARGE, or
+	BP_ERROR_OUT_OF_MEMORY.
+*/
+
+int bp_set_vector_instance(	bp_context* ctx,
+				const unsigned int* items, size_t n, unsigned int d,
+				const unsigned int* capacity)
+{
+	if(ctx == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	ctx->has_vector_instance = false;
+
+	if(items == NULL || capacity == NULL || n == 0 || n >= UINT_MAX || d == 0)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	for(unsigned int k = 0; k < d; k++)
+	{
+		if(capacity[k] == 0)
+			return(BP_ERROR_INVALID_ARGUMENT);
+
+		for(size_t i = 0; i < n; i++)
+		{
+			if(items[k*n+i] > capacity[k])
+				return(BP_ERROR_ITEM_TOO_LARGE);
+		}
+	}
+
+	try
+	{
+		ctx->vector_capacity.assign(capacity, capacity+d);
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	ctx->vp.objects	= items;
+	ctx->vp.n	= static_cast<unsigned int>(n);
+	ctx->vp.d	= d;
+	ctx->vp.K	= ctx->vector_capacity.data();
+
+	ctx->has_vector_instance = true;
+	return(BP_OK);
+}
+
+/*!
+	Runs a vector packing heuristic on the current vector instance.
+
+	@param ctx		Context with a vector instance
+	@param heuristic	Heuristic to run
+	@param assignment	Optional array of n entries that will contain the
+				bin of every item. May be NULL.
+	@param result		Will contain the number of bins and the time
+
+	@return BP_OK or an error code.
+*/
+
+int bp_run_vector(bp_context* ctx, bp_vector_heuristic heuristic, unsigned int* assignment, bp_result* result)
+{
+	if(ctx == NULL || result == NULL || heuristic < 0 || heuristic >= BP_NUM_VECTOR_HEURISTICS)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(!ctx->has_vector_instance)
+		return(BP_ERROR_NO_INSTANCE);
+
+	try
+	{
+		unsigned int* positions = assignment;
+		if(positions == NULL)
+			positions = ctx->ws.borrow<unsigned int>(WS_POSITIONS, ctx->vp.n);
+
+		trace_span span(vector_heuristics[heuristic].name, "heuristic");
+		result->num_bins   = vector_heuristics[heuristic].f(ctx->vp, positions, result->time);
+		result->num_placed = ctx->vp.n;
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	return(BP_OK);
+}
+
+/*!
+	Retrieves the time that was spent sorting the current instance for
+	the Decreasing heuristics. Sorting happens at most once per instance.
+
+	@return BP_OK, or BP_ERROR_NO_INSTANCE if the instance has not been
+	sorted.
+*/
+
+int bp_sorting_time(const bp_context* ctx, double* time)
+{
+	if(ctx == NULL || time == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(!ctx->has_instance || !ctx->view.available())
+		return(BP_ERROR_NO_INSTANCE);
+
+	*time = ctx->view.time();
+	return(BP_OK);
+}
+
+/*!
+	Retrieves statistics about the scratch memory of the context.
+*/
+
+int bp_get_memory_stats(const bp_context* ctx, bp_memory_stats* stats)
+{
+	if(ctx == NULL || stats == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	stats->num_requests	= ctx->ws.num_requests();
+	stats->num_allocations	= ctx->ws.num_allocations();
+	stats->bytes_reserved	= ctx->ws.bytes_reserved();
+
+	return(BP_OK);
+}
+
+/*!
+	A result cache. Unlike contexts, a cache may be shared by all threads.
+*/
+
+struct bp_cache
+{
+	bp_cache(const char* directory, size_t memory_limit)
+		: cache(directory, memory_limit)
+	{
+	}
+
+	result_cache cache;
+};
+
+/*!
+	Creates a result cache.
+
+	@param directory	Directory that keeps results across processes. It
+				is created if necessary. NULL keeps results only
+				in memory.
+	@param memory_limit	Maximum number of bytes of results kept in
+				memory; least recently used results are evicted
+				first. 0 disables the in-memory level.
+
+	@return Pointer to the cache, or NULL if no memory is available.
+*/
+
+bp_cache* bp_cache_create(const char* directory, size_t memory_limit)
+{
+	try
+	{
+		return(new bp_cache(directory, memory_limit));
+	}
+	catch(std::bad_alloc&)
+	{
+		return(NULL);
+	}
+}
+
+void bp_cache_destroy(bp_cache* cache)
+{
+	delete cache;
+}
+
+/*!
+	Computes the key of an instance from its raw representation, e.g. the
+	contents of a data file. Identical files map to identical keys, so the
+	key can be computed before the file has been parsed.
+*/
+
+void bp_cache_key_bytes(const void* data, size_t size, bp_cache_key* key)
+{
+	uint64_t hash[2];
+	hash_bytes(data, size, 0, hash);
+
+	key->hash[0] = hash[0];
+	key->hash[1] = hash[1];
+}
+
+/*!
+	Computes the key of an instance from its items and capacity.
+*/
+
+void bp_cache_key_items(const unsigned int* items, size_t n, unsigned int capacity, bp_cache_key* key)
+{
+	uint64_t hash[2];
+	hash_bytes(items, n*sizeof(unsigned int), (static_cast<uint64_t>(capacity) << 32) ^ n ^ 0x9E3779B97F4A7C15ull, hash);
+
+	key->hash[0] = hash[0];
+	key->hash[1] = hash[1];
+}
+
+/*!
+	Looks up the result of a heuristic for an instance.
+
+	@param cache		Cache
+	@param key		Key of the instance
+	@param heuristic	Heuristic
+	@param info		Optional; will contain the properties of the instance
+	@param result		Optional; will contain the number of bins and the
+				time the heuristic originally took
+	@param assignment	Optional array that will contain the bin of every
+				item. Results stored without an assignment do not
+				match if an assignment is requested.
+	@param capacity		Number of entries of the array
+
+	@return BP_OK, BP_ERROR_CACHE_MISS or BP_ERROR_INVALID_ARGUMENT.
+*/
+
+int bp_cache_lookup(	bp_cache* cache, const bp_cache_key* key, bp_heuristic heuristic,
+			bp_instance_info* info, bp_result* result,
+			unsigned int* assignment, size_t capacity)
+{
+	if(cache == NULL || key == NULL || heuristic < 0 || heuristic >= BP_NUM_HEURISTICS)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	trace_span span("cache lookup", "load");
+
+	uint64_t hash[2] = { key->hash[0], key->hash[1] };
+	cache_entry_header entry;
+
+	try
+	{
+		if(!cache->cache.lookup(hash, heuristic, entry, assignment, capacity))
+			return(BP_ERROR_CACHE_MISS);
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	if(info != NULL)
+	{
+		info->n		= entry.n;
+		info->capacity	= entry.K;
+		info->min_size	= entry.min_size;
+		info->max_size	= entry.max_size;
+		info->sum_size	= entry.sum_size;
+	}
+
+	if(result != NULL)
+	{
+		result->num_bins   = entry.num_bins;
+		result->time	   = entry.time;
+		result->num_placed = entry.n;
+	}
+
+	return(BP_OK);
+}
+
+/*!
+	Stores the result of a heuristic for an instance.
+
+	@param cache		Cache
+	@param key		Key of the instance
+	@param heuristic	Heuristic
+	@param info		Properties of the instance
+	@param result		Result of the heuristic; partial results are
+				rejected
+	@param assignment	Optional assignment of info->n items
+
+	@return BP_OK, BP_ERROR_INVALID_ARGUMENT, BP_ERROR_OUT_OF_MEMORY, or
+	BP_ERROR_IO if the result could not be written to disk. It is kept
+	in memory anyway.
+*/
+
+int bp_cache_store(	bp_cache* cache, const bp_cache_key* key, bp_heuristic heuristic,
+			const bp_instance_info* info, const bp_result* result,
+			const unsigned int* assignment)
+{
+	if(	cache == NULL || key == NULL || info == NULL || result == NULL ||
+		heuristic < 0 || heuristic >= BP_NUM_HEURISTICS || result->num_placed != info->n)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	trace_span span("cache store", "output");
+
+	cache_entry_header entry;
+	entry.magic		= cache_entry_magic;
+	entry.heuristic		= heuristic;
+	entry.key[0]		= key->hash[0];
+	entry.key[1]		= key->hash[1];
+	entry.n			= info->n;
+	entry.K			= info->capacity;
+	entry.min_size		= info->min_size;
+	entry.max_size		= info->max_size;
+	entry.sum_size		= info->sum_size;
+	entry.num_bins		= result->num_bins;
+	entry.has_assignment	= (assignment != NULL);
+	entry.time		= result->time;
+
+	try
+	{
+		if(!cache->cache.store(entry, assignment))
+			return(BP_ERROR_IO);
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	return(BP_OK);
+}
+
+/*!
+	Retrieves the statistics of a cache.
+*/
+
+int bp_cache_get_stats(const bp_cache* cache, bp_cache_stats* stats)
+{
+	if(cache == NULL || stats == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	stats->hits	 = cache->cache.hits();
+	stats->disk_hits = cache->cache.disk_hits();
+	stats->misses	 = cache->cache.misses();
+	stats->stores	 = cache->cache.stores();
+	stats->entries	 = cache->cache.entries();
+	stats->bytes	 = cache->cache.bytes();
+
+	return(BP_OK);
+}
+
+/*!
+	Starts or stops recording the timeline of all contexts and threads of
+	the process. The library marks loading, sorting, allocating and
+	zeroing scratch memory, the run of every heuristic and the packing
+	itself, and writing assignments. While tracing is disabled, marking a
+	phase costs a single load and branch. Spans that have been recorded
+	are kept when tracing is stopped; see bp_write_trace().
+
+	@param enabled Nonzero to start recording
+*/
+
+void bp_set_tracing(int enabled)
+{
+	trace_enable(enabled != 0);
+}
+
+/*!
+	Discards the timeline recorded so far.
+*/
+
+void bp_clear_trace(void)
+{
+	trace_clear();
+}
+
+/*!
+	Writes the timeline recorded so far as a Chrome trace, which can be
+	opened by chrome://tracing or by Perfetto.
+
+	@param path Path of the JSON file
+
+	@return BP_OK, BP_ERROR_INVALID_ARGUMENT or BP_ERROR_IO.
+*/
+
+int bp_write_trace(const char* path)
+{
+	if(path == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	return(trace_write(path) ? BP_OK : BP_ERROR_IO);
+}
+
+/*!
+	Starts a span of the timeline, e.g. for a phase of the application
+	that surrounds the calls of the library. Spans may nest, but they
+	have to end on the thread that started them.
+
+	@param span	Will contain the start of the span
+	@param name	Name of the span; has to stay valid until the trace
+			has been written
+	@param category	Phase of the span, e.g. "load" or "output"; same as
+			for the name
+*/
+
+void bp_span_begin(bp_span* span, const char* name, const char* category)
+{
+	if(span == NULL)
+		return;
+
+	span->name     = name;
+	span->category = category;
+	span->start    = (name != NULL && category != NULL) ? trace_begin() : -1;
+}
+
+/*!
+	Ends a span that has been started by bp_span_begin() and adds it to
+	the timeline, unless tracing was disabled when it started.
+*/
+
+void bp_span_end(const bp_span* span)
+{
+	if(span != NULL)
+		trace_end(span->name, span->category, span->start);
+}
+
+/*!
+	Names the row of the calling thread in the timeline.
+*/
+
+void bp_trace_thread_name(const char* name)
+{
+	if(name != NULL)
+		trace_thread_name(name);
+}
+
+/*!
+	@return Name of a heuristic, or NULL for an unknown heuristic.
+*/
+
+const char* bp_heuristic_name(bp_heuristic heuristic)
+{
+	if(heuristic < 0 || heuristic >= BP_NUM_HEURISTICS)
+		return(NULL);
+
+	return(heuristics[heuristic].name);
+}
+
+/*!
+	@return Name of a vector packing heuristic, or NULL for an unknown
+	heuristic.
+*/
+
+const char* bp_vector_heuristic_name(bp_vector_heuristic heuristic)
+{
+	if(heuristic < 0 || heuristic >= BP_NUM_VECTOR_HEURISTICS)
+		return(NULL);
+
+	return(vector_heuristics[heuristic].name);
+}
+
+/*!
+	@return 1 if the heuristic can pack an instance out of core, see
+	bp_external_create(), else 0.
+*/
+
+int bp_heuristic_is_external(bp_heuristic heuristic)
+{
+	return(external_version(heuristic) != EXTERNAL_NONE);
+}
+
+/*!
+	@return Description of a status code.
+*/
+
+const char* bp_strerror(int status)
+{
+	switch(status)
+	{
+		case BP_OK:
+			return("Success");
+		case BP_ERROR_INVALID_ARGUMENT:
+			return("Invalid argument");
+		case BP_ERROR_ITEM_TOO_LARGE:
+			return("Item exceeds bin capacity");
+		case BP_ERROR_NO_INSTANCE:
+			return("No instance");
+		case BP_ERROR_OUT_OF_MEMORY:
+			return("Out of memory");
+		case BP_ERROR_IO:
+			return("Input/output error");
+		case BP_ERROR_INVALID_ASSIGNMENT:
+			return("Invalid assignment");
+		case BP_ERROR_CACHE_MISS:
+			return("Not in cache");
+		case BP_ERROR_CANCELLED:
+			return("Cancelled");
+		case BP_ERROR_DEADLINE:
+			return("Deadline exceeded");
+	}
+
+	return("Unknown error");
+}
+
+/*!
+	Writes an assignment to a file in a compact binary format: the bin of
+	every item is stored as a zigzag-encoded varint of its difference to
+	the bin of the previous item.
+
+	@param path		Path of the file
+	@param assignment	Bin of every item
+	@param n		Number of items
+	@param num_bins		Number of bins
+	@param flags		BP_WRITE_MMAP to encode directly into a mapped
+				file rather than through a buffer
+
+	@return BP_OK, BP_ERROR_INVALID_ARGUMENT or BP_ERROR_IO.
+*/
+
+int bp_write_assignment(const char* path, const unsigned int* assignment, size_t n, unsigned int num_bins, int flags)
+{
+	if(path == NULL || (assignment == NULL && n > 0))
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	trace_span span("write assignment", "output");
+
+	assignment_writer writer;
+	if(!writer.open(path, n, num_bins, (flags & BP_WRITE_MMAP) != 0))
+		return(BP_ERROR_IO);
+
+	bool success = writer.write(assignment, n);
+	success = writer.close() && success;
+
+	return(success ? BP_OK : BP_ERROR_IO);
+}
+
+/*!
+	Reads an assignment that has been written by bp_write_assignment().
+
+	@param path		Path of the file
+	@param assignment	Array that will contain the bin of every item. If
+				NULL, only n and num_bins are read.
+	@param capacity		Number of entries of the array
+	@param n		Will contain the number of items
+	@param num_bins		Will contain the number of bins
+
+	@return BP_OK, BP_ERROR_INVALID_ARGUMENT if the array is too small,
+	or BP_ERROR_IO.
+*/
+
+int bp_read_assignment(const char* path, unsigned int* assignment, size_t capacity, size_t* n, unsigned int* num_bins)
+{
+	if(path == NULL || n == NULL || num_bins == NULL)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	trace_span span("read assignment", "load");
+
+	if(!read_assignment(path, NULL, 0, *n, *num_bins))
+		return(BP_ERROR_IO);
+
+	if(assignment == NULL)
+		return(BP_OK);
+
+	if(*n > capacity)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	return(read_assignment(path, assignment, capacity, *n, *num_bins) ? BP_OK : BP_ERROR_IO);
+}
+
+/*!
+	Checks an assignment in linear time: every item has to be assigned to
+	one of the bins, no bin may exceed the capacity, and no bin may be
+	empty.
+
+	@param items		Array of item sizes
+	@param n		Number of items
+	@param capacity		Capacity of bins
+	@param assignment	Bin of every item
+	@param num_bins		Number of bins
+	@param violation	Optional; will describe the first violation
+
+	@return BP_OK, BP_ERROR_INVALID_ASSIGNMENT, BP_ERROR_INVALID_ARGUMENT,
+	or BP_ERROR_OUT_OF_MEMORY.
+*/
+
+int bp_verify_assignment(	const unsigned int* items, size_t n, unsigned int capacity,
+				const unsigned int* assignment, unsigned int num_bins,
+				bp_violation* violation)
+{
+	if((items == NULL || assignment == NULL) && n > 0)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	trace_span span("verify assignment", "verify");
+
+	bp_violation v;
+	v.kind	    = BP_VIOLATION_NONE;
+	v.item	    = 0;
+	v.bin	    = 0;
+	v.load	    = 0;
+	v.dimension = 0;
+
+	try
+	{
+		switch(verify_assignment(items, n, capacity, assignment, num_bins, v.item, v.bin, v.load))
+		{
+			case VIOLATION_NONE:
+				break;
+			case VIOLATION_BIN_OUT_OF_RANGE:
+				v.kind = BP_VIOLATION_BIN_OUT_OF_RANGE;
+				break;
+			case VIOLATION_OVER_CAPACITY:
+				v.kind = BP_VIOLATION_OVER_CAPACITY;
+				break;
+			case VIOLATION_EMPTY_BIN:
+				v.kind = BP_VIOLATION_EMPTY_BIN;
+				break;
+		}
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	if(violation != NULL)
+		*violation = v;
+
+	return(v.kind == BP_VIOLATION_NONE ? BP_OK : BP_ERROR_INVALID_ASSIGNMENT);
+}
+
+/*!
+	Checks an assignment of a vector instance in O(n*d). The conditions
+	are the same as for bp_verify_assignment(), in every dimension.
+
+	@param items		Demands of all items as structure of arrays
+	@param n		Number of items
+	@param d		Number of dimensions
+	@param capacity		Capacity of bins in every dimension
+	@param assignment	Bin of every item
+	@param num_bins		Number of bins
+	@param violation	Optional; will describe the first violation
+
+	@return BP_OK, BP_ERROR_INVALID_ASSIGNMENT, BP_ERROR_INVALID_ARGUMENT,
+	or BP_ERROR_OUT_OF_MEMORY.
+*/
+
+int bp_verify_vector_assignment(	const unsigned int* items, size_t n, unsigned int d,
+					const unsigned int* capacity,
+					const unsigned int* assignment, unsigned int num_bins,
+					bp_violation* violation)
+{
+	if(((items == NULL || assignment == NULL) && n > 0) || capacity == NULL || d == 0 || n >= UINT_MAX)
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	vector_problem p;
+	p.objects = items;
+	p.n	  = static_cast<unsigned int>(n);
+	p.d	  = d;
+	p.K	  = capacity;
+	p.ws	  = NULL;
+
+	bp_violation v;
+	v.kind	    = BP_VIOLATION_NONE;
+	v.item	    = 0;
+	v.bin	    = 0;
+	v.load	    = 0;
+	v.dimension = 0;
+
+	try
+	{
+		switch(verify_vector_assignment(p, assignment, num_bins, v.item, v.bin, v.dimension, v.load))
+		{
+			case VIOLATION_NONE:
+				break;
+			case VIOLATION_BIN_OUT_OF_RANGE:
+				v.kind = BP_VIOLATION_BIN_OUT_OF_RANGE;
+				break;
+			case VIOLATION_OVER_CAPACITY:
+				v.kind = BP_VIOLATION_OVER_CAPACITY;
+				break;
+			case VIOLATION_EMPTY_BIN:
+				v.kind = BP_VIOLATION_EMPTY_BIN;
+				break;
+		}
+	}
+	catch(std::bad_alloc&)
+	{
+		return(BP_ERROR_OUT_OF_MEMORY);
+	}
+
+	if(violation != NULL)
+		*violation = v;
+
+	return(v.kind == BP_VIOLATION_NONE ? BP_OK : BP_ERROR_INVALID_ASSIGNMENT);
+}
+
+/*!
+	@return Name of the instruction set used for scanning bins.
+*/
+
+const char* bp_scan_isa(void)
+{
+	return(scan_isa());
+}
+
+/*!
+	@return 1 if the hot kernels have been instantiated for a capacity
+	that is known at compile time, else 0.
+*/
+
+int bp_capacity_is_fixed(unsigned int capacity)
+{
+	return(is_fixed_capacity(capacity) ? 1 : 0);
+}
@@ -0,0 +1,477 @@
+/*!
+	@file	bin-packing-api.h
+	@brief	Public C interface of the bin-packing library
+
+	The library packs a set of items into bins of a fixed capacity using
+	one of several heuristics. All state lives in a context that is
+	created by the caller; apart from the timeline of bp_set_tracing(),
+	the library has no global state, so different contexts may be used
+	concurrently by different threads. A single context must not be used
+	by more than one thread at a time; only bp_cancel() may be called
+	from any thread, in order to stop the runs of all contexts that use
+	a cancellation token. Items that several threads produce at once may
+	be packed into shared bins by bp_concurrent_add().
+
+	Typical usage:
+
+	@code
+	bp_context* ctx = bp_context_create();
+	bp_result result;
+
+	if(bp_pack(ctx, items, n, capacity, BP_FIRST_FIT_DECREASING_MAP, NULL, &result) == BP_OK)
+		printf("%u bins\n", result.num_bins);
+
+	bp_context_destroy(ctx);
+	@endcode
+
+	@author Bastian Rieck
+*/
+
+#ifndef BIN_PACKING_API_H
+#define BIN_PACKING_API_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+	Available heuristics. The values are stable and may be stored.
+*/
+
+typedef enum bp_heuristic
+{
+	BP_MAX_REST			= 0,	///< "Max-Rest", O(n^2)
+	BP_MAX_REST_PQ			= 1,	///< "Max-Rest" using a priority queue
+	BP_FIRST_FIT			= 2,	///< "First-Fit", O(n^2)
+	BP_FIRST_FIT_VEC		= 3,	///< "First-Fit" removing full bins
+	BP_FIRST_FIT_MAP		= 4,	///< "First-Fit" with per-size start bins
+	BP_FIRST_FIT_DECREASING		= 5,	///< "First-Fit-Decreasing", O(n^2)
+	BP_FIRST_FIT_DECREASING_VEC	= 6,	///< "First-Fit-Decreasing" removing full bins
+	BP_FIRST_FIT_DECREASING_MAP	= 7,	///< "First-Fit-Decreasing" with per-size start bins
+	BP_NEXT_FIT			= 8,	///< "Next-Fit", O(n)
+	BP_NEXT_FIT_DECREASING		= 9,	///< "Next-Fit-Decreasing"
+	BP_BEST_FIT			= 10,	///< "Best-Fit", O(n^2)
+	BP_BEST_FIT_HEAP		= 11,	///< "Best-Fit" using a heap
+	BP_BEST_FIT_LOOKUP		= 12,	///< "Best-Fit" using a lookup table, O(n*K)
+	BP_NEXT_FIT_PARALLEL		= 13,	///< "Next-Fit" on several threads
+	BP_FIRST_FIT_DECREASING_SHARDED	= 14,	///< "First-Fit-Decreasing" on shards, merged
+
+	BP_NUM_HEURISTICS
+} bp_heuristic;
+
+/*!
+	Heuristics for vector packing, where items and bins have d
+	dimensions. The values are stable and may be stored.
+*/
+
+typedef enum bp_vector_heuristic
+{
+	BP_VECTOR_FIRST_FIT		= 0,	///< "First-Fit", O(n^2*d)
+	BP_VECTOR_FIRST_FIT_DECREASING	= 1,	///< "First-Fit-Decreasing" by relative size
+	BP_VECTOR_BEST_FIT_DOT		= 2,	///< "Best-Fit" maximizing the dot product
+	BP_VECTOR_BEST_FIT_L2		= 3,	///< "Best-Fit" minimizing the L2 residual
+
+	BP_NUM_VECTOR_HEURISTICS
+} bp_vector_heuristic;
+
+/*!
+	Status codes returned by the functions of the library.
+*/
+
+enum
+{
+	BP_OK				= 0,
+	BP_ERROR_INVALID_ARGUMENT	= 1,	///< NULL pointer, unknown heuristic, n = 0 or K = 0
+	BP_ERROR_ITEM_TOO_LARGE		= 2,	///< An item exceeds the bin capacity
+	BP_ERROR_NO_INSTANCE		= 3,	///< No instance has been set for the context
+	BP_ERROR_OUT_OF_MEMORY		= 5,
+	BP_ERROR_IO			= 6,	///< Reading or writing a file failed
+	BP_ERROR_INVALID_ASSIGNMENT	= 7,	///< Verification of an assignment failed
+	BP_ERROR_CACHE_MISS		= 8,	///< The cache holds no matching result
+	BP_ERROR_CANCELLED		= 9,	///< The run has been cancelled; the result is partial
+	BP_ERROR_DEADLINE		= 10	///< The deadline has passed; the result is partial
+};
+
+/*!
+	Bin of the items that a run did not place because it stopped early.
+*/
+
+#define BP_UNASSIGNED 0xFFFFFFFFu
+
+/*!
+	Flags of bp_write_assignment().
+*/
+
+enum
+{
+	BP_WRITE_MMAP			= 1	///< Encode directly into a mapped file
+};
+
+/*!
+	Flags of bp_begin_instance().
+*/
+
+enum
+{
+	BP_ONLINE_ASSIGNMENTS		= 1	///< Keep the assignments of the online heuristics
+};
+
+/*!
+	Problems found by bp_verify_assignment().
+*/
+
+enum
+{
+	BP_VIOLATION_NONE		= 0,
+	BP_VIOLATION_BIN_OUT_OF_RANGE	= 1,	///< An item refers to a bin >= num_bins
+	BP_VIOLATION_OVER_CAPACITY	= 2,	///< The items of a bin exceed the capacity
+	BP_VIOLATION_EMPTY_BIN		= 3	///< A bin does not contain any item
+};
+
+/*!
+	Outcomes of bp_compare_heuristic(), from the least to the most severe.
+*/
+
+enum
+{
+	BP_MATCH_IDENTICAL		= 0,	///< Every item is in the same bin
+	BP_MATCH_TIES			= 1,	///< Items only go to other bins of the same load
+	BP_MISMATCH_PLACEMENT		= 2,	///< An item goes to a bin of another load
+	BP_MISMATCH_BINS		= 3,	///< The number of bins differs
+	BP_MISMATCH_INVALID		= 4,	///< The assignment of the variant is invalid
+	BP_MISMATCH_INVALID_REFERENCE	= 5	///< The assignment of the reference is invalid
+};
+
+/*!
+	Decisions of bp_select_heuristics() about a heuristic.
+*/
+
+enum
+{
+	BP_SELECTED			= 0,	///< Predicted to be among the best within the budget
+	BP_SKIPPED_BUDGET		= 1,	///< Predicted to exceed the rest of the budget
+	BP_SKIPPED_QUALITY		= 2,	///< Predicted to open more bins than a selected one
+	BP_SKIPPED_EQUIVALENT		= 3	///< Packs like a heuristic that is predicted to be faster
+};
+
+typedef struct bp_context bp_context;
+typedef struct bp_cache bp_cache;
+typedef struct bp_cancel_token bp_cancel_token;
+typedef struct bp_external bp_external;
+typedef struct bp_concurrent bp_concurrent;
+
+/*!
+	Reports the progress of a run: the number of items placed so far and
+	the number of bins opened for them.
+*/
+
+typedef void (*bp_progress_callback)(unsigned int placed, unsigned int num_bins, void* data);
+
+/*!
+	Result of running a heuristic.
+*/
+
+typedef struct bp_result
+{
+	unsigned int num_bins;		///< Number of bins opened by the heuristic
+	double time;			///< Processor time spent packing, in seconds
+	unsigned int num_placed;	///< Items placed; less than n if the run stopped early
+} bp_result;
+
+/*!
+	Properties of the instance of a context.
+*/
+
+typedef struct bp_instance_info
+{
+	unsigned int n;			///< Number of items
+	unsigned int capacity;		///< Capacity of bins
+	unsigned int min_size;		///< Size of smallest item
+	unsigned int max_size;		///< Size of largest item
+	unsigned long long sum_size;	///< Sum of all item sizes
+} bp_instance_info;
+
+/*!
+	Properties of an instance that is packed out of core.
+*/
+
+typedef struct bp_external_info
+{
+	unsigned long long n;		///< Number of items
+	unsigned int capacity;		///< Capacity of bins
+	unsigned int min_size;		///< Size of smallest item
+	unsigned int max_size;		///< Size of largest item
+	unsigned long long sum_size;	///< Sum of all item sizes
+	double histogram_time;		///< Processor time spent counting the items
+} bp_external_info;
+
+/*!
+	Result of a heuristic that has packed an instance out of core.
+*/
+
+typedef struct bp_external_result
+{
+	unsigned long long num_bins;	///< Number of bins opened by the heuristic
+	double time;			///< Processor time spent packing, in seconds
+} bp_external_result;
+
+/*!
+	Counters of concurrent packing, added up over all producers.
+*/
+
+typedef struct bp_concurrent_stats
+{
+	unsigned int num_bins;		///< Number of bins opened so far
+	unsigned long long num_items;	///< Items placed
+	unsigned long long sum_size;	///< Sum of their sizes
+	unsigned long long hint_hits;	///< Items placed into the bin of the previous item of their producer
+	unsigned long long pool_hits;	///< Items placed into another bin that was already open
+	unsigned long long cas_failures;	///< Claims that had to be retried because another producer was faster
+} bp_concurrent_stats;
+
+/*!
+	Features of the instance of a context, as used for selecting
+	heuristics.
+*/
+
+typedef struct bp_features
+{
+	unsigned int n;			///< Number of items
+	unsigned int capacity;		///< Capacity of bins
+	unsigned int distinct;		///< Number of distinct item sizes
+	int sampled;			///< Non-zero if distinct has been counted on a sample
+	double mean;			///< Mean item size, relative to the capacity
+	double deviation;		///< Standard deviation of the sizes, relative to the capacity
+	double skew;			///< Skewness of the sizes
+	double large;			///< Fraction of items larger than half the capacity
+	double fill;			///< Sum of all item sizes divided by the capacity
+	double time;			///< Processor time spent extracting the features
+} bp_features;
+
+/*!
+	Prediction of the cost model for a single heuristic.
+*/
+
+typedef struct bp_prediction
+{
+	bp_heuristic heuristic;
+	double time;			///< Predicted processor time, in seconds
+	double ratio;			///< Predicted number of bins divided by the sum/capacity
+	int decision;			///< BP_SELECTED or the reason for skipping the heuristic
+} bp_prediction;
+
+/*!
+	Heuristics selected for an instance, together with everything the
+	decision was based on.
+*/
+
+typedef struct bp_selection
+{
+	bp_features features;		///< Features of the instance
+	const char* reference;		///< Family of the closest calibration instance
+	unsigned int reference_capacity; ///< Capacity of the closest calibration instance
+	double distance;		///< Distance between the features of both
+	size_t num_predictions;
+	bp_prediction predictions[BP_NUM_HEURISTICS];	///< Best predicted quality first
+} bp_selection;
+
+/*!
+	Lower bound on the number of bins of an instance; see
+	bp_lower_bound().
+*/
+
+typedef struct bp_bound
+{
+	unsigned int lower_bound;	///< No packing of the instance uses fewer bins
+	unsigned int simple_bound;	///< ceil(sum/capacity), for comparison
+	unsigned int upper_bound;	///< Bins of the First-Fit-Decreasing packing used as warm start, or 0 if it has not run
+	double lp_value;		///< Lower bound on the LP relaxation; its value if converged
+	int solved;			///< Non-zero if column generation has run
+	int converged;			///< Non-zero if the LP relaxation has been solved
+	unsigned int columns;		///< Patterns generated by pricing
+	double time;			///< Wall-clock time spent, in seconds
+} bp_bound;
+
+/*!
+	Memory statistics of a context.
+*/
+
+typedef struct bp_memory_stats
+{
+	unsigned long num_requests;	///< Number of scratch buffers borrowed
+	unsigned long num_allocations;	///< Number of scratch buffers allocated
+	size_t bytes_reserved;		///< Size of all scratch buffers
+} bp_memory_stats;
+
+/*!
+	First problem found when verifying an assignment.
+*/
+
+typedef struct bp_violation
+{
+	int kind;			///< One of the BP_VIOLATION values
+	size_t item;			///< Offending item, for BP_VIOLATION_BIN_OUT_OF_RANGE
+	unsigned int bin;		///< Offending bin
+	unsigned long long load;	///< Load of the offending bin
+	unsigned int dimension;		///< Exceeded dimension of a vector instance
+} bp_violation;
+
+/*!
+	Comparison of an implementation of a heuristic with its reference
+	implementation; see bp_compare_heuristic().
+*/
+
+typedef struct bp_comparison
+{
+	bp_heuristic reference;		///< Reference implementation
+	int outcome;			///< One of the BP_MATCH and BP_MISMATCH values
+	unsigned int reference_bins;
+	unsigned int variant_bins;
+	size_t item;			///< First item that goes to a bin of another load, or n
+	unsigned long long reference_load;	///< Load of its bin in the reference, before the item
+	unsigned long long variant_load;	///< Load of its bin in the variant, before the item
+	bp_violation violation;		///< Problem of the invalid assignment, if any
+	double reference_time;
+	double variant_time;
+} bp_comparison;
+
+/*!
+	Identifies an instance in a result cache; see bp_cache_key_bytes() and
+	bp_cache_key_items().
+*/
+
+typedef struct bp_cache_key
+{
+	unsigned long long hash[2];
+} bp_cache_key;
+
+/*!
+	Statistics of a result cache.
+*/
+
+typedef struct bp_cache_stats
+{
+	unsigned long hits;		///< Lookups that found a result
+	unsigned long disk_hits;	///< Hits that had to be read from disk
+	unsigned long misses;		///< Lookups that did not find a result
+	unsigned long stores;		///< Results that have been stored
+	unsigned long entries;		///< Entries held in memory
+	size_t bytes;			///< Size of the entries held in memory
+} bp_cache_stats;
+
+/*!
+	Span of the timeline that the application marks itself, e.g. for
+	reading its input; see bp_span_begin().
+*/
+
+typedef struct bp_span
+{
+	const char* name;
+	const char* category;
+	long long start;		///< Negative if tracing was disabled at the start
+} bp_span;
+
+bp_context* bp_context_create(void);
+void bp_context_destroy(bp_context* ctx);
+
+int bp_set_num_threads(bp_context* ctx, unsigned int num_threads);
+int bp_set_instance(bp_context* ctx, const unsigned int* items, size_t n, unsigned int capacity);
+int bp_get_instance_info(const bp_context* ctx, bp_instance_info* info);
+
+bp_cancel_token* bp_cancel_token_create(void);
+void bp_cancel_token_destroy(bp_cancel_token* token);
+void bp_cancel(bp_cancel_token* token);
+void bp_cancel_reset(bp_cancel_token* token);
+
+int bp_set_cancel_token(bp_context* ctx, bp_cancel_token* token);
+int bp_set_deadline(bp_context* ctx, double seconds);
+int bp_set_progress_callback(bp_context* ctx, bp_progress_callback callback, void* data);
+
+int bp_begin_instance(	bp_context* ctx, unsigned int capacity,
+			const bp_heuristic* online, size_t num_online, int flags);
+int bp_append_items(bp_context* ctx, const unsigned int* items, size_t count);
+int bp_end_instance(bp_context* ctx);
+
+int bp_run(bp_context* ctx, bp_heuristic heuristic, unsigned int* assignment, bp_result* result);
+int bp_pack(	bp_context* ctx,
+		const unsigned int* items, size_t n, unsigned int capacity,
+		bp_heuristic heuristic,
+		unsigned int* assignment,
+		bp_result* result);
+
+int bp_get_features(bp_context* ctx, bp_features* features);
+int bp_select_heuristics(bp_context* ctx, double budget, bp_selection* selection);
+
+int bp_lower_bound(bp_context* ctx, double budget, unsigned int target, bp_bound* bound);
+
+bp_external* bp_external_create(unsigned int capacity, const bp_heuristic* heuristics, size_t num_heuristics);
+void bp_external_destroy(bp_external* ext);
+int bp_external_append(bp_external* ext, const unsigned int* items, size_t count);
+int bp_external_get_info(const bp_external* ext, bp_external_info* info);
+int bp_external_run(bp_external* ext, bp_heuristic heuristic, bp_external_result* result);
+int bp_external_begin_assignment(bp_external* ext, bp_heuristic heuristic, const char* path, int flags);
+int bp_external_assign(bp_external* ext, const unsigned int* items, size_t count);
+int bp_external_end_assignment(bp_external* ext);
+int bp_heuristic_is_external(bp_heuristic heuristic);
+
+bp_concurrent* bp_concurrent_create(unsigned int capacity, unsigned int num_producers);
+void bp_concurrent_destroy(bp_concurrent* conc);
+int bp_concurrent_add(bp_concurrent* conc, unsigned int producer, const unsigned int* items, size_t count, unsigned int* bins);
+int bp_concurrent_get_stats(const bp_concurrent* conc, bp_concurrent_stats* stats);
+
+int bp_set_vector_instance(	bp_context* ctx,
+				const unsigned int* items, size_t n, unsigned int d,
+				const unsigned int* capacity);
+int bp_run_vector(bp_context* ctx, bp_vector_heuristic heuristic, unsigned int* assignment, bp_result* result);
+
+int bp_sorting_time(const bp_context* ctx, double* time);
+int bp_get_memory_stats(const bp_context* ctx, bp_memory_stats* stats);
+
+int bp_write_assignment(const char* path, const unsigned int* assignment, size_t n, unsigned int num_bins, int flags);
+int bp_read_assignment(const char* path, unsigned int* assignment, size_t capacity, size_t* n, unsigned int* num_bins);
+int bp_verify_assignment(	const unsigned int* items, size_t n, unsigned int capacity,
+				const unsigned int* assignment, unsigned int num_bins,
+				bp_violation* violation);
+
+bp_heuristic bp_reference_heuristic(bp_heuristic heuristic);
+int bp_compare_heuristic(bp_context* ctx, bp_heuristic heuristic, bp_comparison* comparison);
+
+bp_cache* bp_cache_create(const char* directory, size_t memory_limit);
+void bp_cache_destroy(bp_cache* cache);
+
+void bp_cache_key_bytes(const void* data, size_t size, bp_cache_key* key);
+void bp_cache_key_items(const unsigned int* items, size_t n, unsigned int capacity, bp_cache_key* key);
+
+int bp_cache_lookup(	bp_cache* cache, const bp_cache_key* key, bp_heuristic heuristic,
+			bp_instance_info* info, bp_result* result,
+			unsigned int* assignment, size_t capacity);
+int bp_cache_store(	bp_cache* cache, const bp_cache_key* key, bp_heuristic heuristic,
+			const bp_instance_info* info, const bp_result* result,
+			const unsigned int* assignment);
+int bp_cache_get_stats(const bp_cache* cache, bp_cache_stats* stats);
+
+void bp_set_tracing(int enabled);
+void bp_clear_trace(void);
+int bp_write_trace(const char* path);
+void bp_span_begin(bp_span* span, const char* name, const char* category);
+void bp_span_end(const bp_span* span);
+void bp_trace_thread_name(const char* name);
+
+int bp_verify_vector_assignment(	const unsigned int* items, size_t n, unsigned int d,
+					const unsigned int* capacity,
+					const unsigned int* assignment, unsigned int num_bins,
+					bp_violation* violation);
+
+const char* bp_heuristic_name(bp_heuristic heuristic);
+const char* bp_vector_heuristic_name(bp_vector_heuristic heuristic);
+const char* bp_strerror(int status);
+const char* bp_scan_isa(void);
+int bp_capacity_is_fixed(unsigned int capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,6 +7,9 @@
 *	An implementation of some of the most common heuristics for the Bin-packing
 *	problem. The algorithms can be compared using demo data.
 *
+*	The heuristics are built as a library with a C interface (see
+*	bin-packing-api.h); this program is a thin client of that library.
+*
 *	<HR>
 *
 * 	Copyright 2010, Bastian Rieck. All rights reserved.
@@ -41,240 +44,1691 @@
 
 #include <iostream>
 #include <iomanip>
-#include <fstream>
-#include <cstring>
-#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include <getopt.h>
+#include <sys/resource.h>
 
-#include "bin-packing.h"
-#include "first-fit.h"
-#include "next-fit.h"
-#include "best-fit.h"
-#include "max-rest.h"
+#include "bin-packing-api.h"
+#include "instance-format.h"
 
 using namespace std;
 
-unsigned int n = 0;	///< Number of objects for current problem
-unsigned int K = 0;	///< Capacity of bins for current problem
-unsigned int min_size;	///< Size of smallest object for current problem
-unsigned int max_size;	///< Size of largest object for current problem
-unsigned int sum_size;	///< Sum of object sizes for current problem
+/*!
+	Instance read from STDIN. The raw input is kept, so that it can be
+	hashed for the result cache before it is parsed.
+*/
+
+struct instance
+{
+	string input;		///< Contents of STDIN
+	bool binary;		///< Input is a binary instance
+	size_t offset;		///< Offset of the first item in the input
+
+	unsigned int n;		///< Announced number of objects
+	unsigned int K;		///< Capacity of the bins
+
+	unsigned int* objects;	///< Parsed objects, or NULL if not parsed
+	bp_context* ctx;	///< Context holding the objects, if parsed
+	bp_instance_info info;	///< Properties of the instance
+
+	unsigned int num_threads; ///< Threads for parallel heuristics; 0 for all cores
+	double deadline;	///< Wall-clock seconds per heuristic; 0 for none
+	bp_cache* cache;	///< Result cache, or NULL
+	bp_cache_key key;	///< Key of the raw input
+
+	vector<int> cached;	///< Heuristics found in the cache while loading
+	vector<bp_result> results;
+	int missed;		///< Heuristic not found while loading, or -1
+	vector<unsigned int> assignment;
 
-unsigned int* objects;		///< Array that holds the object sizes
-unsigned int* positions;	///< Array that holds the object positions (not used for every heuristic)
+	bool pipelined;		///< Loaded by the pipeline
+	double load_time;	///< Wall-clock time of the pipeline
+	double read_time;	///< Time the reader was busy
+	double consume_time;	///< Time spent counting and packing online
+};
 
 /*!
-	Comparison function for unsigned integers that compares values in
-	decreasing order. This function is used as an argument to qsort.
+	Reads n and K, so that everything but the objects themselves is known
+	without parsing all of the input.
+*/
+
+bool parse_header(instance& in)
+{
+	const char* data = in.input.c_str();
 
-	@param a First unsigned int
-	@param b Second unsigned int
+	in.binary = (in.input.size() > 0 && static_cast<unsigned char>(data[0]) == (instance_magic & 0xFF));
+	if(in.binary)
+	{
+		instance_header header;
+		if(in.input.size() < sizeof(header))
+			return(false);
 
-	@return +1 if the first element is smaller than the second, 0 if they
-	are equal, -1 if the first element is bigger that the second one.
+		memcpy(&header, data, sizeof(header));
+		if(header.magic != instance_magic)
+			return(false);
+
+		in.n	  = header.n;
+		in.K	  = header.K;
+		in.offset = sizeof(header);
+	}
+	else
+	{
+		char* end;
+		in.n = strtoul(data, &end, 10);
+		in.K = strtoul(end, &end, 10);
+
+		in.offset = end-data;
+	}
+
+	return(in.n != 0 && in.K != 0);
+}
+
+/*!
+	Parses the objects of the instance and sets up a context for them. If
+	there are fewer objects than announced, only those are used.
+
+	@return BP_OK or an error code of bp_set_instance().
 */
 
-int compare_uints(const void* a, const void* b)
+int parse_objects(instance& in)
 {
-	unsigned int x = *(reinterpret_cast<const unsigned int*>(a));
-	unsigned int y = *(reinterpret_cast<const unsigned int*>(b));
+	bp_span span;
+	bp_span_begin(&span, "parse", "parse");
+
+	in.objects = new unsigned int[in.n];
 
-	if(x < y)
-		return( 1);
-	else if(x == y)
-		return( 0);
+	unsigned int i = 0;
+	if(in.binary)
+	{
+		i = min<size_t>(in.n, (in.input.size()-in.offset)/sizeof(unsigned int));
+		memcpy(in.objects, in.input.data()+in.offset, static_cast<size_t>(i)*sizeof(unsigned int));
+	}
 	else
-		return(-1);
+	{
+		const char* p = in.input.c_str()+in.offset;
+		char* end;
+
+		for(; i < in.n; i++, p = end)
+		{
+			in.objects[i] = strtoul(p, &end, 10);
+			if(end == p)
+				break;
+		}
+	}
+
+	bp_span_end(&span);
+
+	in.ctx = bp_context_create();
+	bp_set_num_threads(in.ctx, in.num_threads);
+
+	int status = bp_set_instance(in.ctx, in.objects, i, in.K);
+	if(status == BP_OK)
+		bp_get_instance_info(in.ctx, &in.info);
+
+	return(status);
 }
 
 /*!
-	Implementation of counting sort for unsigned integers. The numbers will
-	be sorted in decreasing order. The function has the same signature as
-	the qsort and heapsort methods for the standard C library, thus
-	allowing the routines to switch the sorting method.
+	Reads all of STDIN.
+*/
+
+void read_input(string& input)
+{
+	char buffer[1 << 16];
+	size_t r;
+
+	bp_span span;
+	bp_span_begin(&span, "read input", "load");
 
-	@param base	Pointer to objects array
-	@param nmemb	Unused
-	@param size	Unused; size is known by global variable n
-	@param compar	Unused
+	while((r = fread(buffer, 1, sizeof(buffer), stdin)) > 0)
+		input.append(buffer, r);
+
+	bp_span_end(&span);
+}
+
+/*!
+	Size of the blocks in which STDIN is read by the pipeline.
 */
 
-void csort(void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*))
+static const size_t block_size = 1 << 20;
+
+/*!
+	Objects [begin, begin+count) of the instance, which the reader has
+	parsed.
+*/
+
+struct chunk
 {
-	unsigned int range = max_size - min_size + 1;
-	unsigned int* count = new unsigned int[range];
+	size_t begin;
+	size_t count;
+};
 
-	memset(count, 0, range*sizeof(unsigned int));
+/*!
+	Bounded queue of parsed chunks between the reader and the thread that
+	consumes them. The reader blocks while the queue is full, so it never
+	runs more than a few chunks ahead.
+*/
 
-	unsigned int* objects = reinterpret_cast<unsigned int*>(base);
+class chunk_queue
+{
+	public:
+		chunk_queue(size_t capacity)
+			: capacity(capacity), closed(false)
+		{
+		}
 
-	for(unsigned int i = 0; i < n; i++)
-		count[objects[i] - min_size]++;
+		/*!
+			Adds a chunk; blocks while the queue is full.
+
+			@return Time spent waiting, in seconds.
+		*/
+
+		double push(const chunk& c)
+		{
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+			unique_lock<mutex> guard(lock);
+			not_full.wait(guard, [this] { return(chunks.size() < capacity); });
+			chunks.push_back(c);
+			not_empty.notify_one();
+
+			return(chrono::duration<double>(chrono::steady_clock::now()-start).count());
+		}
+
+		/*!
+			Signals that no more chunks will be added.
+		*/
+
+		void close()
+		{
+			lock_guard<mutex> guard(lock);
+			closed = true;
+			not_empty.notify_one();
+		}
+
+		/*!
+			Removes the next chunk; blocks while the queue is empty.
 
-	unsigned int z = 0;
-	for(unsigned int i = min_size; i <= max_size; i++)
+			@return false if the queue is empty and has been closed.
+		*/
+
+		bool pop(chunk& c)
+		{
+			unique_lock<mutex> guard(lock);
+			not_empty.wait(guard, [this] { return(!chunks.empty() || closed); });
+			if(chunks.empty())
+				return(false);
+
+			c = chunks.front();
+			chunks.pop_front();
+			not_full.notify_one();
+
+			return(true);
+		}
+
+	private:
+		size_t capacity;
+		bool closed;
+
+		mutex lock;
+		condition_variable not_full;
+		condition_variable not_empty;
+		deque<chunk> chunks;
+};
+
+/*!
+	Reads the objects from STDIN, block by block, into the objects of the
+	instance and passes every parsed block to the queue. Numbers that
+	span two blocks of a text instance are carried over to the next
+	block.
+
+	@param in		Instance; its objects array holds n objects
+	@param buffer		Input that has been read but not parsed yet
+	@param queue		Queue for the parsed chunks
+	@param waiting		Will contain the time spent waiting for the
+				consumer
+*/
+
+void read_objects(instance& in, string buffer, chunk_queue& queue, double& waiting)
+{
+	size_t count = 0;
+	bool eof = false;
+
+	waiting = 0.0;
+	bp_trace_thread_name("reader");
+
+	vector<char> block(block_size);
+	while(count < in.n)
 	{
-		for(unsigned int j = 0; j < count[i - min_size]; j++)
-			objects[n-1-z++] = i;
+		size_t begin = count;
+
+		bp_span span;
+		bp_span_begin(&span, "parse block", "parse");
+
+		if(in.binary)
+		{
+			// The buffer never holds more than a block, plus a
+			// partial object
+			size_t size  = min<size_t>(buffer.size(), static_cast<size_t>(in.n-count)*sizeof(unsigned int));
+			size_t whole = size/sizeof(unsigned int);
+
+			memcpy(in.objects+count, buffer.data(), whole*sizeof(unsigned int));
+			buffer.erase(0, whole*sizeof(unsigned int));
+			count += whole;
+		}
+		else
+		{
+			// Only numbers that are followed by a separator are
+			// complete, unless the input has ended
+			const char* p = buffer.c_str();
+			size_t limit = eof ? buffer.size() : buffer.find_last_of(" \t\r\n");
+			if(limit == string::npos)
+				limit = 0;
+
+			const char* end = p+limit;
+			while(count < in.n)
+			{
+				while(p < end && isspace(static_cast<unsigned char>(*p)))
+					p++;
+
+				if(p >= end)
+					break;
+
+				char* next;
+				in.objects[count] = strtoul(p, &next, 10);
+				if(next == p)
+				{
+					eof = true;
+					break;
+				}
+
+				p = next;
+				count++;
+			}
+
+			buffer.erase(0, p-buffer.c_str());
+		}
+
+		bp_span_end(&span);
+
+		if(count > begin)
+		{
+			chunk c = { begin, count-begin };
+			waiting += queue.push(c);
+		}
+
+		if(eof)
+			break;
+
+		bp_span_begin(&span, "read block", "load");
+
+		size_t r = fread(&block[0], 1, block.size(), stdin);
+		if(r == 0)
+			eof = true;
+		else
+			buffer.append(&block[0], r);
+
+		bp_span_end(&span);
+
+		// A binary instance without further input is complete
+		if(eof && in.binary)
+			break;
 	}
 
-	delete []count;
+	in.n = static_cast<unsigned int>(count);
+	queue.close();
 }
 
 /*!
-	Reads test data from STDIN. The test data is supposed to come from a
-	file that contains n in the first line, K in the second line, followed
-	by all volumes.
+	Loads an instance from STDIN in a pipeline: a reader thread parses the
+	objects block by block, while this thread counts them for the sorted
+	view and packs them with the online heuristics as they arrive. For
+	large inputs, reading and packing overlap, so that loading takes
+	about as long as the slower of both rather than their sum.
 
-	@return Pointer to an array that contains all objects. Memory is
-	allocated automatically and has to be freed by the programmer. If an
-	error occurs, a NULL pointer will be returned.
+	@param in		Will contain the instance
+	@param heuristics	Heuristics that will be run; the online ones
+				start packing while reading
+	@param need_assignment	Whether the online heuristics have to keep
+				their assignments
+
+	@return BP_OK or an error code.
 */
 
-unsigned int* load_data()
+int load_pipelined(instance& in, const vector<int>& heuristics, bool need_assignment)
 {
-	n = 0;
-	K = 0;
+	in.objects = NULL;
+	in.ctx	   = NULL;
+	in.missed  = -1;
 
-	cin >> n;
-	cin >> K;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
 
-	if(n == 0 || K == 0)
-		return(NULL);
+	// The header is parsed from the first block
+	vector<char> block(block_size);
+	in.input.assign(&block[0], fread(&block[0], 1, block.size(), stdin));
 
-	unsigned int i = 0;
-	unsigned int* objects = new unsigned int[n];
+	if(!parse_header(in))
+		return(BP_ERROR_INVALID_ARGUMENT);
 
-	min_size = K;
-	max_size = 0;
+	string rest = in.input.substr(in.offset);
+	in.input.clear();
 
-	while(cin >> objects[i++])
+	vector<bp_heuristic> online;
+	for(size_t i = 0; i < heuristics.size(); i++)
 	{
-		if(objects[i-1] > max_size)
-			max_size = objects[i-1];
+		if(heuristics[i] == BP_NEXT_FIT || heuristics[i] == BP_MAX_REST_PQ)
+			online.push_back(static_cast<bp_heuristic>(heuristics[i]));
+	}
 
-		if(objects[i-1] < min_size)
-			min_size = objects[i-1];
+	in.objects = new unsigned int[in.n];
+	in.ctx = bp_context_create();
+	bp_set_num_threads(in.ctx, in.num_threads);
 
-		sum_size += objects[i-1];	
+	int status = bp_begin_instance(	in.ctx, in.K, online.data(), online.size(),
+					need_assignment ? BP_ONLINE_ASSIGNMENTS : 0);
+	if(status != BP_OK)
+		return(status);
+
+	chunk_queue queue(16);
+	double waiting = 0.0;
+	thread reader(read_objects, ref(in), rest, ref(queue), ref(waiting));
+
+	// Keep consuming after an error, so that the reader never blocks
+	double busy = 0.0;
+	chunk c;
+	while(queue.pop(c))
+	{
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+
+		if(status == BP_OK)
+			status = bp_append_items(in.ctx, in.objects+c.begin, c.count);
+
+		busy += chrono::duration<double>(chrono::steady_clock::now()-begin).count();
+	}
+
+	reader.join();
+
+	if(status == BP_OK)
+		status = bp_end_instance(in.ctx);
+
+	if(status == BP_OK)
+		bp_get_instance_info(in.ctx, &in.info);
+
+	in.pipelined	= true;
+	in.load_time	= chrono::duration<double>(chrono::steady_clock::now()-start).count();
+	in.read_time	= in.load_time-waiting;
+	in.consume_time = busy;
+
+	return(status);
+}
+
+/*!
+	@return Key of the cached result of a heuristic. The sharded
+	First-Fit-Decreasing packs differently for every number of threads,
+	so the number of threads is part of its key.
+*/
+
+bp_cache_key cache_key(const instance& in, int heuristic)
+{
+	bp_cache_key key = in.key;
+	if(heuristic == BP_FIRST_FIT_DECREASING_SHARDED)
+	{
+		unsigned long long threads = in.num_threads ? in.num_threads : thread::hardware_concurrency();
+		key.hash[1] ^= 0x9E3779B97F4A7C15ull*(threads+1);
 	}
 
-	return(objects);
+	return(key);
+}
+
+/*!
+	Loads test data that has been read from STDIN. The test data is
+	supposed to come from a file that contains n in the first line, K in
+	the second line, followed by all volumes. Binary instances, as written
+	by generate-problem, are detected by their magic number.
+
+	If a cache is used, the raw input is hashed and looked up first. When
+	the results of all heuristics are cached and the objects themselves
+	are not required, the objects are not parsed at all.
+
+	@param in		Will contain the instance
+	@param heuristics	Heuristics that will be run
+	@param need_objects	Whether the objects are required anyway
+	@param need_assignment	Whether cached results need an assignment
+
+	@return BP_OK or an error code.
+*/
+
+int load_data(instance& in, const vector<int>& heuristics, bool need_objects, bool need_assignment)
+{
+	in.objects = NULL;
+	in.ctx	   = NULL;
+	in.missed  = -1;
+
+	if(!parse_header(in))
+		return(BP_ERROR_INVALID_ARGUMENT);
+
+	if(in.cache != NULL)
+	{
+		bp_cache_key_bytes(in.input.data(), in.input.size(), &in.key);
+
+		if(need_assignment)
+			in.assignment.resize(in.n);
+
+		// Stop at the first miss; the remaining heuristics are looked up
+		// when they are run
+		for(size_t i = 0; i < heuristics.size() && !need_objects; i++)
+		{
+			bp_result result;
+			bp_cache_key key = cache_key(in, heuristics[i]);
+			if(bp_cache_lookup(	in.cache, &key, static_cast<bp_heuristic>(heuristics[i]), &in.info, &result,
+						need_assignment ? in.assignment.data() : NULL, in.n) != BP_OK)
+			{
+				in.missed = heuristics[i];
+				break;
+			}
+
+			in.cached.push_back(heuristics[i]);
+			in.results.push_back(result);
+		}
+
+		if(!heuristics.empty() && in.cached.size() == heuristics.size())
+			return(BP_OK);
+	}
+
+	return(parse_objects(in));
 }
 
 /*!
 	Writes the results of running a given heuristic to the screen. The
 	output will be formatted.
 
+	@param info	Properties of the current problem
 	@param name	Name of the heuristic
 	@param num_bins Number of bins opened by heuristic
 	@param time	Running time of the heuristic
+	@param cached	Whether the result has been taken from the cache
 */
 
-void output_results(const char* name, unsigned int num_bins, double time)
+void output_results(const bp_instance_info& info, const char* name, unsigned int num_bins, double time, bool cached)
 {
-	cout << setw(30) << left << name << "";
+	cout << setw(34) << left << (string(name) + ":") << "";
 	cout << setw( 8) << right << num_bins << " bins, ";
-	cout << fixed << setprecision(2) << (100.0*(num_bins/(sum_size/static_cast<double>(K)))) << "% max. deviation, ";
-	cout << fixed << setprecision(4) << time << "s\n";
+	cout << fixed << setprecision(2) << (100.0*(num_bins/(info.sum_size/static_cast<double>(info.capacity)))) << "% max. deviation, ";
+	if(cached)
+		cout << "cached\n";
+	else
+		cout << fixed << setprecision(4) << time << "s\n";
+}
+
+/*!
+	Writes the partial result of a heuristic that has been stopped early.
+
+	@param info	Properties of the current problem
+	@param name	Name of the heuristic
+	@param result	Partial result
+	@param status	Reason why the heuristic has been stopped
+*/
+
+void output_partial_results(const bp_instance_info& info, const char* name, const bp_result& result, int status)
+{
+	cout << setw(34) << left << (string(name) + ":") << "";
+	cout << setw( 8) << right << result.num_bins << " bins, ";
+	cout << "stopped after " << result.num_placed << " of " << info.n << " objects (" << bp_strerror(status) << "), ";
+	cout << fixed << setprecision(4) << result.time << "s\n";
+}
+
+/*!
+	Determines what happens with the assignments computed by the
+	heuristics.
+*/
+
+struct assignment_options
+{
+	bool verify;		///< Verify every assignment
+	const char* path;	///< Write the assignment to this file, if set
+	bool map;		///< Write through a mapped file
+};
+
+/*!
+	Checks an assignment and reports the result.
+
+	@return true if the assignment is valid.
+*/
+
+bool output_verification(const unsigned int* objects, const bp_instance_info& info, const unsigned int* assignment, unsigned int num_bins)
+{
+	bp_violation violation;
+	int status = bp_verify_assignment(objects, info.n, info.capacity, assignment, num_bins, &violation);
+
+	cout << setw(34) << left << "" << "";
+	if(status == BP_OK)
+		cout << "assignment verified\n";
+	else if(status != BP_ERROR_INVALID_ASSIGNMENT)
+		cout << "verification failed: " << bp_strerror(status) << "\n";
+	else
+	{
+		switch(violation.kind)
+		{
+			case BP_VIOLATION_BIN_OUT_OF_RANGE:
+				cout << "INVALID: item " << violation.item << " is in bin " << violation.bin << "\n";
+				break;
+			case BP_VIOLATION_OVER_CAPACITY:
+				cout << "INVALID: bin " << violation.bin << " holds " << violation.load << "\n";
+				break;
+			case BP_VIOLATION_EMPTY_BIN:
+				cout << "INVALID: bin " << violation.bin << " is empty\n";
+				break;
+		}
+	}
+
+	return(status == BP_OK);
 }
 
 /*!
 	Runs a certain heuristic on the current test data and formats the
-	output.
+	output. Assignments are only computed if they are verified, written,
+	or cached, so that the heuristics may use their fastest code paths
+	otherwise.
+
+	Results are taken from the cache if possible. Cached assignments that
+	are verified are checked against the objects, so a stale or corrupt
+	cache cannot go unnoticed.
+
+	A heuristic that exceeds the deadline is stopped, and the bins it has
+	opened so far are reported.
 
-	Overloadeded versions of this function exist.
+	@param in		Current problem
+	@param heuristic	Heuristic to run
+	@param options		What to do with the assignment
 
-	@param name 	Name of the heuristic
-	@param f	Function pointer to heuristic
+	@return Number of bins, or 0 if the heuristic has failed or has been
+	stopped early.
 */
 
-void run(const char* name, unsigned int (*f)(const unsigned int*, unsigned int*, double&))
+unsigned int run(instance& in, bp_heuristic heuristic, const assignment_options& options)
 {
-	double time;
-	unsigned int num_bins = f(objects, positions, time);
+	bp_result result;
+	bool cached = false;
+
+	unsigned int* assignment = NULL;
+	if(options.verify || options.path != NULL || in.cache != NULL)
+	{
+		in.assignment.resize(in.n);
+		assignment = in.assignment.data();
+	}
+
+	bool need_assignment = options.verify || options.path != NULL;
+
+	// Results found while loading the data are used as they are, all
+	// others are looked up now
+	for(size_t i = 0; i < in.cached.size() && !cached; i++)
+	{
+		if(in.cached[i] == heuristic)
+		{
+			result = in.results[i];
+			cached = true;
+		}
+	}
+
+	if(!cached && in.cache != NULL && heuristic != in.missed)
+	{
+		bp_cache_key key = cache_key(in, heuristic);
+		cached = bp_cache_lookup(	in.cache, &key, heuristic, NULL, &result,
+						need_assignment ? assignment : NULL, in.n) == BP_OK;
+	}
 
-	output_results(name, num_bins, time);
+	if(!cached)
+	{
+		bp_set_deadline(in.ctx, in.deadline);
+
+		// Partial results are neither cached nor verified nor written
+		int status = bp_run(in.ctx, heuristic, assignment, &result);
+		if(status == BP_ERROR_CANCELLED || status == BP_ERROR_DEADLINE)
+		{
+			output_partial_results(in.info, bp_heuristic_name(heuristic), result, status);
+			return(0);
+		}
+		else if(status != BP_OK)
+		{
+			cerr << bp_heuristic_name(heuristic) << ": " << bp_strerror(status) << "\n";
+			return(0);
+		}
+
+		if(in.cache != NULL)
+		{
+			bp_cache_key key = cache_key(in, heuristic);
+			status = bp_cache_store(in.cache, &key, heuristic, &in.info, &result, assignment);
+			if(status != BP_OK)
+				cerr << "Cache: " << bp_strerror(status) << "\n";
+		}
+	}
+
+	bp_span span;
+	bp_span_begin(&span, "output", "output");
+
+	output_results(in.info, bp_heuristic_name(heuristic), result.num_bins, result.time, cached);
+
+	if(options.verify)
+		output_verification(in.objects, in.info, assignment, result.num_bins);
+
+	if(options.path != NULL)
+	{
+		int status = bp_write_assignment(options.path, assignment, in.info.n, result.num_bins, options.map ? BP_WRITE_MMAP : 0);
+		if(status != BP_OK)
+			cerr << options.path << ": " << bp_strerror(status) << "\n";
+	}
+
+	bp_span_end(&span);
+	return(result.num_bins);
 }
 
-void run(const char* name, unsigned int (*f)(const unsigned int*, double&))
+/*!
+	Writes the time required for sorting the current problem, if any
+	heuristic has required the objects to be sorted.
+
+	@param ctx Context holding the current problem, or NULL
+*/
+
+void output_sorting(bp_context* ctx)
 {
 	double time;
-	unsigned int num_bins = f(objects, time);
-	
-	output_results(name, num_bins, time);
+	if(ctx == NULL || bp_sorting_time(ctx, &time) != BP_OK)
+		return;
+
+	cout << setw(34) << left << "Sorting (shared):" << "";
+	cout << fixed << setprecision(4) << time << "s\n";
 }
 
-void run(const char* name, unsigned int (*f)(	const unsigned int*,
-						double&,
-						void(*)(void*, size_t, size_t, int (*)(const void*, const void*))),
-						void(*sort)(void*, size_t, size_t, int (*)(const void*, const void*)))
+/*!
+	Writes the lower bounds on the number of bins and how far the best
+	packing may be from the optimum.
+
+	@param bound	Lower bounds
+	@param best	Bins of the best packing, or 0 if there is none
+*/
+
+void output_bound(const bp_bound& bound, unsigned int best)
 {
-	double time;
-	unsigned int num_bins = f(objects, time, sort);
-	
-	output_results(name, num_bins, time);
+	cout << setw(34) << left << "Lower bound (sum/K):" << "";
+	cout << setw( 8) << right << bound.simple_bound << " bins\n";
+
+	cout << setw(34) << left << "Lower bound (Gilmore-Gomory):" << "";
+	cout << setw( 8) << right << bound.lower_bound << " bins, ";
+	if(!bound.solved)
+		cout << "LP not solved, ";
+	else if(bound.converged)
+		cout << "LP = " << fixed << setprecision(2) << bound.lp_value << " after " << bound.columns << " columns, ";
+	else
+		cout << "LP >= " << fixed << setprecision(2) << bound.lp_value << " after " << bound.columns << " columns, ";
+	cout << fixed << setprecision(4) << bound.time << "s\n";
+
+	if(best == 0)
+		return;
+
+	cout << setw(34) << left << "Best packing:" << "";
+	cout << setw( 8) << right << best << " bins, ";
+	if(best <= bound.lower_bound)
+		cout << "optimal\n";
+	else if(best == bound.lower_bound+1)
+		cout << "within one bin of the optimum\n";
+	else
+		cout << "at most " << best-bound.lower_bound << " bins above the optimum\n";
 }
 
 /*!
-	Runs all heuristics for the current problem, including any SLOW
-	implementations.
+	Selects the heuristics for the current problem automatically and
+	logs the features of the problem, the predictions of the cost model,
+	and the decision for every heuristic.
+
+	@param ctx		Context holding the current problem
+	@param budget		Time budget for all heuristics, in seconds
+	@param heuristics	Will contain the selected heuristics, the one
+				with the best predicted quality first
+
+	@return BP_OK or an error code.
 */
 
-void run_all()
+int select_heuristics(bp_context* ctx, double budget, vector<int>& heuristics)
 {
-	run("Max-Rest:", 			max_rest);
-	run("Max-Rest+:", 			max_rest_pq);
-	run("First-Fit:", 			first_fit);
-	run("First-Fit+:", 			first_fit_vec);
-	run("First-Fit++:",			first_fit_map);
-	run("First-Fit-Decreasing:", 		first_fit_decreasing);
-	run("First-Fit-Decreasing+ (HS):", 	first_fit_decreasing_vec, qsort);
-	run("First-Fit-Decreasing+ (CS):", 	first_fit_decreasing_vec, csort);
-	run("First-Fit-Decreasing++:", 		first_fit_decreasing_map, csort);
-	run("Next-Fit:", 			next_fit);
-	run("Next-Fit-Decreasing:", 		next_fit_decreasing, qsort);
-	run("Next-Fit-Decreasing+:", 		next_fit_decreasing, csort);
-	run("Best-Fit:", 			best_fit);
-	run("Best-Fit+:", 			best_fit_heap);
-	run("Best-Fit++:", 			best_fit_lookup);
+	static const char* decisions[] = { "selected", "skipped (budget)", "skipped (quality)", "skipped (equivalent)" };
+
+	bp_selection selection;
+	int status = bp_select_heuristics(ctx, budget, &selection);
+	if(status != BP_OK)
+		return(status);
+
+	const bp_features& features = selection.features;
+
+	cout	<< "Features:     " << features.distinct << (features.sampled ? " distinct sizes in a sample, " : " distinct sizes, ")
+		<< fixed << setprecision(4) << "mean " << features.mean << " K, "
+		<< "deviation " << features.deviation << " K, "
+		<< "skew " << setprecision(2) << features.skew << ", "
+		<< setprecision(2) << 100.0*features.large << "% larger than K/2, "
+		<< "sum/K " << features.fill << " (" << setprecision(4) << features.time << "s)\n"
+		<< "Cost model:   closest to " << selection.reference << ", K = " << selection.reference_capacity
+		<< " (distance " << selection.distance << "); budget " << budget << "s\n\n";
+
+	for(size_t i = 0; i < selection.num_predictions; i++)
+	{
+		const bp_prediction& prediction = selection.predictions[i];
+
+		cout << setw(34) << left << (string(bp_heuristic_name(prediction.heuristic)) + ":") << "";
+		cout << setw( 8) << right << static_cast<unsigned long long>(ceil(prediction.ratio*features.fill)) << " bins, ";
+		cout << fixed << setprecision(4) << prediction.time << "s predicted, " << decisions[prediction.decision] << "\n";
+
+		if(prediction.decision == BP_SELECTED)
+			heuristics.push_back(prediction.heuristic);
+	}
+
+	cout << "\n";
+	return(BP_OK);
 }
 
 /*!
-	Runs only the fastest heuristics for the current problem (default setting).
+	@return All heuristics, including any SLOW implementations.
 */
 
-void run_fastest()
+vector<int> all_heuristics()
 {
-	run("Max-Rest+:", 			max_rest_pq);
-	run("First-Fit++:",			first_fit_map);
-	run("First-Fit-Decreasing++:", 		first_fit_decreasing_map, csort);
-	run("Next-Fit:", 			next_fit);
-	run("Next-Fit-Decreasing+:", 		next_fit_decreasing, csort);
-	run("Best-Fit++:", 			best_fit_lookup);
+	vector<int> heuristics;
+	for(int h = 0; h < BP_NUM_HEURISTICS; h++)
+		heuristics.push_back(h);
+
+	return(heuristics);
 }
 
-int main(int argc, char* argv[])
+/*!
+	@return The fastest heuristics (default setting).
+*/
+
+vector<int> fastest_heuristics()
+{
+	vector<int> heuristics;
+	heuristics.push_back(BP_MAX_REST_PQ);
+	heuristics.push_back(BP_FIRST_FIT_MAP);
+	heuristics.push_back(BP_FIRST_FIT_DECREASING_MAP);
+	heuristics.push_back(BP_NEXT_FIT);
+	heuristics.push_back(BP_NEXT_FIT_DECREASING);
+	heuristics.push_back(BP_BEST_FIT_LOOKUP);
+
+	return(heuristics);
+}
+
+/*!
+	Reads an assignment file and checks it against the current problem.
+
+	@return 0 if the assignment is valid.
+*/
+
+int check_assignment(const instance& in, const char* path)
+{
+	const bp_instance_info& info = in.info;
+
+	size_t n;
+	unsigned int num_bins;
+
+	unsigned int* assignment = new unsigned int[info.n];
+	int status = bp_read_assignment(path, assignment, info.n, &n, &num_bins);
+
+	if(status == BP_OK && n != info.n)
+		status = BP_ERROR_INVALID_ARGUMENT;
+
+	if(status != BP_OK)
+	{
+		cerr << path << ": " << bp_strerror(status) << "\n";
+
+		delete[] assignment;
+		return(-1);
+	}
+
+	cout << setw(34) << left << (string(path) + ":") << "";
+	cout << setw( 8) << right << num_bins << " bins\n";
+
+	bool valid = output_verification(in.objects, info, assignment, num_bins);
+
+	delete[] assignment;
+	return(valid ? 0 : -1);
+}
+
+/*!
+	@return true if the input is a binary vector instance.
+*/
+
+bool is_vector_instance(const string& input)
+{
+	vector_instance_header header;
+	if(input.size() < sizeof(header))
+		return(false);
+
+	memcpy(&header, input.data(), sizeof(header));
+	return(header.magic == vector_instance_magic);
+}
+
+/*!
+	Parses a vector instance. The text format contains n, the capacities
+	of all d dimensions, and then the d demands of every item in turn; for
+	d = 1 this is the format of the data files. Binary vector instances
+	are already stored as structure of arrays. Missing demands are set to
+	zero.
+
+	@param input		Contents of STDIN
+	@param d		Number of dimensions of a text instance; will
+				contain the number of dimensions of a binary one
+	@param n		Will contain the number of objects
+	@param capacity		Will contain the capacities
+	@param objects		Will contain the demands as structure of arrays
+
+	@return true on success.
+*/
+
+bool parse_vector_instance(const string& input, unsigned int& d, unsigned int& n, vector<unsigned int>& capacity, vector<unsigned int>& objects)
 {
-	objects = load_data();
-	positions = new unsigned int[n];
+	if(is_vector_instance(input))
+	{
+		vector_instance_header header;
+		memcpy(&header, input.data(), sizeof(header));
+
+		n = header.n;
+		d = header.d;
+		if(n == 0 || d == 0)
+			return(false);
+
+		size_t available = (input.size()-sizeof(header))/sizeof(unsigned int);
+		if(available < d)
+			return(false);
+
+		const unsigned int* data = reinterpret_cast<const unsigned int*>(input.data()+sizeof(header));
+
+		capacity.assign(data, data+d);
+		objects.assign(static_cast<size_t>(n)*d, 0);
+
+		memcpy(objects.data(), data+d, min(objects.size(), available-d)*sizeof(unsigned int));
+		return(true);
+	}
+
+	const char* p = input.c_str();
+	char* end;
+
+	n = strtoul(p, &end, 10);
+	p = end;
+
+	if(n == 0)
+		return(false);
+
+	capacity.resize(d);
+	for(unsigned int k = 0; k < d; k++, p = end)
+		capacity[k] = strtoul(p, &end, 10);
+
+	objects.assign(static_cast<size_t>(n)*d, 0);
+	for(unsigned int i = 0; i < n; i++)
+	{
+		for(unsigned int k = 0; k < d; k++, p = end)
+			objects[k*static_cast<size_t>(n)+i] = strtoul(p, &end, 10);
+	}
+
+	return(true);
+}
+
+/*!
+	Packs a vector instance with one or all vector heuristics.
+
+	@param input		Contents of STDIN
+	@param d		Number of dimensions of a text instance
+	@param heuristic	Vector heuristic to run, or -1 for all
+	@param options		What to do with the assignment
+
+	@return 0 on success.
+*/
+
+int run_vector(const string& input, unsigned int d, int heuristic, const assignment_options& options)
+{
+	unsigned int n;
+	vector<unsigned int> capacity;
+	vector<unsigned int> objects;
+
+	bp_context* ctx = bp_context_create();
+
+	int status = BP_ERROR_INVALID_ARGUMENT;
+	if(parse_vector_instance(input, d, n, capacity, objects))
+		status = bp_set_vector_instance(ctx, objects.data(), n, d, capacity.data());
+
+	if(status != BP_OK)
+	{
+		cerr << "bin-packing: " << bp_strerror(status) << "\n";
+
+		bp_context_destroy(ctx);
+		return(-1);
+	}
+
+	// Every dimension on its own needs at least ceil(sum/K) bins
+	unsigned long long lower_bound = 1;
+	for(unsigned int k = 0; k < d; k++)
+	{
+		unsigned long long sum = 0;
+		for(unsigned int i = 0; i < n; i++)
+			sum += objects[k*static_cast<size_t>(n)+i];
+
+		lower_bound = max(lower_bound, (sum+capacity[k]-1)/capacity[k]);
+	}
 
 	cout 	<< "****************************************\n"
 		<< "* COMPARISON OF BIN-PACKING HEURISTICS *\n"
 		<< "****************************************\n\n"
 		<< "Objects:      " << n << "\n"
-		<< "Minimum size: " << min_size << "\n"
-		<< "Maximum size: " << max_size << "\n"
-		<< "Sum of sizes: " << sum_size << "\n"
-		<< "Bin capacity: " << K << "\n\n";
+		<< "Dimensions:   " << d << "\n"
+		<< "Bin capacity:";
+
+	for(unsigned int k = 0; k < d; k++)
+		cout << " " << capacity[k];
+
+	cout	<< "\n"
+		<< "Lower bound:  " << lower_bound << " bins\n"
+		<< "Scan kernels: " << bp_scan_isa() << "\n\n";
+
+	vector<unsigned int> assignment(n);
+	for(int h = 0; h < BP_NUM_VECTOR_HEURISTICS; h++)
+	{
+		if(heuristic != -1 && h != heuristic)
+			continue;
+
+		bp_vector_heuristic vh = static_cast<bp_vector_heuristic>(h);
+
+		bp_result result;
+		status = bp_run_vector(ctx, vh, assignment.data(), &result);
+		if(status != BP_OK)
+		{
+			cerr << bp_vector_heuristic_name(vh) << ": " << bp_strerror(status) << "\n";
+			continue;
+		}
+
+		cout << setw(34) << left << (string(bp_vector_heuristic_name(vh)) + ":") << "";
+		cout << setw( 8) << right << result.num_bins << " bins, ";
+		cout << fixed << setprecision(2) << (100.0*result.num_bins/lower_bound) << "% of lower bound, ";
+		cout << fixed << setprecision(4) << result.time << "s\n";
+
+		if(options.verify)
+		{
+			bp_violation violation;
+			status = bp_verify_vector_assignment(objects.data(), n, d, capacity.data(), assignment.data(), result.num_bins, &violation);
+
+			cout << setw(34) << left << "" << "";
+			if(status == BP_OK)
+				cout << "assignment verified\n";
+			else if(status == BP_ERROR_INVALID_ASSIGNMENT && violation.kind == BP_VIOLATION_OVER_CAPACITY)
+				cout << "INVALID: bin " << violation.bin << " holds " << violation.load << " in dimension " << violation.dimension << "\n";
+			else
+				cout << "INVALID: " << bp_strerror(status) << "\n";
+		}
+
+		if(options.path != NULL)
+		{
+			status = bp_write_assignment(options.path, assignment.data(), n, result.num_bins, options.map ? BP_WRITE_MMAP : 0);
+			if(status != BP_OK)
+				cerr << options.path << ": " << bp_strerror(status) << "\n";
+		}
+	}
+
+	bp_context_destroy(ctx);
+	return(0);
+}
+
+/*!
+	Reads the objects of an instance file chunk by chunk, so that the
+	instance never has to be in memory as a whole. Text instances, binary
+	instances, and binary instances with a 64 bit count are supported.
+*/
+
+class instance_file
+{
+	public:
+		instance_file()
+			: in(NULL), binary(false), offset(0), n(0), K(0), remaining(0)
+		{
+		}
+
+		~instance_file()
+		{
+			if(in != NULL)
+				fclose(in);
+		}
+
+		bool open(const char* path);
+		bool rewind();
+		size_t read(unsigned int* objects, size_t capacity);
+
+		unsigned long long num_objects() const	{ return(n); }
+		unsigned int capacity() const		{ return(K); }
+
+	private:
+		bool parse_number(unsigned long long& value);
+
+		FILE* in;
+		bool binary;
+		off_t offset;			///< Offset of the first object
+
+		unsigned long long n;		///< Announced number of objects
+		unsigned int K;			///< Capacity of the bins
+		unsigned long long remaining;	///< Objects not read yet
+};
+
+/*!
+	Parses the next decimal number of a text instance.
 
-	if(getopt(argc, argv, "a") == 'a')
-		run_all();
+	@return false at the end of the file or at anything but a number.
+*/
+
+bool instance_file::parse_number(unsigned long long& value)
+{
+	int c;
+	do
+		c = getc_unlocked(in);
+	while(c != EOF && isspace(c));
+
+	if(c == EOF || !isdigit(c))
+		return(false);
+
+	value = 0;
+	do
+	{
+		value = 10*value + (c-'0');
+		c = getc_unlocked(in);
+	}
+	while(c != EOF && isdigit(c));
+
+	return(true);
+}
+
+/*!
+	Opens an instance file and reads its header.
+
+	@return true if the file is an instance.
+*/
+
+bool instance_file::open(const char* path)
+{
+	in = fopen(path, "rb");
+	if(in == NULL)
+		return(false);
+
+	setvbuf(in, NULL, _IOFBF, block_size);
+
+	uint32_t magic = 0;
+	if(fread(&magic, sizeof(magic), 1, in) == 1 && magic == instance_magic)
+	{
+		instance_header header;
+		binary = (fseeko(in, 0, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, in) == 1);
+		n = header.n;
+		K = header.K;
+	}
+	else if(magic == large_instance_magic)
+	{
+		large_instance_header header;
+		binary = (fseeko(in, 0, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, in) == 1);
+		n = header.n;
+		K = header.K;
+	}
 	else
-		run_fastest();
+	{
+		unsigned long long capacity = 0;
+		if(fseeko(in, 0, SEEK_SET) != 0 || !parse_number(n) || !parse_number(capacity) || capacity > UINT_MAX)
+			return(false);
+
+		K = static_cast<unsigned int>(capacity);
+	}
+
+	offset = ftello(in);
+	remaining = n;
+
+	return(n != 0 && K != 0 && offset >= 0);
+}
+
+/*!
+	Starts reading the objects from the beginning again.
+*/
+
+bool instance_file::rewind()
+{
+	remaining = n;
+	return(fseeko(in, offset, SEEK_SET) == 0);
+}
+
+/*!
+	Reads the next chunk of objects. Objects that do not fit into 32 bits
+	are stored as UINT_MAX, which exceeds every capacity.
+
+	@return Number of objects read; 0 at the end of the instance. If the
+	file has fewer objects than announced, only those are read.
+*/
+
+size_t instance_file::read(unsigned int* objects, size_t capacity)
+{
+	bp_span span;
+	bp_span_begin(&span, "read block", "load");
+
+	size_t count = min<unsigned long long>(capacity, remaining);
+	if(binary)
+		count = fread(objects, sizeof(unsigned int), count, in);
+	else
+	{
+		unsigned long long value;
+		for(size_t i = 0; i < count; i++)
+		{
+			if(!parse_number(value))
+			{
+				count = i;
+				break;
+			}
+
+			objects[i] = value < UINT_MAX ? static_cast<unsigned int>(value) : UINT_MAX;
+		}
+	}
+
+	// Stop at the first short read
+	remaining = (count > 0) ? remaining-count : 0;
+
+	bp_span_end(&span);
+	return(count);
+}
+
+/*!
+	Packs an instance file out of core: the objects are read chunk by
+	chunk and passed to the library, so the memory does not depend on the
+	number of objects. Only the heuristics that need O(K) memory can run.
+	An assignment is written in a second pass over the file.
+
+	@param path		Instance file
+	@param heuristic	Heuristic to run, or -1 for all available ones
+	@param options		What to do with the assignment
+
+	@return 0 on success.
+*/
+
+int run_external(const char* path, int heuristic, const assignment_options& options)
+{
+	instance_file file;
+	if(!file.open(path))
+	{
+		cerr << "bin-packing: " << path << ": Not a readable instance\n";
+		return(-1);
+	}
+
+	vector<bp_heuristic> heuristics;
+	if(heuristic != -1)
+		heuristics.push_back(static_cast<bp_heuristic>(heuristic));
+	else
+	{
+		heuristics.push_back(BP_NEXT_FIT);
+		heuristics.push_back(BP_NEXT_FIT_DECREASING);
+		heuristics.push_back(BP_FIRST_FIT_DECREASING_MAP);
+		heuristics.push_back(BP_BEST_FIT_LOOKUP);
+	}
+
+	bp_external* ext = bp_external_create(file.capacity(), heuristics.data(), heuristics.size());
+	if(ext == NULL)
+	{
+		cerr << "bin-packing: Unable to pack out of core with capacity " << file.capacity() << "\n";
+		return(-1);
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	vector<unsigned int> objects(block_size);
+	size_t count;
+	int status = BP_OK;
+
+	while(status == BP_OK && (count = file.read(objects.data(), objects.size())) > 0)
+		status = bp_external_append(ext, objects.data(), count);
+
+	double read_time = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+	bp_external_info info;
+	bp_external_get_info(ext, &info);
+
+	if(status == BP_OK && info.n == 0)
+		status = BP_ERROR_NO_INSTANCE;
+
+	if(status != BP_OK)
+	{
+		cerr << "bin-packing: " << bp_strerror(status) << "\n";
+
+		bp_external_destroy(ext);
+		return(-1);
+	}
+
+	cout 	<< "****************************************\n"
+		<< "* COMPARISON OF BIN-PACKING HEURISTICS *\n"
+		<< "****************************************\n\n"
+		<< "Objects:      " << info.n << " (out of core)\n"
+		<< "Minimum size: " << info.min_size << "\n"
+		<< "Maximum size: " << info.max_size << "\n"
+		<< "Sum of sizes: " << info.sum_size << "\n"
+		<< "Bin capacity: " << info.capacity << "\n\n";
+
+	for(size_t i = 0; i < heuristics.size(); i++)
+	{
+		bp_external_result result;
+		status = bp_external_run(ext, heuristics[i], &result);
+		if(status != BP_OK)
+		{
+			cerr << bp_heuristic_name(heuristics[i]) << ": " << bp_strerror(status) << "\n";
+			continue;
+		}
+
+		cout << setw(34) << left << (string(bp_heuristic_name(heuristics[i])) + ":") << "";
+		cout << setw( 8) << right << result.num_bins << " bins, ";
+		cout << fixed << setprecision(2) << (100.0*(result.num_bins/(info.sum_size/static_cast<double>(info.capacity)))) << "% max. deviation, ";
+		cout << fixed << setprecision(4) << result.time << "s\n";
+	}
+
+	cout << setw(34) << left << "Counting (shared):" << "";
+	cout << fixed << setprecision(4) << info.histogram_time << "s\n";
+
+	if(options.path != NULL)
+	{
+		status = bp_external_begin_assignment(ext, heuristics[0], options.path, options.map ? BP_WRITE_MMAP : 0);
+		if(status == BP_OK && !file.rewind())
+			status = BP_ERROR_IO;
+
+		while(status == BP_OK && (count = file.read(objects.data(), objects.size())) > 0)
+			status = bp_external_assign(ext, objects.data(), count);
+
+		int end_status = bp_external_end_assignment(ext);
+		if(status == BP_OK)
+			status = end_status;
+
+		if(status != BP_OK)
+			cerr << options.path << ": " << bp_strerror(status) << "\n";
+	}
+
+	double total_time = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	cout	<< "\n"
+		<< "Reading:      " << fixed << setprecision(4) << read_time << "s, "
+				  << setprecision(1) << info.n/read_time/1e6 << " million objects/s\n"
+		<< "Total:        " << setprecision(4) << total_time << "s\n"
+		<< "Peak RSS:     " << usage.ru_maxrss << " KiB\n";
+
+	bp_external_destroy(ext);
+	return(status == BP_OK ? 0 : -1);
+}
+
+/*!
+	Writes the timeline of the run as a Chrome trace if it has been
+	traced.
+
+	@param path Path of the trace, or NULL if the run has not been traced
+*/
+
+void write_trace(const char* path)
+{
+	if(path == NULL)
+		return;
+
+	int status = bp_write_trace(path);
+	if(status != BP_OK)
+		cerr << path << ": " << bp_strerror(status) << "\n";
+}
+
+void usage()
+{
+	cerr	<< "Usage: bin-packing [-a | -h heuristic | -A budget] [-v] [-w file [-m]] [-c file] [-C directory] [-t threads]\n"
+		<< "                   [-d dims] [-p] [-T seconds] [-L seconds] [-J file] < instance\n"
+		<< "       bin-packing -X file [-h heuristic] [-w file [-m]] [-J file]\n\n"
+		<< "  -a           Run all heuristics, including slow ones\n"
+		<< "  -h number    Run a single heuristic\n"
+		<< "  -A budget    Run only the heuristics that are predicted to open the fewest\n"
+		<< "               bins within a budget of seconds, and log the decision\n"
+		<< "  -v           Verify the assignment of every heuristic\n"
+		<< "  -w file      Write the assignment of the heuristic (requires -h)\n"
+		<< "  -m           Write the assignment through a mapped file\n"
+		<< "  -c file      Verify an assignment file instead of running heuristics\n"
+		<< "  -C directory Cache results in a directory; cached instances are not parsed\n"
+		<< "  -t threads   Threads for parallel heuristics (default: one per core)\n"
+		<< "  -d dims      Read a text instance with dims dimensions per item and run\n"
+		<< "               the vector heuristics; binary vector instances are detected\n"
+		<< "  -p           Pack while reading: Next-Fit and Max-Rest+ run and the objects\n"
+		<< "               are counted for sorting as they are parsed\n"
+		<< "  -T seconds   Stop every heuristic after this wall-clock time and report\n"
+		<< "               the bins opened so far\n"
+		<< "  -L seconds   Compute the Gilmore-Gomory lower bound within this wall-clock\n"
+		<< "               time; with -A, further heuristics are skipped once the first\n"
+		<< "               one is known to be within one bin of the optimum\n"
+		<< "  -X file      Pack an instance file out of core with memory independent of\n"
+		<< "               its size: Next-Fit, Next-Fit-Decreasing, First-Fit-Decreasing\n"
+		<< "               and Best-Fit; -w writes the assignment of Next-Fit or\n"
+		<< "               Next-Fit-Decreasing in a second pass\n"
+		<< "  -J file      Trace loading, sorting, allocating, packing and output of\n"
+		<< "               every thread, and write the timeline as a Chrome trace\n";
+}
+
+int main(int argc, char* argv[])
+{
+	bool all      = false;
+	int heuristic = -1;
+	const char* check = NULL;
+	const char* cache_directory = NULL;
+	unsigned int num_threads = 0;
+	unsigned int dimensions = 0;
+	bool pipelined = false;
+	double deadline = 0.0;
+	const char* external = NULL;
+	double budget = 0.0;
+	double bound_budget = 0.0;
+	const char* trace_path = NULL;
+
+	assignment_options options;
+	options.verify	= false;
+	options.path	= NULL;
+	options.map	= false;
+
+	int c;
+	while((c = getopt(argc, argv, "ah:vw:mc:C:t:d:pT:X:A:L:J:")) != -1)
+	{
+		switch(c)
+		{
+			case 'a':
+				all = true;
+				break;
+			case 'h':
+				heuristic = atoi(optarg);
+				break;
+			case 'v':
+				options.verify = true;
+				break;
+			case 'w':
+				options.path = optarg;
+				break;
+			case 'm':
+				options.map = true;
+				break;
+			case 'c':
+				check = optarg;
+				break;
+			case 'C':
+				cache_directory = optarg;
+				break;
+			case 't':
+				num_threads = atoi(optarg);
+				break;
+			case 'd':
+				dimensions = atoi(optarg);
+				break;
+			case 'p':
+				pipelined = true;
+				break;
+			case 'T':
+				deadline = atof(optarg);
+				break;
+			case 'X':
+				external = optarg;
+				break;
+			case 'J':
+				trace_path = optarg;
+				break;
+			case 'L':
+				bound_budget = atof(optarg);
+				if(!(bound_budget > 0.0))
+				{
+					usage();
+					return(-1);
+				}
+				break;
+			case 'A':
+				budget = atof(optarg);
+				if(!(budget > 0.0))
+				{
+					usage();
+					return(-1);
+				}
+				break;
+			default:
+				usage();
+				return(-1);
+		}
+	}
+
+	// The pipeline parses the input while reading it, so neither the
+	// cache nor vector instances can be used with it. Deadlines cannot
+	// be negative. The automatic selection replaces choosing heuristics
+	// by hand.
+	if(	deadline < 0.0 || (pipelined && (cache_directory != NULL || dimensions > 0)) ||
+		(budget > 0.0 && (all || heuristic != -1 || check != NULL || external != NULL)) ||
+		(bound_budget > 0.0 && (check != NULL || external != NULL)))
+	{
+		usage();
+		return(-1);
+	}
+
+	if(trace_path != NULL)
+	{
+		bp_set_tracing(1);
+		bp_trace_thread_name("main");
+	}
+
+	// Out of core, the objects are never in memory, so they can neither
+	// be verified nor cached. Only Next-Fit and Next-Fit-Decreasing
+	// assign them.
+	if(external != NULL)
+	{
+		if(	(heuristic != -1 && !bp_heuristic_is_external(static_cast<bp_heuristic>(heuristic))) ||
+			(options.path != NULL && heuristic != BP_NEXT_FIT && heuristic != BP_NEXT_FIT_DECREASING) ||
+			options.verify || check != NULL || cache_directory != NULL || dimensions > 0 || pipelined)
+		{
+			usage();
+			return(-1);
+		}
+
+		int result = run_external(external, heuristic, options);
+		write_trace(trace_path);
+
+		return(result);
+	}
+
+	instance in;
+	in.pipelined = false;
+	if(!pipelined)
+		read_input(in.input);
+
+	if(dimensions > 0 || is_vector_instance(in.input))
+	{
+		if(	(heuristic != -1 && bp_vector_heuristic_name(static_cast<bp_vector_heuristic>(heuristic)) == NULL) ||
+			(options.path != NULL && heuristic == -1) ||
+			check != NULL || cache_directory != NULL || budget > 0.0 || bound_budget > 0.0)
+		{
+			usage();
+			return(-1);
+		}
+
+		int result = run_vector(in.input, dimensions, heuristic, options);
+		write_trace(trace_path);
+
+		return(result);
+	}
+
+	if(	(heuristic != -1 && bp_heuristic_name(static_cast<bp_heuristic>(heuristic)) == NULL) ||
+		(options.path != NULL && heuristic == -1))
+	{
+		usage();
+		return(-1);
+	}
+
+	// The automatic selection needs the objects, so they are loaded
+	// before any heuristic is chosen
+	vector<int> heuristics;
+	if(heuristic != -1)
+		heuristics.push_back(heuristic);
+	else if(all)
+		heuristics = all_heuristics();
+	else if(budget == 0.0)
+		heuristics = fastest_heuristics();
+
+	// A single run only needs to keep the results of this instance in
+	// memory
+	in.num_threads = num_threads;
+	in.deadline = deadline;
+	in.cache = NULL;
+	if(cache_directory != NULL)
+		in.cache = bp_cache_create(cache_directory, 64 << 20);
+
+	if(check != NULL)
+		heuristics.clear();
+
+	int status = pipelined	? load_pipelined(in, heuristics, options.verify || options.path != NULL)
+				: load_data(in, heuristics, options.verify || check != NULL || budget > 0.0 || bound_budget > 0.0, options.path != NULL);
+	if(status != BP_OK)
+	{
+		cerr << "bin-packing: " << bp_strerror(status) << "\n";
+		write_trace(trace_path);
+
+		bp_cache_destroy(in.cache);
+		bp_context_destroy(in.ctx);
+		delete[] in.objects;
+		return(-1);
+	}
+
+	if(check != NULL)
+	{
+		int result = check_assignment(in, check);
+		write_trace(trace_path);
+
+		bp_cache_destroy(in.cache);
+		bp_context_destroy(in.ctx);
+		delete[] in.objects;
+		return(result);
+	}
+
+	const bp_instance_info& info = in.info;
+
+	cout 	<< "****************************************\n"
+		<< "* COMPARISON OF BIN-PACKING HEURISTICS *\n"
+		<< "****************************************\n\n"
+		<< "Objects:      " << info.n << "\n"
+		<< "Minimum size: " << info.min_size << "\n"
+		<< "Maximum size: " << info.max_size << "\n"
+		<< "Sum of sizes: " << info.sum_size << "\n"
+		<< "Bin capacity: " << info.capacity << (bp_capacity_is_fixed(info.capacity) ? " (fixed)" : "") << "\n"
+		<< "Scan kernels: " << bp_scan_isa() << "\n\n";
+
+	if(budget > 0.0)
+	{
+		status = select_heuristics(in.ctx, budget, heuristics);
+		if(status != BP_OK)
+			cerr << "bin-packing: " << bp_strerror(status) << "\n";
+	}
+
+	// Bins of the best packing and, with -L, the lower bound
+	unsigned int best = 0;
+	bp_bound bound;
+	bool has_bound = false;
+
+	for(size_t i = 0; i < heuristics.size(); i++)
+	{
+		// Entries may disappear from the cache directory between
+		// loading and running
+		if(in.ctx == NULL && find(in.cached.begin(), in.cached.end(), heuristics[i]) == in.cached.end())
+		{
+			status = parse_objects(in);
+			if(status != BP_OK)
+			{
+				cerr << "bin-packing: " << bp_strerror(status) << "\n";
+				break;
+			}
+		}
+
+		// The automatic selection only looks for a good packing, so it
+		// stops once that is known to be within one bin of the optimum
+		if(has_bound && best > 0 && best <= bound.lower_bound+1)
+		{
+			cout << setw(34) << left << (string(bp_heuristic_name(static_cast<bp_heuristic>(heuristics[i]))) + ":") << "";
+			cout << "skipped, within one bin of the optimum already\n";
+			continue;
+		}
+
+		unsigned int num_bins = run(in, static_cast<bp_heuristic>(heuristics[i]), options);
+		if(num_bins > 0 && (best == 0 || num_bins < best))
+			best = num_bins;
+
+		if(bound_budget > 0.0 && budget > 0.0 && !has_bound && best > 0)
+		{
+			status = bp_lower_bound(in.ctx, bound_budget, best-1, &bound);
+			has_bound = (status == BP_OK);
+		}
+	}
+
+	output_sorting(in.ctx);
+
+	if(bound_budget > 0.0 && in.ctx != NULL)
+	{
+		if(!has_bound)
+		{
+			status = bp_lower_bound(in.ctx, bound_budget, best, &bound);
+			has_bound = (status == BP_OK);
+		}
+
+		if(has_bound)
+			output_bound(bound, best);
+		else
+			cerr << "bin-packing: " << bp_strerror(status) << "\n";
+	}
+
+	// Report the memory footprint; the workspace shows how often scratch
+	// buffers had to be allocated rather than reused
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	cout << "\n";
+	if(in.ctx != NULL)
+	{
+		bp_memory_stats stats;
+		bp_get_memory_stats(in.ctx, &stats);
+
+		cout	<< "Workspace:    " << stats.num_allocations << " allocations for "
+					  << stats.num_requests << " buffers, "
+					  << stats.bytes_reserved/1024 << " KiB reserved\n";
+	}
+	else
+		cout << "Workspace:    objects not parsed\n";
+
+	if(in.pipelined)
+	{
+		cout	<< "Pipeline:     " << fixed << setprecision(4) << in.load_time << "s for loading; reading "
+					  << in.read_time << "s, counting and online packing "
+					  << in.consume_time << "s\n";
+	}
+
+	if(in.cache != NULL)
+	{
+		bp_cache_stats stats;
+		bp_cache_get_stats(in.cache, &stats);
+
+		cout	<< "Cache:        " << stats.hits << " hits, "
+					  << stats.misses << " misses, "
+					  << stats.stores << " stored in " << cache_directory << "\n";
+	}
+
+	cout << "Peak RSS:     " << usage.ru_maxrss << " KiB\n";
+
+	write_trace(trace_path);
 
-	delete[] objects;
-	delete[] positions;
+	bp_cache_destroy(in.cache);
+	bp_context_destroy(in.ctx);
+	delete[] in.objects;
 }
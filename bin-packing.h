@@ -1,6 +1,6 @@
 /*!
 	@file 	bin-packing.h
-	@brief 	Shared prototypes and global variables
+	@brief 	Description of a problem that is shared by all heuristics
 
 	@author Bastian Rieck
 */
@@ -8,12 +8,29 @@
 #ifndef BIN_PACKING_H
 #define BIN_PACKING_H
 
-extern unsigned int n;
-extern unsigned int K;
-extern unsigned int min_size;
-extern unsigned int max_size;
+class workspace;
+class sorted_view;
+struct run_control;
 
-int compare_uints(const void*, const void*);
-void csort(void*, size_t, size_t, int (*)(const void*, const void*));
+/*!
+	Describes the current problem. Every heuristic receives the problem it
+	is supposed to solve, together with the scratch memory it may use, so
+	that no global state is required. Copying a problem is cheap; the
+	objects array is not owned by the problem.
+*/
+
+struct problem
+{
+	const unsigned int* objects;	///< Array that holds the object sizes
+	unsigned int n;			///< Number of objects
+	unsigned int K;			///< Capacity of bins
+	unsigned int min_size;		///< Size of smallest object
+	unsigned int max_size;		///< Size of largest object
+	unsigned int num_threads;	///< Threads the parallel heuristics may use
+
+	workspace* ws;			///< Scratch memory for the heuristics
+	sorted_view* view;		///< Shared sorted view of the objects
+	run_control* control;		///< Limits of the current run, or NULL
+};
 
 #endif
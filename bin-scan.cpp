@@ -0,0 +1,828 @@
+/*!
+	@file	bin-scan.cpp
+	@brief	Vectorized kernels that scan an array of bins
+
+	The O(n^2) heuristics spend nearly all of their time scanning the
+	array of open bins. This file contains scalar, AVX2 and AVX-512
+	versions of these scans for bins stored as 32 bit and 16 bit unsigned
+	integers; First-Fit additionally has kernels for 8 bit bins, which are
+	used for capacities below 255. Vector packing has a kernel that checks
+	the residual capacities of a block of bins in every dimension. The
+	fastest version supported by the CPU is chosen at runtime. Setting
+	the environment variable BIN_PACKING_ISA to "scalar", "avx2" or
+	"avx512" restricts the choice, e.g. for comparisons.
+
+	Every kernel returns the same index as the corresponding scalar loop,
+	i.e. ties are always broken in favour of the bin with smallest index.
+
+	@author Bastian Rieck
+*/
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define BIN_SCAN_X86
+#endif
+
+#include "bin-scan.h"
+
+/*!
+	Returns the index of the first bin whose fill level does not exceed
+	the required capacity, or count if there is no such bin.
+*/
+
+template<typename T> static unsigned int first_fit_scalar(const T* bins, unsigned int j, unsigned int count, unsigned int required_capacity)
+{
+	for(; j < count; j++)
+	{
+		if(bins[j] <= required_capacity)
+			return(j);
+	}
+
+	return(count);
+}
+
+/*!
+	Returns the index of the first bin whose fill level equals the given
+	value, or count if there is no such bin.
+*/
+
+template<typename T> static unsigned int find_scalar(const T* bins, unsigned int j, unsigned int count, unsigned int value)
+{
+	for(; j < count; j++)
+	{
+		if(bins[j] == value)
+			return(j);
+	}
+
+	return(count);
+}
+
+/*!
+	Returns the index of the fullest bin whose fill level does not exceed
+	the required capacity, or count if there is no such bin.
+*/
+
+template<typename T> static unsigned int best_fit_scalar(const T* bins, unsigned int count, unsigned int required_capacity)
+{
+	unsigned int best_bin = count;
+	for(unsigned int j = 0; j < count; j++)
+	{
+		if(bins[j] <= required_capacity && (best_bin == count || bins[j] > bins[best_bin]))
+			best_bin = j;
+	}
+
+	return(best_bin);
+}
+
+/*!
+	Returns the index of the emptiest bin, or count if there are no bins.
+*/
+
+template<typename T> static unsigned int max_rest_scalar(const T* bins, unsigned int count)
+{
+	unsigned int min_bin = count;
+	for(unsigned int j = 0; j < count; j++)
+	{
+		if(min_bin == count || bins[j] < bins[min_bin])
+			min_bin = j;
+	}
+
+	return(min_bin);
+}
+
+/*!
+	Returns the index of the first bin in [j, count) whose residual
+	capacity is at least the demand of an item in every dimension, or
+	count if there is no such bin. Residual capacities are stored as one
+	array of stride entries per dimension.
+*/
+
+static unsigned int first_fit_vector_scalar(	const unsigned int* residual, unsigned int stride, unsigned int d,
+						const unsigned int* item, unsigned int j, unsigned int count)
+{
+	for(; j < count; j++)
+	{
+		unsigned int k = 0;
+		while(k < d && residual[k*static_cast<size_t>(stride)+j] >= item[k])
+			k++;
+
+		if(k == d)
+			return(j);
+	}
+
+	return(count);
+}
+
+static unsigned int first_fit_scalar_32(const unsigned int* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(first_fit_scalar(bins, 0, count, required_capacity));
+}
+
+static unsigned int first_fit_scalar_16(const unsigned short* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(first_fit_scalar(bins, 0, count, required_capacity));
+}
+
+static unsigned int first_fit_scalar_8(const unsigned char* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(first_fit_scalar(bins, 0, count, required_capacity));
+}
+
+static unsigned int best_fit_scalar_32(const unsigned int* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(best_fit_scalar(bins, count, required_capacity));
+}
+
+static unsigned int best_fit_scalar_16(const unsigned short* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(best_fit_scalar(bins, count, required_capacity));
+}
+
+static unsigned int max_rest_scalar_32(const unsigned int* bins, unsigned int count)
+{
+	return(max_rest_scalar(bins, count));
+}
+
+static unsigned int max_rest_scalar_16(const unsigned short* bins, unsigned int count)
+{
+	return(max_rest_scalar(bins, count));
+}
+
+#ifdef BIN_SCAN_X86
+
+/*
+	AVX2 kernels. There are no unsigned comparisons in AVX2, so x <= r is
+	computed as min(x, r) == x. The "best" kernels map every bin that
+	fits to its fill level plus one and every other bin to zero, reduce
+	this to the maximum and then search for the first bin with that fill
+	level.
+*/
+
+__attribute__((target("avx2")))
+static unsigned int find_avx2_32(const unsigned int* bins, unsigned int count, unsigned int value)
+{
+	const __m256i v = _mm256_set1_epi32(value);
+
+	unsigned int j = 0;
+	for(; j+8 <= count; j += 8)
+	{
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins+j));
+		int mask  = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(b, v)));
+		if(mask)
+			return(j+__builtin_ctz(mask));
+	}
+
+	return(find_scalar(bins, j, count, value));
+}
+
+__attribute__((target("avx2")))
+static unsigned int find_avx2_16(const unsigned short* bins, unsigned int count, unsigned int value)
+{
+	const __m256i v = _mm256_set1_epi16(static_cast<short>(value));
+
+	unsigned int j = 0;
+	for(; j+16 <= count; j += 16)
+	{
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins+j));
+		int mask  = _mm256_movemask_epi8(_mm256_cmpeq_epi16(b, v));
+		if(mask)
+			return(j+__builtin_ctz(mask)/2);
+	}
+
+	return(find_scalar(bins, j, count, value));
+}
+
+__attribute__((target("avx2")))
+static unsigned int first_fit_avx2_32(const unsigned int* bins, unsigned int count, unsigned int required_capacity)
+{
+	const __m256i r = _mm256_set1_epi32(required_capacity);
+
+	unsigned int j = 0;
+	for(; j+8 <= count; j += 8)
+	{
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins+j));
+		__m256i f = _mm256_cmpeq_epi32(_mm256_min_epu32(b, r), b);
+		int mask  = _mm256_movemask_ps(_mm256_castsi256_ps(f));
+		if(mask)
+			return(j+__builtin_ctz(mask));
+	}
+
+	return(first_fit_scalar(bins, j, count, required_capacity));
+}
+
+__attribute__((target("avx2")))
+static unsigned int first_fit_avx2_16(const unsigned short* bins, unsigned int count, unsigned int required_capacity)
+{
+	const __m256i r = _mm256_set1_epi16(static_cast<short>(required_capacity));
+
+	unsigned int j = 0;
+	for(; j+16 <= count; j += 16)
+	{
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins+j));
+		__m256i f = _mm256_cmpeq_epi16(_mm256_min_epu16(b, r), b);
+		int mask  = _mm256_movemask_epi8(f);
+		if(mask)
+			return(j+__builtin_ctz(mask)/2);
+	}
+
+	return(first_fit_scalar(bins, j, count, required_capacity));
+}
+
+__attribute__((target("avx2")))
+static unsigned int first_fit_avx2_8(const unsigned char* bins, unsigned int count, unsigned int required_capacity)
+{
+	const __m256i r = _mm256_set1_epi8(static_cast<char>(required_capacity));
+
+	unsigned int j = 0;
+	for(; j+32 <= count; j += 32)
+	{
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins+j));
+		__m256i f = _mm256_cmpeq_epi8(_mm256_min_epu8(b, r), b);
+		int mask  = _mm256_movemask_epi8(f);
+		if(mask)
+			return(j+__builtin_ctz(mask));
+	}
+
+	return(first_fit_scalar(bins, j, count, required_capacity));
+}
+
+/*!
+	Checks eight bins at once. A dimension is only loaded while some bin
+	of the block may still fit.
+*/
+
+__attribute__((target("avx2")))
+static unsigned int first_fit_vector_avx2(	const unsigned int* residual, unsigned int stride, unsigned int d,
+						const unsigned int* item, unsigned int j, unsigned int count)
+{
+	for(; j+8 <= count; j += 8)
+	{
+		int mask = 0xFF;
+		for(unsigned int k = 0; k < d && mask; k++)
+		{
+			__m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(residual+k*static_cast<size_t>(stride)+j));
+			__m256i f = _mm256_cmpeq_epi32(_mm256_max_epu32(r, _mm256_set1_epi32(item[k])), r);
+			mask &= _mm256_movemask_ps(_mm256_castsi256_ps(f));
+		}
+
+		if(mask)
+			return(j+__builtin_ctz(mask));
+	}
+
+	return(first_fit_vector_scalar(residual, stride, d, item, j, count));
+}
+
+__attribute__((target("avx2")))
+static unsigned int best_fit_avx2_32(const unsigned int* bins, unsigned int count, unsigned int required_capacity)
+{
+	// Fill levels are stored plus 1 below, which wraps around for a bin
+	// filled to 2^32-1. Such a bin can only take objects of size 0.
+	if(required_capacity == 0xFFFFFFFFu)
+		return(best_fit_scalar(bins, count, required_capacity));
+
+	const __m256i r   = _mm256_set1_epi32(required_capacity);
+	const __m256i one = _mm256_set1_epi32(1);
+	__m256i best      = _mm256_setzero_si256();
+
+	unsigned int j = 0;
+	for(; j+8 <= count; j += 8)
+	{
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins+j));
+		__m256i f = _mm256_cmpeq_epi32(_mm256_min_epu32(b, r), b);
+		best      = _mm256_max_epu32(best, _mm256_and_si256(f, _mm256_add_epi32(b, one)));
+	}
+
+	unsigned int lanes[8];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), best);
+
+	unsigned int max_value = 0;
+	for(unsigned int l = 0; l < 8; l++)
+	{
+		if(lanes[l] > max_value)
+			max_value = lanes[l];
+	}
+
+	for(; j < count; j++)
+	{
+		if(bins[j] <= required_capacity && bins[j]+1 > max_value)
+			max_value = bins[j]+1;
+	}
+
+	if(max_value == 0)
+		return(count);
+
+	return(find_avx2_32(bins, count, max_value-1));
+}
+
+__attribute__((target("avx2")))
+static unsigned int best_fit_avx2_16(const unsigned short* bins, unsigned int count, unsigned int required_capacity)
+{
+	const __m256i r   = _mm256_set1_epi16(static_cast<short>(required_capacity));
+	const __m256i one = _mm256_set1_epi16(1);
+	__m256i best      = _mm256_setzero_si256();
+
+	unsigned int j = 0;
+	for(; j+16 <= count; j += 16)
+	{
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins+j));
+		__m256i f = _mm256_cmpeq_epi16(_mm256_min_epu16(b, r), b);
+		best      = _mm256_max_epu16(best, _mm256_and_si256(f, _mm256_add_epi16(b, one)));
+	}
+
+	unsigned short lanes[16];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), best);
+
+	unsigned int max_value = 0;
+	for(unsigned int l = 0; l < 16; l++)
+	{
+		if(lanes[l] > max_value)
+			max_value = lanes[l];
+	}
+
+	for(; j < count; j++)
+	{
+		if(bins[j] <= required_capacity && bins[j]+1u > max_value)
+			max_value = bins[j]+1;
+	}
+
+	if(max_value == 0)
+		return(count);
+
+	return(find_avx2_16(bins, count, max_value-1));
+}
+
+__attribute__((target("avx2")))
+static unsigned int max_rest_avx2_32(const unsigned int* bins, unsigned int count)
+{
+	__m256i m = _mm256_set1_epi32(-1);
+
+	unsigned int j = 0;
+	for(; j+8 <= count; j += 8)
+		m = _mm256_min_epu32(m, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins+j)));
+
+	unsigned int lanes[8];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), m);
+
+	unsigned int min_value = 0xFFFFFFFFu;
+	for(unsigned int l = 0; l < 8; l++)
+	{
+		if(lanes[l] < min_value)
+			min_value = lanes[l];
+	}
+
+	for(; j < count; j++)
+	{
+		if(bins[j] < min_value)
+			min_value = bins[j];
+	}
+
+	return(find_avx2_32(bins, count, min_value));
+}
+
+__attribute__((target("avx2")))
+static unsigned int max_rest_avx2_16(const unsigned short* bins, unsigned int count)
+{
+	__m256i m = _mm256_set1_epi16(-1);
+
+	unsigned int j = 0;
+	for(; j+16 <= count; j += 16)
+		m = _mm256_min_epu16(m, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins+j)));
+
+	unsigned short lanes[16];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), m);
+
+	unsigned int min_value = 0xFFFFu;
+	for(unsigned int l = 0; l < 16; l++)
+	{
+		if(lanes[l] < min_value)
+			min_value = lanes[l];
+	}
+
+	for(; j < count; j++)
+	{
+		if(bins[j] < min_value)
+			min_value = bins[j];
+	}
+
+	return(find_avx2_16(bins, count, min_value));
+}
+
+/*
+	AVX-512 kernels. Comparisons yield bit masks directly, so the scans
+	need no emulation of unsigned comparisons.
+*/
+
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int find_avx512_32(const unsigned int* bins, unsigned int count, unsigned int value)
+{
+	const __m512i v = _mm512_set1_epi32(value);
+
+	unsigned int j = 0;
+	for(; j+16 <= count; j += 16)
+	{
+		__mmask16 mask = _mm512_cmpeq_epu32_mask(_mm512_loadu_si512(bins+j), v);
+		if(mask)
+			return(j+__builtin_ctz(mask));
+	}
+
+	return(find_scalar(bins, j, count, value));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int find_avx512_16(const unsigned short* bins, unsigned int count, unsigned int value)
+{
+	const __m512i v = _mm512_set1_epi16(static_cast<short>(value));
+
+	unsigned int j = 0;
+	for(; j+32 <= count; j += 32)
+	{
+		__mmask32 mask = _mm512_cmpeq_epu16_mask(_mm512_loadu_si512(bins+j), v);
+		if(mask)
+			return(j+__builtin_ctz(mask));
+	}
+
+	return(find_scalar(bins, j, count, value));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int first_fit_avx512_32(const unsigned int* bins, unsigned int count, unsigned int required_capacity)
+{
+	const __m512i r = _mm512_set1_epi32(required_capacity);
+
+	unsigned int j = 0;
+	for(; j+16 <= count; j += 16)
+	{
+		__mmask16 mask = _mm512_cmple_epu32_mask(_mm512_loadu_si512(bins+j), r);
+		if(mask)
+			return(j+__builtin_ctz(mask));
+	}
+
+	return(first_fit_scalar(bins, j, count, required_capacity));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int first_fit_avx512_16(const unsigned short* bins, unsigned int count, unsigned int required_capacity)
+{
+	const __m512i r = _mm512_set1_epi16(static_cast<short>(required_capacity));
+
+	unsigned int j = 0;
+	for(; j+32 <= count; j += 32)
+	{
+		__mmask32 mask = _mm512_cmple_epu16_mask(_mm512_loadu_si512(bins+j), r);
+		if(mask)
+			return(j+__builtin_ctz(mask));
+	}
+
+	return(first_fit_scalar(bins, j, count, required_capacity));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int first_fit_avx512_8(const unsigned char* bins, unsigned int count, unsigned int required_capacity)
+{
+	const __m512i r = _mm512_set1_epi8(static_cast<char>(required_capacity));
+
+	unsigned int j = 0;
+	for(; j+64 <= count; j += 64)
+	{
+		__mmask64 mask = _mm512_cmple_epu8_mask(_mm512_loadu_si512(bins+j), r);
+		if(mask)
+			return(j+__builtin_ctzll(mask));
+	}
+
+	return(first_fit_scalar(bins, j, count, required_capacity));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int first_fit_vector_avx512(	const unsigned int* residual, unsigned int stride, unsigned int d,
+						const unsigned int* item, unsigned int j, unsigned int count)
+{
+	for(; j+16 <= count; j += 16)
+	{
+		__mmask16 mask = 0xFFFF;
+		for(unsigned int k = 0; k < d && mask; k++)
+		{
+			__m512i r = _mm512_loadu_si512(residual+k*static_cast<size_t>(stride)+j);
+			mask = _mm512_mask_cmpge_epu32_mask(mask, r, _mm512_set1_epi32(item[k]));
+		}
+
+		if(mask)
+			return(j+__builtin_ctz(mask));
+	}
+
+	return(first_fit_vector_scalar(residual, stride, d, item, j, count));
+}
+
+// _mm512_max_epu32() and _mm512_min_epu32() of GCC use a deliberately
+// undefined value as their pass-through operand.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int best_fit_avx512_32(const unsigned int* bins, unsigned int count, unsigned int required_capacity)
+{
+	// See best_fit_avx2_32()
+	if(required_capacity == 0xFFFFFFFFu)
+		return(best_fit_scalar(bins, count, required_capacity));
+
+	const __m512i r   = _mm512_set1_epi32(required_capacity);
+	const __m512i one = _mm512_set1_epi32(1);
+	__m512i best      = _mm512_setzero_si512();
+
+	unsigned int j = 0;
+	for(; j+16 <= count; j += 16)
+	{
+		__m512i b      = _mm512_loadu_si512(bins+j);
+		__mmask16 mask = _mm512_cmple_epu32_mask(b, r);
+		best           = _mm512_max_epu32(best, _mm512_maskz_add_epi32(mask, b, one));
+	}
+
+	unsigned int lanes[16];
+	_mm512_storeu_si512(lanes, best);
+
+	unsigned int max_value = 0;
+	for(unsigned int l = 0; l < 16; l++)
+	{
+		if(lanes[l] > max_value)
+			max_value = lanes[l];
+	}
+
+	for(; j < count; j++)
+	{
+		if(bins[j] <= required_capacity && bins[j]+1 > max_value)
+			max_value = bins[j]+1;
+	}
+
+	if(max_value == 0)
+		return(count);
+
+	return(find_avx512_32(bins, count, max_value-1));
+}
+#pragma GCC diagnostic pop
+
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int best_fit_avx512_16(const unsigned short* bins, unsigned int count, unsigned int required_capacity)
+{
+	const __m512i r   = _mm512_set1_epi16(static_cast<short>(required_capacity));
+	const __m512i one = _mm512_set1_epi16(1);
+	__m512i best      = _mm512_setzero_si512();
+
+	unsigned int j = 0;
+	for(; j+32 <= count; j += 32)
+	{
+		__m512i b      = _mm512_loadu_si512(bins+j);
+		__mmask32 mask = _mm512_cmple_epu16_mask(b, r);
+		best           = _mm512_max_epu16(best, _mm512_maskz_add_epi16(mask, b, one));
+	}
+
+	unsigned short lanes[32];
+	_mm512_storeu_si512(lanes, best);
+
+	unsigned int max_value = 0;
+	for(unsigned int l = 0; l < 32; l++)
+	{
+		if(lanes[l] > max_value)
+			max_value = lanes[l];
+	}
+
+	for(; j < count; j++)
+	{
+		if(bins[j] <= required_capacity && bins[j]+1u > max_value)
+			max_value = bins[j]+1;
+	}
+
+	if(max_value == 0)
+		return(count);
+
+	return(find_avx512_16(bins, count, max_value-1));
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int max_rest_avx512_32(const unsigned int* bins, unsigned int count)
+{
+	__m512i m = _mm512_set1_epi32(-1);
+
+	unsigned int j = 0;
+	for(; j+16 <= count; j += 16)
+		m = _mm512_min_epu32(m, _mm512_loadu_si512(bins+j));
+
+	unsigned int lanes[16];
+	_mm512_storeu_si512(lanes, m);
+
+	unsigned int min_value = 0xFFFFFFFFu;
+	for(unsigned int l = 0; l < 16; l++)
+	{
+		if(lanes[l] < min_value)
+			min_value = lanes[l];
+	}
+
+	for(; j < count; j++)
+	{
+		if(bins[j] < min_value)
+			min_value = bins[j];
+	}
+
+	return(find_avx512_32(bins, count, min_value));
+}
+#pragma GCC diagnostic pop
+
+__attribute__((target("avx512f,avx512bw")))
+static unsigned int max_rest_avx512_16(const unsigned short* bins, unsigned int count)
+{
+	__m512i m = _mm512_set1_epi16(-1);
+
+	unsigned int j = 0;
+	for(; j+32 <= count; j += 32)
+		m = _mm512_min_epu16(m, _mm512_loadu_si512(bins+j));
+
+	unsigned short lanes[32];
+	_mm512_storeu_si512(lanes, m);
+
+	unsigned int min_value = 0xFFFFu;
+	for(unsigned int l = 0; l < 32; l++)
+	{
+		if(lanes[l] < min_value)
+			min_value = lanes[l];
+	}
+
+	for(; j < count; j++)
+	{
+		if(bins[j] < min_value)
+			min_value = bins[j];
+	}
+
+	return(find_avx512_16(bins, count, min_value));
+}
+
+#endif
+
+/*!
+	Set of kernels for one instruction set.
+*/
+
+struct scan_kernels
+{
+	const char* name;
+
+	unsigned int (*first_fit_32)(const unsigned int*, unsigned int, unsigned int);
+	unsigned int (*first_fit_16)(const unsigned short*, unsigned int, unsigned int);
+	unsigned int (*first_fit_8)(const unsigned char*, unsigned int, unsigned int);
+	unsigned int (*best_fit_32)(const unsigned int*, unsigned int, unsigned int);
+	unsigned int (*best_fit_16)(const unsigned short*, unsigned int, unsigned int);
+	unsigned int (*max_rest_32)(const unsigned int*, unsigned int);
+	unsigned int (*max_rest_16)(const unsigned short*, unsigned int);
+	unsigned int (*first_fit_vector)(const unsigned int*, unsigned int, unsigned int, const unsigned int*, unsigned int, unsigned int);
+};
+
+static const scan_kernels scalar_kernels = {	"scalar",
+						first_fit_scalar_32, first_fit_scalar_16, first_fit_scalar_8,
+						best_fit_scalar_32, best_fit_scalar_16,
+						max_rest_scalar_32, max_rest_scalar_16,
+						first_fit_vector_scalar };
+
+#ifdef BIN_SCAN_X86
+
+static const scan_kernels avx2_kernels = {	"avx2",
+						first_fit_avx2_32, first_fit_avx2_16, first_fit_avx2_8,
+						best_fit_avx2_32, best_fit_avx2_16,
+						max_rest_avx2_32, max_rest_avx2_16,
+						first_fit_vector_avx2 };
+
+static const scan_kernels avx512_kernels = {	"avx512",
+						first_fit_avx512_32, first_fit_avx512_16, first_fit_avx512_8,
+						best_fit_avx512_32, best_fit_avx512_16,
+						max_rest_avx512_32, max_rest_avx512_16,
+						first_fit_vector_avx512 };
+
+#endif
+
+/*!
+	Chooses the fastest set of kernels that is supported by the CPU and
+	permitted by the BIN_PACKING_ISA environment variable.
+*/
+
+static const scan_kernels* select_kernels()
+{
+#ifdef BIN_SCAN_X86
+	const char* isa = getenv("BIN_PACKING_ISA");
+
+	__builtin_cpu_init();
+	if(	(isa == NULL || strcmp(isa, "avx512") == 0) &&
+		__builtin_cpu_supports("avx512f") &&
+		__builtin_cpu_supports("avx512bw"))
+		return(&avx512_kernels);
+
+	if(	(isa == NULL || strcmp(isa, "avx512") == 0 || strcmp(isa, "avx2") == 0) &&
+		__builtin_cpu_supports("avx2"))
+		return(&avx2_kernels);
+#endif
+
+	return(&scalar_kernels);
+}
+
+static const scan_kernels* kernels = select_kernels();
+
+/*!
+	Searches for the first bin that can take an object.
+
+	@param bins			Array of bin fill levels
+	@param count			Number of bins to scan
+	@param required_capacity	Maximum fill level of a bin that can still
+					take the object, i.e. K minus the object size
+
+	@return Index of the first bin with a fill level of at most
+	required_capacity, or count if there is no such bin.
+*/
+
+unsigned int scan_first_fit(const unsigned int* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(kernels->first_fit_32(bins, count, required_capacity));
+}
+
+unsigned int scan_first_fit(const unsigned short* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(kernels->first_fit_16(bins, count, required_capacity));
+}
+
+unsigned int scan_first_fit(const unsigned char* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(kernels->first_fit_8(bins, count, required_capacity));
+}
+
+/*!
+	Searches for the first bin that can take a d-dimensional item. The
+	residual capacities of the bins are stored as structure of arrays, so
+	every dimension of a block of bins is checked with a single vector
+	compare and the masks of all dimensions are combined.
+
+	@param residual		Residual capacities; dimension k of bin j is at
+				residual[k*stride+j]
+	@param stride		Distance between the dimensions
+	@param d		Number of dimensions
+	@param item		Demand of the item in every dimension
+	@param begin		First bin to check
+	@param count		Number of bins
+
+	@return Index of the first bin in [begin, count) that can take the
+	item, or count if there is no such bin.
+*/
+
+unsigned int scan_first_fit(	const unsigned int* residual, unsigned int stride, unsigned int d,
+				const unsigned int* item, unsigned int begin, unsigned int count)
+{
+	return(kernels->first_fit_vector(residual, stride, d, item, begin, count));
+}
+
+/*!
+	Searches for the bin that is filled best after adding an object.
+
+	@param bins			Array of bin fill levels
+	@param count			Number of bins to scan
+	@param required_capacity	Maximum fill level of a bin that can still
+					take the object, i.e. K minus the object size
+
+	@return Index of the first bin with the highest fill level of at most
+	required_capacity, or count if there is no such bin.
+*/
+
+unsigned int scan_best_fit(const unsigned int* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(kernels->best_fit_32(bins, count, required_capacity));
+}
+
+unsigned int scan_best_fit(const unsigned short* bins, unsigned int count, unsigned int required_capacity)
+{
+	return(kernels->best_fit_16(bins, count, required_capacity));
+}
+
+/*!
+	Searches for the bin with maximum remaining capacity.
+
+	@param bins	Array of bin fill levels
+	@param count	Number of bins to scan
+
+	@return Index of the first bin with the lowest fill level, or count if
+	there are no bins.
+*/
+
+unsigned int scan_max_rest(const unsigned int* bins, unsigned int count)
+{
+	return(kernels->max_rest_32(bins, count));
+}
+
+unsigned int scan_max_rest(const unsigned short* bins, unsigned int count)
+{
+	return(kernels->max_rest_16(bins, count));
+}
+
+/*!
+	@return Name of the instruction set used by the scan kernels.
+*/
+
+const char* scan_isa()
+{
+	return(kernels->name);
+}
@@ -0,0 +1,24 @@
+/*!
+	@file	bin-scan.h
+	@brief	Prototypes for vectorized kernels that scan an array of bins
+
+	@author Bastian Rieck
+*/
+
+#ifndef BIN_SCAN_H
+#define BIN_SCAN_H
+
+unsigned int scan_first_fit(const unsigned int*, unsigned int, unsigned int);
+unsigned int scan_first_fit(const unsigned short*, unsigned int, unsigned int);
+unsigned int scan_first_fit(const unsigned char*, unsigned int, unsigned int);
+unsigned int scan_first_fit(const unsigned int*, unsigned int, unsigned int, const unsigned int*, unsigned int, unsigned int);
+
+unsigned int scan_best_fit(const unsigned int*, unsigned int, unsigned int);
+unsigned int scan_best_fit(const unsigned short*, unsigned int, unsigned int);
+
+unsigned int scan_max_rest(const unsigned int*, unsigned int);
+unsigned int scan_max_rest(const unsigned short*, unsigned int);
+
+const char* scan_isa();
+
+#endif
@@ -0,0 +1,420 @@
+/*!
+	@file	concurrent-packing.cpp
+	@brief	Online packing of objects that several threads produce at once
+
+	@author Bastian Rieck
+*/
+
+#include <climits>
+#include <new>
+
+#include "concurrent-packing.h"
+#include "trace.h"
+
+/*!
+	Marks the absence of a bin, e.g. the end of a stack.
+*/
+
+static const unsigned int no_bin = UINT_MAX;
+
+/*!
+	Number of bins of the first segment.
+*/
+
+static const unsigned int first_segment = 1 << 12;
+
+/*!
+	Number of bins on top of a bucket that are examined for an object.
+*/
+
+static const unsigned int pool_depth = 4;
+
+/*!
+	Creates a packer without any bins.
+
+	@param K		Capacity of bins
+	@param num_producers	Number of producers
+*/
+
+concurrent_packer::concurrent_packer(unsigned int K, unsigned int num_producers)
+	: K(K), num_opened(0), nonempty(0), producers(num_producers)
+{
+	for(unsigned int k = 0; k < num_pool_buckets; k++)
+		buckets[k].head.store(no_bin, std::memory_order_relaxed);
+
+	for(unsigned int k = 0; k < num_segments; k++)
+		segments[k].store(NULL, std::memory_order_relaxed);
+
+	for(unsigned int i = 0; i < num_producers; i++)
+	{
+		producer& p = producers[i];
+
+		p.hint = no_bin;
+		p.objects.store(0, std::memory_order_relaxed);
+		p.sum.store(0, std::memory_order_relaxed);
+		p.hint_hits.store(0, std::memory_order_relaxed);
+		p.pool_hits.store(0, std::memory_order_relaxed);
+		p.retries.store(0, std::memory_order_relaxed);
+	}
+}
+
+/*!
+	Releases all bins.
+*/
+
+concurrent_packer::~concurrent_packer()
+{
+	for(unsigned int k = 0; k < num_segments; k++)
+		delete[] segments[k].load(std::memory_order_relaxed);
+}
+
+/*!
+	Places objects of a producer. May be called by several threads at
+	once, as long as they act for different producers.
+
+	@param producer		Number of the producer
+	@param objects		Objects to place
+	@param count		Number of objects
+	@param positions	Optional array that will contain the bin of every
+				object
+
+	Throws std::bad_alloc if no memory for bins is available or if 2^32-1
+	bins would be exceeded.
+*/
+
+void concurrent_packer::add(unsigned int producer, const unsigned int* objects, size_t count, unsigned int* positions)
+{
+	trace_span span("concurrent add", "pack");
+
+	concurrent_packer::producer& p = producers[producer];
+
+	// The counters are updated for every object, so that they still
+	// match the bins if place() throws halfway through
+	unsigned long long placed = p.objects.load(std::memory_order_relaxed);
+	unsigned long long sum	  = p.sum.load(std::memory_order_relaxed);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		unsigned int b = place(p, objects[i]);
+
+		placed += 1;
+		sum    += objects[i];
+
+		p.objects.store(placed, std::memory_order_relaxed);
+		p.sum.store(sum, std::memory_order_relaxed);
+
+		if(positions != NULL)
+			positions[i] = b;
+	}
+}
+
+/*!
+	Places a single object: into the bin of the previous object if the
+	pool holds no bin in the same bucket or a tighter one; otherwise into
+	the tightest bin of the pool; and into a new bin if it fits nowhere.
+
+	@return Bin of the object.
+*/
+
+unsigned int concurrent_packer::place(producer& p, unsigned int size)
+{
+	const unsigned int first = bucket_of(size);
+	unsigned long long candidates = nonempty.load(std::memory_order_acquire) & (~0ull << first);
+
+	if(p.hint != no_bin)
+	{
+		unsigned int fill = at(p.hint).fill.load(std::memory_order_relaxed);
+		if(	fill <= K-size &&
+			(candidates == 0 || static_cast<unsigned int>(__builtin_ctzll(candidates)) > bucket_of(K-fill)) &&
+			claim(p.hint, size, p))
+		{
+			p.hint_hits.store(p.hint_hits.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+			return(p.hint);
+		}
+	}
+
+	while(candidates != 0)
+	{
+		unsigned int k = static_cast<unsigned int>(__builtin_ctzll(candidates));
+		candidates &= candidates-1;
+
+		unsigned int b = claim_from_bucket(k, size, p);
+		if(b != no_bin)
+		{
+			std::atomic<unsigned long long>& hits = (b == p.hint) ? p.hint_hits : p.pool_hits;
+			hits.store(hits.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+
+			p.hint = b;
+			return(b);
+		}
+	}
+
+	// The bin of the previous object may be buried in its stack
+	if(p.hint != no_bin && claim(p.hint, size, p))
+	{
+		p.hint_hits.store(p.hint_hits.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+		return(p.hint);
+	}
+
+	p.hint = open(size);
+	return(p.hint);
+}
+
+/*!
+	Claims room for an object in a bin by a compare-and-swap on its fill
+	level.
+
+	@return false if the object does not fit into the bin.
+*/
+
+bool concurrent_packer::claim(unsigned int b, unsigned int size, producer& p)
+{
+	std::atomic<unsigned int>& fill = at(b).fill;
+
+	unsigned int f = fill.load(std::memory_order_relaxed);
+	unsigned long long retries = 0;
+
+	bool claimed = false;
+	while(f <= K-size)
+	{
+		if(fill.compare_exchange_weak(f, f+size, std::memory_order_relaxed))
+		{
+			claimed = true;
+			break;
+		}
+
+		retries++;
+	}
+
+	if(retries > 0)
+		p.retries.store(p.retries.load(std::memory_order_relaxed)+retries, std::memory_order_relaxed);
+
+	return(claimed);
+}
+
+/*!
+	Tries to place an object into one of the bins on top of a bucket,
+	choosing the one with the least room it fits into. Bins on top that
+	are full or belong to a bucket with less room are moved first. The
+	bin on top is moved, too, if its room drops below the bucket; bins
+	below it are moved once they reach the top.
+
+	@param k	Bucket
+	@param size	Size of the object
+	@param p	Producer
+
+	@return Bin of the object, or no_bin if it does not fit into any of
+	the bins on top of the bucket.
+*/
+
+unsigned int concurrent_packer::claim_from_bucket(unsigned int k, unsigned int size, producer& p)
+{
+	std::atomic<unsigned long long>& head = buckets[k].head;
+	const unsigned long long bit = 1ull << k;
+
+	for(;;)
+	{
+		unsigned long long h = head.load(std::memory_order_acquire);
+		unsigned int top = static_cast<unsigned int>(h);
+
+		// A push may happen between both checks, so the bit is set
+		// again if the bucket has been filled in the meantime
+		if(top == no_bin)
+		{
+			nonempty.fetch_and(~bit);
+			if(static_cast<unsigned int>(head.load()) == no_bin)
+				return(no_bin);
+
+			nonempty.fetch_or(bit);
+			continue;
+		}
+
+		unsigned int fill = at(top).fill.load(std::memory_order_relaxed);
+		if(fill >= K || bucket_of(K-fill) != k)
+		{
+			if(pop(k, h) && fill < K)
+				push(top);
+
+			continue;
+		}
+
+		// Bins below the top may be moved to other stacks meanwhile,
+		// which only means that other bins are examined
+		unsigned int b	  = top;
+		unsigned int best = no_bin;
+		unsigned int room = 0;
+
+		for(unsigned int depth = 0; depth < pool_depth && b != no_bin; depth++)
+		{
+			unsigned int f = at(b).fill.load(std::memory_order_relaxed);
+			if(f <= K-size && (best == no_bin || K-f < room))
+			{
+				best = b;
+				room = K-f;
+			}
+
+			b = at(b).next.load(std::memory_order_relaxed);
+		}
+
+		if(best == no_bin)
+			return(no_bin);
+
+		if(!claim(best, size, p))
+			continue;
+
+		if(best == top && bucket_of(room-size) != k && pop(k, h) && room > size)
+			push(top);
+
+		return(best);
+	}
+}
+
+/*!
+	Opens a new bin for an object and adds the bin to the pool.
+
+	@return New bin.
+*/
+
+unsigned int concurrent_packer::open(unsigned int size)
+{
+	unsigned int b = num_opened.fetch_add(1, std::memory_order_relaxed);
+	if(b == no_bin)
+	{
+		num_opened.store(no_bin, std::memory_order_relaxed);
+		throw std::bad_alloc();
+	}
+
+	// The first bin of every segment allocates it; if another producer
+	// has been faster, its segment is used
+	unsigned long long v = static_cast<unsigned long long>(b)+first_segment;
+	unsigned int s = 63-__builtin_clzll(v)-12;
+
+	if(segments[s].load(std::memory_order_acquire) == NULL)
+	{
+		size_t length = static_cast<size_t>(first_segment) << s;
+
+		bin* segment = new bin[length];
+		for(size_t i = 0; i < length; i++)
+		{
+			segment[i].fill.store(0, std::memory_order_relaxed);
+			segment[i].next.store(no_bin, std::memory_order_relaxed);
+		}
+
+		bin* expected = NULL;
+		if(!segments[s].compare_exchange_strong(expected, segment, std::memory_order_acq_rel))
+			delete[] segment;
+	}
+
+	at(b).fill.store(size, std::memory_order_relaxed);
+	if(size < K)
+		push(b);
+
+	return(b);
+}
+
+/*!
+	Pushes a bin onto the bucket of its current room. The caller has
+	either opened the bin or popped it, so no other thread pushes it.
+*/
+
+void concurrent_packer::push(unsigned int b)
+{
+	unsigned int k = bucket_of(K-at(b).fill.load(std::memory_order_relaxed));
+	std::atomic<unsigned long long>& head = buckets[k].head;
+
+	unsigned long long h = head.load(std::memory_order_relaxed);
+	unsigned long long pushed;
+	do
+	{
+		at(b).next.store(static_cast<unsigned int>(h), std::memory_order_relaxed);
+		pushed = (((h >> 32)+1) << 32) | b;
+	}
+	while(!head.compare_exchange_weak(h, pushed, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+	// Both the push and the load below are sequentially consistent, as
+	// are the clearing of the bit and the reload of the head in
+	// claim_from_bucket(). Hence either this load sees the cleared bit,
+	// or claim_from_bucket() sees the pushed bin and sets it again.
+	const unsigned long long bit = 1ull << k;
+	if((nonempty.load() & bit) == 0)
+		nonempty.fetch_or(bit);
+}
+
+/*!
+	Pops the bin on top of a bucket, unless the head has changed since it
+	has been read.
+
+	@param k	Bucket
+	@param h	Head as it has been read
+
+	@return true if the bin has been popped; the caller is its owner.
+*/
+
+bool concurrent_packer::pop(unsigned int k, unsigned long long h)
+{
+	unsigned int b = static_cast<unsigned int>(h);
+	unsigned long long popped = (((h >> 32)+1) << 32) | at(b).next.load(std::memory_order_relaxed);
+
+	return(buckets[k].head.compare_exchange_strong(h, popped, std::memory_order_acq_rel, std::memory_order_relaxed));
+}
+
+/*!
+	@return Bucket of bins with the given room; buckets divide [0,K]
+	evenly.
+*/
+
+unsigned int concurrent_packer::bucket_of(unsigned int room) const
+{
+	return(static_cast<unsigned int>(static_cast<unsigned long long>(room)*num_pool_buckets/(static_cast<unsigned long long>(K)+1)));
+}
+
+/*!
+	@return Bin with the given number; it has to be open.
+*/
+
+concurrent_packer::bin& concurrent_packer::at(unsigned int b)
+{
+	unsigned long long v = static_cast<unsigned long long>(b)+first_segment;
+	unsigned int s = 63-__builtin_clzll(v)-12;
+
+	return(segments[s].load(std::memory_order_acquire)[v-(static_cast<unsigned long long>(first_segment) << s)]);
+}
+
+/*!
+	@return Number of bins opened so far.
+*/
+
+unsigned int concurrent_packer::num_bins() const
+{
+	return(num_opened.load(std::memory_order_relaxed));
+}
+
+/*!
+	@return Number of producers.
+*/
+
+unsigned int concurrent_packer::num_producers() const
+{
+	return(static_cast<unsigned int>(producers.size()));
+}
+
+/*!
+	@return Counters of all producers added up.
+*/
+
+concurrent_counters concurrent_packer::counters() const
+{
+	concurrent_counters c = { 0, 0, 0, 0, 0 };
+	for(size_t i = 0; i < producers.size(); i++)
+	{
+		const producer& p = producers[i];
+
+		c.objects   += p.objects.load(std::memory_order_relaxed);
+		c.sum	    += p.sum.load(std::memory_order_relaxed);
+		c.hint_hits += p.hint_hits.load(std::memory_order_relaxed);
+		c.pool_hits += p.pool_hits.load(std::memory_order_relaxed);
+		c.retries   += p.retries.load(std::memory_order_relaxed);
+	}
+
+	return(c);
+}
@@ -0,0 +1,139 @@
+/*!
+	@file	concurrent-packing.h
+	@brief	Online packing of objects that several threads produce at once
+
+	Every producer thread places its objects into bins that are shared
+	by all producers. Space in a bin is claimed by a compare-and-swap on
+	its fill level, so no lock is ever taken while packing.
+
+	Bins that still have room are kept in a pool of buckets by their
+	remaining capacity. Every bucket is a lock-free stack whose head
+	carries a tag against the ABA problem, and a bitmap tells which
+	buckets are not empty. An object goes to the bin with the least room
+	it fits into, as far as the buckets and the top few bins of their
+	stacks tell, which comes close to "Best-Fit". Like "Next-Fit", every
+	producer remembers the bin of its previous object and takes it
+	without looking at the stacks if the pool holds no bin that is
+	equally tight or tighter, so producers often work on different bins
+	and contend less for the heads of the stacks.
+
+	Entries of the pool are updated lazily: the fill level of a bin
+	changes whenever a producer claims space in it, and the bin is only
+	moved to its new bucket when it reaches the head of its stack. Full
+	bins leave the pool there, too. Bins are never freed while the
+	packer exists, so a stale entry never refers to freed memory.
+
+	@author Bastian Rieck
+*/
+
+#ifndef CONCURRENT_PACKING_H
+#define CONCURRENT_PACKING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*!
+	Number of buckets of the pool; one bit of the bitmap each.
+*/
+
+static const unsigned int num_pool_buckets = 64;
+
+/*!
+	Counters of a single producer. Only the producer writes them; they
+	may be read at any time.
+*/
+
+struct concurrent_counters
+{
+	unsigned long long objects;	///< Objects placed
+	unsigned long long sum;		///< Sum of their sizes
+	unsigned long long hint_hits;	///< Objects placed into the bin of the previous object
+	unsigned long long pool_hits;	///< Objects placed into a bin of the pool
+	unsigned long long retries;	///< Failed compare-and-swaps
+};
+
+/*!
+	Packs objects from several producer threads into shared bins.
+	Producers are numbered from 0; a producer must not be used by more
+	than one thread at a time.
+*/
+
+class concurrent_packer
+{
+	public:
+		concurrent_packer(unsigned int K, unsigned int num_producers);
+		~concurrent_packer();
+
+		void add(unsigned int producer, const unsigned int* objects, size_t count, unsigned int* positions);
+
+		unsigned int num_bins() const;
+		unsigned int num_producers() const;
+		concurrent_counters counters() const;
+
+	private:
+		concurrent_packer(const concurrent_packer&);
+		concurrent_packer& operator=(const concurrent_packer&);
+
+		/*!
+			Fill level of a bin and its successor in the stack of
+			its bucket.
+		*/
+
+		struct bin
+		{
+			std::atomic<unsigned int> fill;
+			std::atomic<unsigned int> next;
+		};
+
+		/*!
+			State of a producer, on a cache line of its own.
+		*/
+
+		struct alignas(64) producer
+		{
+			unsigned int hint;	///< Bin of the previous object, or no_bin
+			std::atomic<unsigned long long> objects;
+			std::atomic<unsigned long long> sum;
+			std::atomic<unsigned long long> hint_hits;
+			std::atomic<unsigned long long> pool_hits;
+			std::atomic<unsigned long long> retries;
+		};
+
+		/*!
+			Head of the stack of a bucket: a tag that changes with
+			every push and pop in the upper half, the bin on top in
+			the lower half.
+		*/
+
+		struct alignas(64) bucket
+		{
+			std::atomic<unsigned long long> head;
+		};
+
+		unsigned int place(producer& p, unsigned int size);
+		bool claim(unsigned int b, unsigned int size, producer& p);
+		unsigned int claim_from_bucket(unsigned int k, unsigned int size, producer& p);
+		unsigned int open(unsigned int size);
+
+		void push(unsigned int b);
+		bool pop(unsigned int k, unsigned long long head);
+
+		unsigned int bucket_of(unsigned int room) const;
+		bin& at(unsigned int b);
+
+		unsigned int K;
+
+		std::atomic<unsigned int> num_opened;
+		std::atomic<unsigned long long> nonempty;	///< Bit k is set if bucket k may hold bins
+		bucket buckets[num_pool_buckets];
+
+		// Bins are kept in segments of doubling size, so that they never
+		// move; segment k holds 2^(k+12) bins
+		static const unsigned int num_segments = 21;
+		std::atomic<bin*> segments[num_segments];
+
+		std::vector<producer> producers;
+};
+
+#endif
@@ -0,0 +1,414 @@
+/*!
+	@file	external-packing.cpp
+	@brief	Packing of instances that do not fit into memory
+
+	@author Bastian Rieck
+*/
+
+#include "external-packing.h"
+
+/*!
+	Creates a packer without any objects. Throws std::bad_alloc if the
+	histogram cannot be allocated.
+
+	@param K		Capacity of bins
+	@param best_fit		Whether "Best-Fit" runs while the objects are
+				added
+*/
+
+external_packer::external_packer(unsigned int K, bool best_fit)
+	: K(K), n(0), sum(0), histogram(static_cast<size_t>(K)+1, 0), nf_bins(0), nf_fill(0), nfd_bins(0),
+	  decreasing(false), cur_bin(0), fill(0), empty(true)
+{
+	if(best_fit)
+		bin_count.resize(static_cast<size_t>(K)+1, 0);
+}
+
+/*!
+	Counts the next chunk of objects. No object may exceed the capacity.
+*/
+
+void external_packer::count(const unsigned int* objects, size_t count)
+{
+	unsigned long long* counts = &histogram[0];
+	for(size_t i = 0; i < count; i++)
+	{
+		counts[objects[i]]++;
+		sum += objects[i];
+	}
+
+	n += count;
+	nfd_first.clear();
+}
+
+/*!
+	Packs the next chunk of objects with "Next-Fit".
+*/
+
+void external_packer::add_next_fit(const unsigned int* objects, size_t count)
+{
+	size_t i = 0;
+	if(nf_bins == 0 && count > 0)
+	{
+		nf_bins = 1;
+		nf_fill = objects[i++];
+	}
+
+	// Whether an object fits is hardly predictable, so the loop is kept
+	// free of branches
+	unsigned long long num_bins = nf_bins;
+	unsigned int fill = nf_fill;
+
+	for(; i < count; i++)
+	{
+		bool fits = (fill <= K-objects[i]);
+		fill	  = fits ? fill+objects[i] : objects[i];
+		num_bins += !fits;
+	}
+
+	nf_bins = num_bins;
+	nf_fill = fill;
+}
+
+/*!
+	Packs the next chunk of objects with "Best-Fit". Every object goes to
+	the open bin with the smallest remaining capacity that suffices, or
+	to a new bin if there is none. As in memory, an object of size 0
+	opens a bin only if no bin is open; that bin is counted as having a
+	remaining capacity of K.
+*/
+
+void external_packer::add_best_fit(const unsigned int* objects, size_t count)
+{
+	if(bin_count.empty())
+		return;
+
+	unsigned long long* bins = &bin_count[0];
+	for(size_t i = 0; i < count; i++)
+	{
+		unsigned int size = objects[i];
+		size_t cur_size = size;
+
+		while(cur_size <= K && bins[cur_size] == 0)
+			cur_size++;
+
+		if(cur_size <= K)
+		{
+			bins[cur_size]--;
+			bins[cur_size-size]++;
+		}
+		else
+			bins[K-size]++;
+	}
+}
+
+/*!
+	@return Number of objects added so far.
+*/
+
+unsigned long long external_packer::num_objects() const
+{
+	return(n);
+}
+
+/*!
+	@return Sum of the sizes of all objects.
+*/
+
+unsigned long long external_packer::sum_size() const
+{
+	return(sum);
+}
+
+/*!
+	@return Size of the smallest object, or K if there is none.
+*/
+
+unsigned int external_packer::min_size() const
+{
+	for(unsigned int s = 0; s < K; s++)
+		if(histogram[s] > 0)
+			return(s);
+
+	return(K);
+}
+
+/*!
+	@return Size of the largest object, or 0 if there is none.
+*/
+
+unsigned int external_packer::max_size() const
+{
+	for(unsigned int s = K; s > 0; s--)
+		if(histogram[s] > 0)
+			return(s);
+
+	return(0);
+}
+
+/*!
+	@return Number of bins opened by "Next-Fit".
+*/
+
+unsigned long long external_packer::next_fit() const
+{
+	return(nf_bins);
+}
+
+/*!
+	@return Number of bins opened by "Best-Fit", or 0 if it has not run.
+*/
+
+unsigned long long external_packer::best_fit() const
+{
+	unsigned long long num_bins = 0;
+	for(size_t r = 0; r < bin_count.size(); r++)
+		num_bins += bin_count[r];
+
+	return(num_bins);
+}
+
+/*!
+	Performs "Next-Fit-Decreasing" on the histogram in O(K). The objects
+	of one size fill the current bin and then K/s objects per bin, so
+	the layout of the packing is stored per size, which is all that
+	assign() requires.
+
+	@return Number of bins.
+*/
+
+unsigned long long external_packer::next_fit_decreasing()
+{
+	if(!nfd_first.empty())
+		return(nfd_bins);
+
+	nfd_first.assign(static_cast<size_t>(K)+1, 0);
+	nfd_take.assign(static_cast<size_t>(K)+1, 0);
+
+	unsigned long long num_bins = 0;
+	unsigned int cur_fill = 0;
+
+	for(unsigned int s = K; s > 0; s--)
+	{
+		unsigned long long c = histogram[s];
+		if(c == 0)
+			continue;
+
+		unsigned int per_bin = K/s;
+		unsigned int room = num_bins > 0 ? (K-cur_fill)/s : 0;
+
+		// Start a new bin if the current one cannot take a single
+		// object of this size
+		if(room == 0)
+		{
+			nfd_first[s] = num_bins++;
+			nfd_take[s]  = per_bin;
+			cur_fill     = 0;
+		}
+		else
+		{
+			nfd_first[s] = num_bins-1;
+			nfd_take[s]  = room;
+		}
+
+		if(c <= nfd_take[s])
+			cur_fill += static_cast<unsigned int>(c)*s;
+		else
+		{
+			unsigned long long rest = c-nfd_take[s];
+			unsigned int last = static_cast<unsigned int>(rest % per_bin);
+
+			num_bins += rest/per_bin + (last > 0);
+			cur_fill  = (last > 0 ? last : per_bin)*s;
+		}
+	}
+
+	// Objects of size 0 fit into the last bin
+	if(histogram[0] > 0 && num_bins == 0)
+		num_bins = 1;
+
+	nfd_first[0] = num_bins > 0 ? num_bins-1 : 0;
+	nfd_take[0]  = 0;
+
+	nfd_bins = num_bins;
+	return(num_bins);
+}
+
+/*!
+	Run of consecutive bins with the same remaining capacity.
+*/
+
+struct bin_run
+{
+	unsigned int remaining;
+	unsigned long long count;
+};
+
+/*!
+	Appends a run of bins, merging it with the previous run if both have
+	the same remaining capacity. Runs that cannot take the smallest
+	object anymore are dropped.
+*/
+
+static void append_run(std::vector<bin_run>& runs, unsigned int remaining, unsigned long long count, unsigned int min_size)
+{
+	if(count == 0 || remaining < min_size)
+		return;
+
+	if(!runs.empty() && runs.back().remaining == remaining)
+		runs.back().count += count;
+	else
+	{
+		bin_run run = { remaining, count };
+		runs.push_back(run);
+	}
+}
+
+/*!
+	Performs "First-Fit-Decreasing" on the histogram. Each size requires
+	a single pass over the runs of bins, so the running time is O(d*r)
+	for d distinct sizes and at most r runs, independent of the number
+	of objects.
+
+	@return Number of bins.
+*/
+
+unsigned long long external_packer::first_fit_decreasing() const
+{
+	const unsigned int smallest = min_size();
+
+	std::vector<bin_run> runs;
+	std::vector<bin_run> next;
+	unsigned long long num_bins = 0;
+
+	for(unsigned int s = K; s > 0; s--)
+	{
+		unsigned long long c = histogram[s];
+		if(c == 0)
+			continue;
+
+		next.clear();
+		for(size_t j = 0; j < runs.size(); j++)
+		{
+			const bin_run& run = runs[j];
+			if(c == 0 || run.remaining < s)
+			{
+				append_run(next, run.remaining, run.count, smallest);
+				continue;
+			}
+
+			// Every bin of the run is filled with objects of this size
+			// before the next bin receives any of them
+			unsigned int per_bin = run.remaining/s;
+			unsigned long long capacity = per_bin*run.count;
+
+			if(c >= capacity)
+			{
+				append_run(next, run.remaining-per_bin*s, run.count, smallest);
+				c -= capacity;
+			}
+			else
+			{
+				unsigned long long full = c/per_bin;
+				unsigned int last = static_cast<unsigned int>(c % per_bin);
+
+				append_run(next, run.remaining-per_bin*s, full, smallest);
+				if(last > 0)
+					append_run(next, run.remaining-last*s, 1, smallest);
+				append_run(next, run.remaining, run.count-full-(last > 0), smallest);
+
+				c = 0;
+			}
+		}
+
+		// New bins for the remaining objects
+		if(c > 0)
+		{
+			unsigned int per_bin = K/s;
+			unsigned int last = static_cast<unsigned int>(c % per_bin);
+
+			append_run(next, K-per_bin*s, c/per_bin, smallest);
+			if(last > 0)
+				append_run(next, K-last*s, 1, smallest);
+
+			num_bins += c/per_bin + (last > 0);
+		}
+
+		runs.swap(next);
+	}
+
+	if(histogram[0] > 0 && num_bins == 0)
+		num_bins = 1;
+
+	return(num_bins);
+}
+
+/*!
+	Starts a pass that assigns the objects to bins.
+
+	@param decreasing	Assign according to "Next-Fit-Decreasing"
+				instead of "Next-Fit"
+*/
+
+void external_packer::begin_assignment(bool decreasing)
+{
+	this->decreasing = decreasing;
+	if(decreasing)
+	{
+		next_fit_decreasing();
+		seen.assign(static_cast<size_t>(K)+1, 0);
+	}
+
+	cur_bin = 0;
+	fill	= 0;
+	empty	= true;
+}
+
+/*!
+	Assigns the next chunk of objects. All objects have to be passed in
+	the same order as before. Objects of the same size are placed in
+	their original order by "Next-Fit-Decreasing", as a stable counting
+	sort would order them. The caller has to make sure that all bins fit
+	into 32 bits.
+
+	@param objects		Objects of the chunk
+	@param count		Number of objects
+	@param positions	Will contain the bin of every object
+*/
+
+void external_packer::assign(const unsigned int* objects, size_t count, unsigned int* positions)
+{
+	if(decreasing)
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			unsigned int s = objects[i];
+			unsigned long long j = seen[s]++;
+
+			if(s == 0 || j < nfd_take[s])
+				positions[i] = static_cast<unsigned int>(nfd_first[s]);
+			else
+				positions[i] = static_cast<unsigned int>(nfd_first[s]+1+(j-nfd_take[s])/(K/s));
+		}
+
+		return;
+	}
+
+	for(size_t i = 0; i < count; i++)
+	{
+		if(empty)
+		{
+			fill  = objects[i];
+			empty = false;
+		}
+		else if(fill <= K-objects[i])
+			fill += objects[i];
+		else
+		{
+			fill = objects[i];
+			cur_bin++;
+		}
+
+		positions[i] = static_cast<unsigned int>(cur_bin);
+	}
+}
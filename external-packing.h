@@ -0,0 +1,93 @@
+/*!
+	@file	external-packing.h
+	@brief	Packing of instances that do not fit into memory
+
+	The objects are passed in chunks, e.g. while a file is read, and are
+	not kept. Every heuristic therefore needs memory that depends on the
+	capacity K, but not on the number of objects:
+
+	- "Next-Fit" only needs the fill level of its current bin.
+	- "Best-Fit" only needs the number of bins per remaining capacity,
+	  like best_fit_lookup().
+	- The Decreasing heuristics only need the number of objects of every
+	  size, i.e. the histogram that counting sort would use.
+
+	"First-Fit-Decreasing" packs the objects of one size at a time. All
+	bins that receive objects of the same size during one step end up
+	with the same fill level, so the bins are kept as runs of consecutive
+	bins with equal fill level instead of one by one. Every step splits
+	at most one run and appends at most two, and runs that no object fits
+	into anymore are dropped.
+
+	All counts are 64 bit, so the number of objects is not limited by the
+	32 bit indices of the heuristics that work in memory.
+
+	@author Bastian Rieck
+*/
+
+#ifndef EXTERNAL_PACKING_H
+#define EXTERNAL_PACKING_H
+
+#include <cstddef>
+#include <vector>
+
+/*!
+	Packs a stream of objects with bounded memory. Every chunk of objects
+	is passed to count() and to the add functions of the online
+	heuristics; afterwards, the number of bins of every heuristic is
+	known. Assignments are produced in a second pass over the same
+	objects, which are passed to assign() in their original order.
+*/
+
+class external_packer
+{
+	public:
+		external_packer(unsigned int K, bool best_fit);
+
+		void count(const unsigned int* objects, size_t count);
+		void add_next_fit(const unsigned int* objects, size_t count);
+		void add_best_fit(const unsigned int* objects, size_t count);
+
+		unsigned long long num_objects() const;
+		unsigned long long sum_size() const;
+		unsigned int min_size() const;
+		unsigned int max_size() const;
+
+		unsigned long long next_fit() const;
+		unsigned long long best_fit() const;
+		unsigned long long next_fit_decreasing();
+		unsigned long long first_fit_decreasing() const;
+
+		void begin_assignment(bool decreasing);
+		void assign(const unsigned int* objects, size_t count, unsigned int* positions);
+
+	private:
+		unsigned int K;
+		unsigned long long n;
+		unsigned long long sum;
+
+		std::vector<unsigned long long> histogram;	///< Objects per size
+
+		// "Next-Fit"
+		unsigned long long nf_bins;
+		unsigned int nf_fill;
+
+		// "Best-Fit"; bin_count is empty if it does not run
+		std::vector<unsigned long long> bin_count;	///< Bins per remaining capacity
+
+		// Layout of the "Next-Fit-Decreasing" packing: the objects of
+		// size s start in bin nfd_first[s], which takes nfd_take[s] of
+		// them; all following bins take K/s of them.
+		std::vector<unsigned long long> nfd_first;
+		std::vector<unsigned int> nfd_take;
+		unsigned long long nfd_bins;
+
+		// State of the assignment pass
+		bool decreasing;
+		std::vector<unsigned long long> seen;		///< Objects per size assigned so far
+		unsigned long long cur_bin;
+		unsigned int fill;
+		bool empty;
+};
+
+#endif
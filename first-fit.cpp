@@ -5,111 +5,156 @@
 	@author Bastian Rieck
 */
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <map>
+#include <system_error>
+#include <thread>
+#include <vector>
+
 #include <cstring>
 #include <ctime>
 #include <cstdlib>
-#include <vector>
-#include <map>
 
 #include "bin-packing.h"
+#include "run-control.h"
+#include "bin-scan.h"
+#include "size-table.h"
+#include "workspace.h"
+#include "sorted-view.h"
+#include "fixed-capacity.h"
+#include "trace.h"
 
 /*!
-	Applies the "First-Fit" heuristic to the current problem. Worst-case
-	running time is O(n^2). 
-
-	@param objects 		Array of object sizes
-	@param positions	Array that will contain the associations for the
-				objects. The entry in position i signifies the bin
-				that contains object i.
-	@param time		Variable that will be filled with the elapsed time
-				after the bins haven been sorted.
-
-	@return	Number of bins opened by the heuristic.
+	Implementation of the "First-Fit" heuristic for bins whose fill levels
+	are stored using a certain unsigned integer type. Smaller types allow
+	the scan kernels to check more bins per instruction. C is the capacity
+	if it is known at compile time, else 0.
 */
 
-unsigned int first_fit(const unsigned int* objects, unsigned int* positions, double& time)
+template<typename bin_t, unsigned int C> static unsigned int first_fit_bins(const problem& p, unsigned int* positions, double& time)
 {
-	unsigned int num_open_bins = 1;
-	unsigned int num_full_bins = 0;
-	unsigned int* bins = new unsigned int[n];
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = C ? C : p.K;
 
-	memset(bins, 0, n*sizeof(unsigned int));
-	memset(positions, 0, n*sizeof(unsigned int));
+	unsigned int num_open_bins = 1;
+	bin_t* bins = p.ws->borrow_zeroed<bin_t>(WS_BINS, n);
 
 	// This variable is set per object. It is the minimum capacity that is
 	// required in order to fit the object into a certain bin.
 	unsigned int required_capacity;
 
 	clock_t start = clock();
+	long long traced = trace_begin();
 	for(unsigned int i = 0; i < n; i++)
 	{
+		if(stop_requested(p, i, num_open_bins))
+			break;
+
 		required_capacity = K-objects[i];
-		for(unsigned int j = 0; j < num_open_bins; j++)
-		{
-			if(bins[j] <= required_capacity)
-			{
-				bins[j] += objects[i];
-				positions[i] = j+1;
 
-				break;
-			}
+		unsigned int j = scan_first_fit(bins, num_open_bins, required_capacity);
+		if(j < num_open_bins)
+		{
+			bins[j] += objects[i];
+			positions[i] = j;
 		}
 
 		// Object could not be placed--create a new bin and put it in
 		// there
-		if(positions[i] == 0)
+		else
 		{
 			bins[num_open_bins] = objects[i];
-			positions[i] = (++num_open_bins);
+			positions[i] = num_open_bins++;
 		}
 	}
 	
 	clock_t end = clock();
+	trace_end("pack", "pack", traced);
 	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
 
-	delete[] bins;
-	return(num_open_bins+num_full_bins);
+	return(num_open_bins);
 }
 
-/*
-	Applies the "First-Fit-Decreasing" heuristic to the current problem.
-	Worst-case running time is, not taking into account sorting with O(n
-	log n), O(n^2) because the "First-Fit" heuristic is called.
+/*!
+	Chooses the narrowest type for the fill levels of bins that is able to
+	hold the capacity. For a fixed capacity, the choice is made at compile
+	time.
 */
 
-unsigned int first_fit_decreasing(const unsigned int* objects, unsigned int* positions, double& time)
+struct first_fit_kernel
 {
-	unsigned int* sorted_objects = new unsigned int[n];
-	memcpy(sorted_objects, objects, n*sizeof(unsigned int));
+	template<unsigned int C> static unsigned int run(const problem& p, unsigned int* positions, double& time)
+	{
+		const unsigned int K = C ? C : p.K;
 
-	unsigned int num_bins;
+		if(K < 0xFF)
+			return(first_fit_bins<unsigned char, C>(p, positions, time));
+		else if(K < 0xFFFF)
+			return(first_fit_bins<unsigned short, C>(p, positions, time));
+		else
+			return(first_fit_bins<unsigned int, C>(p, positions, time));
+	}
+};
 
-	clock_t start = clock();
-	qsort(sorted_objects, n, sizeof(unsigned int), compare_uints); 
-	num_bins = first_fit(sorted_objects, positions, time);
-	clock_t end = clock();
+/*!
+	Applies the "First-Fit" heuristic to the current problem. Worst-case
+	running time is O(n^2). The bins are scanned using vectorized kernels;
+	if K permits it, fill levels are stored as 8 or 16 bit integers.
 
-	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
-		
-	delete[] sorted_objects;
-	return(num_bins);
+	@param objects 		Array of object sizes
+	@param positions	Array that will contain the associations for the
+				objects. The entry in position i signifies the bin
+				that contains object i.
+	@param time		Variable that will be filled with the elapsed time
+				after the bins haven been sorted.
+
+	@return	Number of bins opened by the heuristic.
+*/
+
+unsigned int first_fit(const problem& p, unsigned int* positions, double& time)
+{
+	return(dispatch_capacity<first_fit_kernel>(p, positions, time));
+}
+
+/*
+	Applies the "First-Fit-Decreasing" heuristic to the current problem.
+	Worst-case running time is, not taking into account sorting, O(n^2)
+	because the "First-Fit" heuristic is called. The objects are taken from
+	the shared sorted view, so the time does not include sorting.
+*/
+
+unsigned int first_fit_decreasing(const problem& p, unsigned int* positions, double& time)
+{
+	return(first_fit(decreasing(p), positions, time));
 }
 
 /*!
 	Implementation of First-Fit heuristic using STL vectors. This allows us
 	to remove bins that are almost full without disturbing the order of
-	other elements. The positions array is not used in this implementation.
+	other elements. If positions are recorded, the original index of every
+	bin is kept in a second vector that is erased in lockstep.
 */
 
-unsigned int first_fit_vec(const unsigned int* objects, double& time)
+template<bool record> static unsigned int first_fit_vec_bins(const problem& p, unsigned int* positions, double& time)
 {
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = p.K;
+	const unsigned int min_size = p.min_size;
+
 	unsigned int num_open_bins = 1;
 	unsigned int num_full_bins = 0;
 
 	std::vector<unsigned int> bins;
 	bins.push_back(0);
 
+	std::vector<unsigned int> ids;
+	if(record)
+		ids.push_back(0);
+
 	// If the bin is filled to more than (K-min_size), no object will fit
 	// anymore. Hence, the bin is removed and treated as if it was full.
 	unsigned int limit_capacity = K-min_size;
@@ -126,8 +171,12 @@ unsigned int first_fit_vec(const unsigned int* objects, double& time)
 	std::vector<unsigned int>::iterator bin;
 	
 	clock_t start = clock();
+	long long traced = trace_begin();
 	for(unsigned int i = 0; i < n; i++)
 	{
+		if(stop_requested(p, i, num_open_bins+num_full_bins))
+			break;
+
 		required_capacity = K-objects[i];
 		placed = false;
 
@@ -146,10 +195,17 @@ unsigned int first_fit_vec(const unsigned int* objects, double& time)
 				*bin += objects[i];
 				last_bin = bin;
 
+				if(record)
+					positions[i] = ids[bin-bins.begin()];
+
 				if(*bin > limit_capacity)
 				{
 					num_open_bins--;
 					num_full_bins++;
+
+					if(record)
+						ids.erase(ids.begin() + (bin-bins.begin()));
+
 					bins.erase(bin);
 				}
 
@@ -160,6 +216,12 @@ unsigned int first_fit_vec(const unsigned int* objects, double& time)
 
 		if(!placed) 
 		{
+			if(record)
+			{
+				positions[i] = num_open_bins+num_full_bins;
+				ids.push_back(positions[i]);
+			}
+
 			bins.push_back(objects[i]);
 			num_open_bins++;
 
@@ -168,56 +230,59 @@ unsigned int first_fit_vec(const unsigned int* objects, double& time)
 	}
 	
 	clock_t end = clock();
+	trace_end("pack", "pack", traced);
 	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
 
 	return(num_open_bins+num_full_bins);
 }
 
 /*!
-	Applies the "First-Fit-Decreasing" heuristic to the current problem
-	using the STL vector class. Since first_fit_vec is used, no positions
-	array is required.
+	Applies the "First-Fit" heuristic using STL vectors. The positions
+	array may be NULL, in which case the bookkeeping for it is skipped.
 */
 
-unsigned int first_fit_decreasing_vec(	const unsigned int* objects,
-					double& time,
-					void(*sort)(void*, size_t, size_t, int (*)(const void*, const void*)))
+unsigned int first_fit_vec(const problem& p, unsigned int* positions, double& time)
 {
-	unsigned int* sorted_objects = new unsigned int[n];
-	memcpy(sorted_objects, objects, n*sizeof(unsigned int));
-
-	unsigned int num_bins;
+	if(positions != NULL)
+		return(first_fit_vec_bins<true>(p, positions, time));
+	else
+		return(first_fit_vec_bins<false>(p, positions, time));
+}
 
-	clock_t start = clock();
-	sort(sorted_objects, n, sizeof(unsigned int), compare_uints); 
-	num_bins = first_fit_vec(sorted_objects, time);
-	clock_t end = clock();
+/*!
+	Applies the "First-Fit-Decreasing" heuristic to the current problem
+	using the STL vector class. The positions array may be NULL. The time
+	does not include sorting.
+*/
 
-	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
-		
-	delete[] sorted_objects;
-	return(num_bins);
+unsigned int first_fit_decreasing_vec(const problem& p, unsigned int* positions, double& time)
+{
+	return(first_fit_vec(decreasing(p), positions, time));
 }
 
 /*!
-	Implementation of First-Fit heuristic using STL maps, thus speeding up
-	the process of looking for a suitable bin.  The positions array is not
-	used in this implementation.
+	Implementation of First-Fit heuristic that uses a table indexed by
+	object size, thus speeding up the process of looking for a suitable
+	bin. Bins are never moved, so recording positions only costs a store
+	per object. The positions array may be NULL.
 */
 
-unsigned int first_fit_map(const unsigned int* objects, double& time)
+unsigned int first_fit_map(const problem& p, unsigned int* positions, double& time)
 {
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = p.K;
+	const unsigned int max_size = p.max_size;
+
         unsigned int num_open_bins = 1;
         unsigned int num_full_bins = 0;
-        unsigned int* bins = new unsigned int[n];
+        unsigned int* bins = p.ws->borrow_zeroed<unsigned int>(WS_BINS, n);
 
-        memset(bins, 0, n*sizeof(unsigned int));
-
-	// The map associates an object weight to an index in the bin array.
+	// The table associates an object weight to an index in the bin array.
 	// The index signifies the minimum index at which an object of the
 	// current weight could be placed the last time. All bins with smaller
-	// index need not be checked.
-        std::map<unsigned int, unsigned int> bin_map;
+	// index need not be checked. The index only ever increases.
+        size_table bin_map(*p.ws, max_size, n);
 
         // This variable is set per object. It is the minimum capacity that is
         // required in order to fit the object into a certain bin.
@@ -228,17 +293,26 @@ unsigned int first_fit_map(const unsigned int* objects, double& time)
 	bool placed;
 
         clock_t start = clock();
+        long long traced = trace_begin();
         for(unsigned int i = 0; i < n; i++)
         {
+		if(stop_requested(p, i, num_open_bins+num_full_bins))
+			break;
+
                 placed = false;
+
+		unsigned int& first_bin = bin_map[objects[i]];
                 
 		required_capacity = K-objects[i];
-                for(unsigned int j = bin_map[objects[i]]; j < num_open_bins; j++)
+                for(unsigned int j = first_bin; j < num_open_bins; j++)
                 {
                         if(bins[j] <= required_capacity)
                         {
                                 bins[j] += objects[i];
-                                bin_map[objects[i]] = j;
+                                first_bin = j;
+
+				if(positions != NULL)
+					positions[i] = j;
 
                                 placed = true;
                                 break;
@@ -250,39 +324,340 @@ unsigned int first_fit_map(const unsigned int* objects, double& time)
                 if(!placed)
                 {
                         bins[num_open_bins] = objects[i];
-                        bin_map[objects[i]] = num_open_bins++;
+                        first_bin = num_open_bins++;
+
+			if(positions != NULL)
+				positions[i] = first_bin;
                 }
         }
 
         clock_t end = clock();
+        trace_end("pack", "pack", traced);
         time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
 
-        delete[] bins;
         return(num_open_bins+num_full_bins);
 }
 
 /*!
 	Applies the "First-Fit-Decreasing" heuristic to the current problem
-	using the STL map class. 
+	using a table indexed by object size. The positions array may be
+	NULL. The time does not include sorting.
 */
 
-unsigned int first_fit_decreasing_map(	const unsigned int* objects,
-					double& time,
-					void(*sort)(void*, size_t, size_t, int (*)(const void*, const void*)))
+unsigned int first_fit_decreasing_map(const problem& p, unsigned int* positions, double& time)
 {
-	unsigned int* sorted_objects = new unsigned int[n];
-	memcpy(sorted_objects, objects, n*sizeof(unsigned int));
+	return(first_fit_map(decreasing(p), positions, time));
+}
 
-	unsigned int num_bins;
+/*!
+	Minimum number of objects per shard of the sharded "First-Fit-
+	Decreasing"; smaller shards lose more bins in the merge than they
+	save in time.
+*/
 
-	clock_t start = clock();
-	sort(sorted_objects, n, sizeof(unsigned int), compare_uints); 
-	num_bins = first_fit_map(sorted_objects, time);
-	clock_t end = clock();
+static const unsigned int min_shard_size = 1 << 16;
+
+/*!
+	Packs every stride-th object with the "First-Fit" heuristic, using
+	per-size start bins as first_fit_map does. The objects of a shard are
+	sorted as well, so the search for an object starts at the bin that
+	received the last object of the same size.
+
+	@param p		Problem, for K and the maximum size
+	@param objects		First object of the shard
+	@param count		Number of objects of the shard
+	@param stride		Distance between two objects of the shard
+	@param ws		Scratch memory of the shard
+	@param bins		Will contain the fill levels of the bins; room
+				for count bins
+	@param positions	Will contain the bin of every object of the
+				shard, using the same stride
+
+	@return Number of bins of the shard.
+
+	The function is kept out of line: inlined into the task of a shard,
+	the compiler keeps less of the loop state in registers, which costs a
+	third of the packing speed.
+*/
+
+__attribute__((noinline)) static unsigned int first_fit_shard(	const problem& p, const unsigned int* objects, unsigned int count, unsigned int stride,
+					workspace& ws, unsigned int* bins, unsigned int* positions)
+{
+	const unsigned int K = p.K;
+
+	unsigned int num_bins = 0;
+	size_table bin_map(ws, p.max_size, count);
+
+	for(unsigned int t = 0; t < count; t++)
+	{
+		unsigned int size = objects[static_cast<size_t>(t)*stride];
+		unsigned int required_capacity = K-size;
+
+		unsigned int& first_bin = bin_map[size];
+
+		unsigned int j = first_bin;
+		while(j < num_bins && bins[j] > required_capacity)
+			j++;
+
+		if(j < num_bins)
+			bins[j] += size;
+		else
+			bins[num_bins++] = size;
+
+		first_bin = j;
+		positions[static_cast<size_t>(t)*stride] = j;
+	}
 
-	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
-		
-	delete[] sorted_objects;
 	return(num_bins);
 }
 
+/*!
+	Runs a task on a new thread, or on the calling thread if no thread
+	can be started.
+*/
+
+template<typename task> static void start_task(std::vector<std::thread>& threads, task f)
+{
+	try
+	{
+		threads.emplace_back(f);
+	}
+	catch(std::system_error&)
+	{
+		f();
+	}
+}
+
+/*!
+	Applies the "First-Fit-Decreasing" heuristic on several threads.
+
+	The sorted objects are dealt to the shards in turn, so every shard
+	receives every size class in the same proportion and is a scaled-down
+	copy of the whole instance. Each shard is packed independently with
+	per-size start bins; since a shard only ever scans its own bins, the
+	work per object shrinks with the number of shards even on a single
+	core.
+
+	Every shard ends with partially filled bins that the other shards
+	could have used. The merge dissolves all bins that are at most half
+	full and repacks their objects, largest first, with "Best-Fit" into
+	the free space of the kept bins of all shards or into new bins. Since
+	"First-Fit" never leaves two bins at most half full, this is at most
+	one bin per shard. Only kept bins that can take the smallest object
+	are candidates; "First-Fit" leaves no room for it in any bin before
+	the one that received it last, so there are few of them and the
+	merge is cheap. If it does not save bins, the original bins are kept.
+
+	Positions are always recorded. The time is wall-clock time and does
+	not include sorting.
+*/
+
+unsigned int first_fit_decreasing_sharded(const problem& p, unsigned int* positions, double& time)
+{
+	problem q = decreasing(p);
+
+	const unsigned int* objects = q.objects;
+	const unsigned int n = q.n;
+	const unsigned int K = q.K;
+
+	unsigned int num_shards = p.num_threads ? p.num_threads : std::thread::hardware_concurrency();
+	if(num_shards > n/min_shard_size)
+		num_shards = n/min_shard_size;
+	if(num_shards == 0)
+		num_shards = 1;
+
+	const unsigned int no_bin = 0xFFFFFFFF;
+
+	// The first shard uses the workspace of the problem, so that its
+	// memory is reused by repeated runs
+	std::vector<workspace> spaces(num_shards-1);
+	auto space = [&](unsigned int s) -> workspace& { return(s == 0 ? *p.ws : spaces[s-1]); };
+
+	std::vector<unsigned int> num_bins(num_shards);
+	std::vector<unsigned int> num_kept(num_shards);
+	std::vector< std::vector<unsigned int> > dissolved(num_shards);
+
+	// Kept bins of every shard that can take the smallest object, as
+	// pairs of their residual capacity and their number
+	std::vector< std::vector< std::pair<unsigned int, unsigned int> > > open_bins(num_shards);
+
+	// New numbers of the bins of every shard; they are borrowed once, as
+	// borrowing a slot again invalidates its contents
+	std::vector<unsigned int*> ids(num_shards);
+
+	const unsigned int min_size = n > 0 ? objects[n-1] : 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Pack every shard and mark its bins: kept bins are numbered from 0,
+	// dissolved bins are marked and their objects collected
+	std::vector<std::thread> threads;
+	for(unsigned int s = 0; s < num_shards; s++)
+	{
+		start_task(threads, [&, s]
+		{
+			trace_span span("shard", "pack");
+
+			unsigned int count = (n-s+num_shards-1)/num_shards;
+			unsigned int* bins = space(s).borrow<unsigned int>(WS_BINS, count);
+			ids[s] = space(s).borrow<unsigned int>(WS_NEXT, count);
+
+			num_bins[s] = first_fit_shard(q, objects+s, count, num_shards, space(s), bins, positions+s);
+
+			unsigned int kept = 0;
+			for(unsigned int j = 0; j < num_bins[s]; j++)
+			{
+				if(bins[j] <= K/2)
+					ids[s][j] = no_bin;
+				else
+				{
+					if(K-bins[j] >= min_size)
+						open_bins[s].push_back(std::make_pair(K-bins[j], kept));
+
+					ids[s][j] = kept++;
+				}
+			}
+
+			num_kept[s] = kept;
+			if(kept == num_bins[s])
+				return;
+
+			for(unsigned int i = s; i < n; i += num_shards)
+			{
+				if(ids[s][positions[i]] == no_bin)
+					dissolved[s].push_back(i);
+			}
+		});
+	}
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	long long traced = trace_begin();
+
+	// Global numbers of the kept bins
+	std::vector<unsigned int> offset(num_shards+1, 0);
+	for(unsigned int s = 0; s < num_shards; s++)
+		offset[s+1] = offset[s]+num_kept[s];
+
+	unsigned int base = offset[num_shards];
+
+	// Merge: the dissolved objects, largest first, go to the fullest bin
+	// that can take them, be it a kept bin or a new one. Bins are given
+	// by their global numbers; new bins follow all kept bins.
+	std::vector<unsigned int> items;
+	for(unsigned int s = 0; s < num_shards; s++)
+		items.insert(items.end(), dissolved[s].begin(), dissolved[s].end());
+
+	std::sort(items.begin(), items.end());
+
+	std::vector<unsigned int> merged(items.size());
+	std::multimap<unsigned int, unsigned int> residual;
+	unsigned int num_merged = 0;
+
+	if(!items.empty())
+	{
+		for(unsigned int s = 0; s < num_shards; s++)
+		{
+			for(size_t k = 0; k < open_bins[s].size(); k++)
+				residual.insert(std::make_pair(open_bins[s][k].first, offset[s]+open_bins[s][k].second));
+		}
+	}
+
+	for(size_t t = 0; t < items.size(); t++)
+	{
+		unsigned int size = objects[items[t]];
+
+		std::multimap<unsigned int, unsigned int>::iterator best = residual.lower_bound(size);
+		if(best != residual.end())
+		{
+			merged[t] = best->second;
+			residual.insert(std::make_pair(best->first-size, best->second));
+			residual.erase(best);
+		}
+		else
+		{
+			merged[t] = base+num_merged++;
+			residual.insert(std::make_pair(K-size, merged[t]));
+		}
+	}
+
+	unsigned int num_dissolved = 0;
+	for(unsigned int s = 0; s < num_shards; s++)
+		num_dissolved += num_bins[s]-num_kept[s];
+
+	// Keep the original bins if the merge does not save any
+	bool use_merge = num_merged < num_dissolved;
+	trace_end("merge", "pack", traced);
+
+	// Translate the local bins of all objects to global bins
+	threads.clear();
+
+	std::vector<unsigned int> dissolved_offset(num_shards+1, 0);
+	for(unsigned int s = 0; s < num_shards; s++)
+		dissolved_offset[s+1] = dissolved_offset[s]+num_bins[s]-num_kept[s];
+
+	for(unsigned int s = 0; s < num_shards; s++)
+	{
+		start_task(threads, [&, s]
+		{
+			trace_span span("renumber", "pack");
+
+			// Shards without dissolved bins are simply shifted
+			if(num_kept[s] == num_bins[s])
+			{
+				if(offset[s] != 0)
+				{
+					for(unsigned int i = s; i < n; i += num_shards)
+						positions[i] += offset[s];
+				}
+
+				return;
+			}
+
+			unsigned int* local = ids[s];
+
+			// Without the merge, dissolved bins get numbers after all
+			// kept bins
+			if(!use_merge)
+			{
+				unsigned int next_id = base+dissolved_offset[s];
+				for(unsigned int j = 0; j < num_bins[s]; j++)
+				{
+					if(local[j] == no_bin)
+						local[j] = next_id++;
+					else
+						local[j] += offset[s];
+				}
+			}
+			else
+			{
+				for(unsigned int j = 0; j < num_bins[s]; j++)
+				{
+					if(local[j] != no_bin)
+						local[j] += offset[s];
+				}
+			}
+
+			for(unsigned int i = s; i < n; i += num_shards)
+			{
+				if(local[positions[i]] != no_bin)
+					positions[i] = local[positions[i]];
+			}
+		});
+	}
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	if(use_merge)
+	{
+		for(size_t t = 0; t < items.size(); t++)
+			positions[items[t]] = merged[t];
+	}
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	time = std::chrono::duration<double>(end-start).count();
+
+	return(base + (use_merge ? num_merged : num_dissolved));
+}
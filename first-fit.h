@@ -9,17 +9,16 @@
 #ifndef FIRST_FIT_H
 #define FIRST_FIT_H
 
-unsigned int first_fit(const unsigned int*, unsigned int*, double&);
-unsigned int first_fit_decreasing(const unsigned int*, unsigned int*, double&);
+struct problem;
 
-unsigned int first_fit_vec(const unsigned int*, double&);
-unsigned int first_fit_map(const unsigned int*, double&);
+unsigned int first_fit(const problem&, unsigned int*, double&);
+unsigned int first_fit_decreasing(const problem&, unsigned int*, double&);
 
-unsigned int first_fit_decreasing_vec(	const unsigned int*, 
-					double&, 
-					void(*)(void*, size_t, size_t, int (*)(const void*, const void*)));
-unsigned int first_fit_decreasing_map(	const unsigned int*,
-					double&,
-					void(*)(void*, size_t, size_t, int (*)(const void*, const void*)));
+unsigned int first_fit_vec(const problem&, unsigned int*, double&);
+unsigned int first_fit_map(const problem&, unsigned int*, double&);
+
+unsigned int first_fit_decreasing_vec(const problem&, unsigned int*, double&);
+unsigned int first_fit_decreasing_map(const problem&, unsigned int*, double&);
+unsigned int first_fit_decreasing_sharded(const problem&, unsigned int*, double&);
 
 #endif
@@ -0,0 +1,74 @@
+/*!
+	@file	fixed-capacity.h
+	@brief	Dispatch of hot kernels to instantiations for a fixed capacity
+
+	Deployments usually pack with a single capacity. The hot kernels are
+	therefore templates over a capacity C: C = 0 reads K from the problem,
+	any other C is the capacity itself. Knowing K at compile time lets
+	the compiler narrow the bins, fold K-min_size, and keep per-size
+	tables small enough to live on the stack.
+
+	The capacities that are instantiated are listed by an X-macro and may
+	be replaced at build time, e.g.
+
+	@code
+	make clean all DEFINES='-D"BIN_PACKING_FIXED_CAPACITIES(X)=X(100) X(128)"'
+	@endcode
+
+	Defining the list as empty leaves only the generic instantiation.
+
+	@author Bastian Rieck
+*/
+
+#ifndef FIXED_CAPACITY_H
+#define FIXED_CAPACITY_H
+
+#include "bin-packing.h"
+
+#ifndef BIN_PACKING_FIXED_CAPACITIES
+	#define BIN_PACKING_FIXED_CAPACITIES(X) X(100) X(1000)
+#endif
+
+/*!
+	Runs a kernel with the instantiation that matches the capacity of the
+	problem, or with the generic instantiation. A kernel is a class with a
+	static member template run<C>() that has the signature of a heuristic.
+*/
+
+template<typename kernel> unsigned int dispatch_capacity(const problem& p, unsigned int* positions, double& time)
+{
+	switch(p.K)
+	{
+		#define BIN_PACKING_CAPACITY_CASE(C) \
+			case C: return(kernel::template run<C>(p, positions, time));
+
+		BIN_PACKING_FIXED_CAPACITIES(BIN_PACKING_CAPACITY_CASE)
+
+		#undef BIN_PACKING_CAPACITY_CASE
+
+		default:
+			return(kernel::template run<0>(p, positions, time));
+	}
+}
+
+/*!
+	@return true if the kernels have been instantiated for a capacity.
+*/
+
+inline bool is_fixed_capacity(unsigned int K)
+{
+	switch(K)
+	{
+		#define BIN_PACKING_CAPACITY_CASE(C) \
+			case C: return(true);
+
+		BIN_PACKING_FIXED_CAPACITIES(BIN_PACKING_CAPACITY_CASE)
+
+		#undef BIN_PACKING_CAPACITY_CASE
+
+		default:
+			return(false);
+	}
+}
+
+#endif
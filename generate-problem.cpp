@@ -0,0 +1,1623 @@
+/*!
+	@file	generate-problem.cpp
+	@brief	Generator for problem instances and scaling sweeps
+
+	Writes instances of a given family in the text format of the data
+	files or in the binary format of instance-format.h. Items are produced
+	in blocks, so the size of an instance is only limited by the disk. All
+	families are reproducible from their seed.
+
+	Available families:
+
+	- uniform:	sizes drawn uniformly from [1,K]
+	- triplets:	Falkenauer-style triplets; every consecutive group of
+			three items sums to exactly K, and the items of a block
+			are shuffled. The optimum uses exactly n/3 bins.
+	- heavy:	bounded Pareto distribution; mostly small items with a
+			few large ones
+	- few:		only a small number of distinct sizes
+	- adversarial-ff, adversarial-bf:
+			groups of K/7+1, K/3+1, and K/2+1 items in this order.
+			First-Fit and Best-Fit open 5m/3 bins, the optimum uses m.
+	- adversarial-nf:
+			alternating items of size K/2 and 1. Next-Fit opens n/2
+			bins, the optimum uses about n/4.
+
+	In sweep mode, instances of the family are packed by every heuristic
+	of the library for a range of n and K, and a power law t = c*n^a*K^b
+	is fitted to the running times of every heuristic.
+
+	The shard benchmark packs an instance of the family with the sharded
+	First-Fit-Decreasing for several shard counts and reports the bins it
+	loses and the time it saves compared to the sequential heuristic.
+
+	The concurrent benchmark splits an instance of the family among
+	several producer threads that pack their items into shared bins at
+	once, and reports the throughput and the bins compared to the
+	sequential "Best-Fit" and "Next-Fit".
+
+	Vector instances with d dimensions draw every dimension independently
+	from the family, with capacity K in every dimension. The vector
+	benchmark packs such instances for several d and compares the cost
+	per item with the 1D First-Fit on the first dimension alone.
+
+	In calibration mode, instances of all families are packed by the
+	heuristics of the automatic selection, and the calibration table of
+	its cost model is written.
+
+	In validation mode, every optimized heuristic is compared with its
+	reference implementation on instances of all families and on edge
+	cases, and all instances on which the bins differ by more than the
+	breaking of ties are reported. The exit status is 1 in this case.
+
+	@author Bastian Rieck
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <getopt.h>
+
+#include "bin-packing-api.h"
+#include "instance-format.h"
+
+using namespace std;
+
+/*!
+	Families of instances.
+*/
+
+enum family
+{
+	FAMILY_UNIFORM,
+	FAMILY_TRIPLETS,
+	FAMILY_HEAVY,
+	FAMILY_FEW,
+	FAMILY_ADVERSARIAL_FIT,
+	FAMILY_ADVERSARIAL_NF,
+	FAMILY_UNKNOWN
+};
+
+/*!
+	Parameters of an instance.
+*/
+
+struct generator_options
+{
+	family f;
+	unsigned long long n;	///< Below 2^32 except for single instances
+	unsigned int K;
+	unsigned long long seed;
+	double alpha;		///< Shape of the heavy-tailed family
+	unsigned int distinct;	///< Number of sizes of the few-distinct family
+};
+
+/*!
+	Number of items produced at once; a multiple of 3 so that triplets
+	never span two blocks.
+*/
+
+static const unsigned int block_size = 3*(1 << 16);
+
+/*!
+	Small and fast pseudo-random number generator (SplitMix64). Its
+	output only depends on the seed, so instances can be reproduced on
+	every platform.
+*/
+
+class random_generator
+{
+	public:
+		random_generator(unsigned long long seed)
+			: state(seed)
+		{
+		}
+
+		unsigned long long next()
+		{
+			unsigned long long z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27))*0x94D049BB133111EBull;
+			return(z ^ (z >> 31));
+		}
+
+		/*!
+			@return Uniformly distributed number in [lo,hi].
+		*/
+
+		unsigned int uniform(unsigned int lo, unsigned int hi)
+		{
+			unsigned long long range = static_cast<unsigned long long>(hi)-lo+1;
+			return(lo + static_cast<unsigned int>(((next() >> 32)*range) >> 32));
+		}
+
+		/*!
+			@return Uniformly distributed number in (0,1].
+		*/
+
+		double real()
+		{
+			return(((next() >> 11) + 1)*(1.0/9007199254740992.0));
+		}
+
+	private:
+		unsigned long long state;
+};
+
+/*!
+	Produces the items of an instance block by block.
+*/
+
+class instance_generator
+{
+	public:
+		instance_generator(const generator_options& options)
+			: options(options), rng(options.seed), position(0)
+		{
+			// The few distinct sizes are fixed for the whole
+			// instance
+			if(options.f == FAMILY_FEW)
+			{
+				for(unsigned int i = 0; i < options.distinct; i++)
+					sizes.push_back(rng.uniform(1, options.K));
+			}
+		}
+
+		/*!
+			Fills a block with the next items of the instance.
+
+			@param block	Array of at least block_size entries
+			@param count	Number of items to generate
+		*/
+
+		void fill(unsigned int* block, unsigned int count)
+		{
+			const unsigned int K = options.K;
+			switch(options.f)
+			{
+				case FAMILY_UNIFORM:
+					for(unsigned int i = 0; i < count; i++)
+						block[i] = rng.uniform(1, K);
+					break;
+
+				case FAMILY_TRIPLETS:
+					for(unsigned int i = 0; i+2 < count; i += 3)
+					{
+						// a is in [K/4,K/2], b in [K/4,(K-a)/2],
+						// so c = K-a-b is in [K/4,K/2] as well
+						unsigned int a = rng.uniform(K/4, K/2);
+						unsigned int b = rng.uniform(K/4, (K-a)/2);
+
+						block[i]   = a;
+						block[i+1] = b;
+						block[i+2] = K-a-b;
+					}
+
+					for(unsigned int i = count-count%3; i < count; i++)
+						block[i] = rng.uniform(K/4, K/2);
+
+					for(unsigned int i = count; i > 1; i--)
+						swap(block[i-1], block[rng.uniform(0, i-1)]);
+					break;
+
+				case FAMILY_HEAVY:
+				{
+					double scale = K/1000.0 > 1.0 ? K/1000.0 : 1.0;
+					for(unsigned int i = 0; i < count; i++)
+					{
+						double size = ceil(scale*pow(rng.real(), -1.0/options.alpha));
+						block[i] = size < K ? static_cast<unsigned int>(size) : K;
+					}
+					break;
+				}
+
+				case FAMILY_FEW:
+					for(unsigned int i = 0; i < count; i++)
+						block[i] = sizes[rng.uniform(0, options.distinct-1)];
+					break;
+
+				case FAMILY_ADVERSARIAL_FIT:
+				{
+					unsigned long long third = options.n/3;
+					for(unsigned int i = 0; i < count; i++)
+					{
+						unsigned long long j = position+i;
+						if(j < third)
+							block[i] = K/7+1;
+						else if(j < 2*third)
+							block[i] = K/3+1;
+						else
+							block[i] = K/2+1;
+					}
+					break;
+				}
+
+				case FAMILY_ADVERSARIAL_NF:
+					for(unsigned int i = 0; i < count; i++)
+						block[i] = ((position+i) % 2 == 0) ? (K+1)/2 : 1;
+					break;
+
+				default:
+					break;
+			}
+
+			position += count;
+		}
+
+	private:
+		generator_options options;
+		random_generator rng;
+
+		unsigned long long position;	///< Number of items generated so far
+		vector<unsigned int> sizes;	///< Sizes of the few-distinct family
+};
+
+/*!
+	@return Family for a given name, or FAMILY_UNKNOWN.
+*/
+
+family parse_family(const char* name)
+{
+	static const char* names[] = { "uniform", "triplets", "heavy", "few", "adversarial-ff", "adversarial-bf", "adversarial-nf" };
+	static const family families[] = { FAMILY_UNIFORM, FAMILY_TRIPLETS, FAMILY_HEAVY, FAMILY_FEW, FAMILY_ADVERSARIAL_FIT, FAMILY_ADVERSARIAL_FIT, FAMILY_ADVERSARIAL_NF };
+
+	for(unsigned int i = 0; i < sizeof(names)/sizeof(names[0]); i++)
+		if(strcmp(name, names[i]) == 0)
+			return(families[i]);
+
+	return(FAMILY_UNKNOWN);
+}
+
+/*!
+	Checks whether the family can be generated with the given parameters.
+
+	@return Error message, or NULL if the parameters are valid.
+*/
+
+const char* check_options(const generator_options& options)
+{
+	if(options.n == 0 || options.K == 0)
+		return("n and K have to be positive");
+
+	if(options.f == FAMILY_TRIPLETS && options.K < 4)
+		return("triplets require K >= 4");
+
+	if(options.f == FAMILY_ADVERSARIAL_FIT && options.K < 126)
+		return("adversarial-ff/bf require K >= 126");
+
+	if(options.f == FAMILY_ADVERSARIAL_NF && options.K < 2)
+		return("adversarial-nf requires K >= 2");
+
+	if(options.f == FAMILY_HEAVY && options.alpha <= 0.0)
+		return("alpha has to be positive");
+
+	if(options.f == FAMILY_FEW && options.distinct == 0)
+		return("the number of distinct sizes has to be positive");
+
+	return(NULL);
+}
+
+/*!
+	Buffered writer for the text format. Numbers are formatted by hand,
+	which is considerably faster than stdio or streams.
+*/
+
+class text_writer
+{
+	public:
+		text_writer(FILE* out)
+			: out(out), length(0)
+		{
+		}
+
+		~text_writer()
+		{
+			flush();
+		}
+
+		void write(unsigned long long x)
+		{
+			if(length+21 > sizeof(buffer))
+				flush();
+
+			char digits[20];
+			unsigned int num_digits = 0;
+			do
+			{
+				digits[num_digits++] = '0' + x%10;
+				x /= 10;
+			}
+			while(x > 0);
+
+			while(num_digits > 0)
+				buffer[length++] = digits[--num_digits];
+
+			buffer[length++] = '\n';
+		}
+
+		void flush()
+		{
+			fwrite(buffer, 1, length, out);
+			length = 0;
+		}
+
+	private:
+		FILE* out;
+		char buffer[1 << 20];
+		size_t length;
+};
+
+/*!
+	Writes an instance.
+
+	@param options	Parameters of the instance
+	@param binary	Whether to use the binary format
+	@param out	Output file
+
+	@return true on success.
+*/
+
+bool write_instance(const generator_options& options, bool binary, FILE* out)
+{
+	instance_generator generator(options);
+	vector<unsigned int> block(block_size);
+
+	text_writer* text = binary ? NULL : new text_writer(out);
+	if(binary && options.n > UINT_MAX)
+	{
+		large_instance_header header;
+		header.magic	= large_instance_magic;
+		header.K	= options.K;
+		header.n	= options.n;
+
+		fwrite(&header, sizeof(header), 1, out);
+	}
+	else if(binary)
+	{
+		instance_header header;
+		header.magic	= instance_magic;
+		header.n	= static_cast<uint32_t>(options.n);
+		header.K	= options.K;
+
+		fwrite(&header, sizeof(header), 1, out);
+	}
+	else
+	{
+		text->write(options.n);
+		text->write(options.K);
+	}
+
+	for(unsigned long long i = 0; i < options.n; i += block_size)
+	{
+		unsigned int count = static_cast<unsigned int>(min<unsigned long long>(block_size, options.n-i));
+		generator.fill(&block[0], count);
+
+		if(binary)
+			fwrite(&block[0], sizeof(unsigned int), count, out);
+		else
+		{
+			for(unsigned int j = 0; j < count; j++)
+				text->write(block[j]);
+		}
+	}
+
+	delete text;
+	return(fflush(out) == 0 && !ferror(out));
+}
+
+/*!
+	@return Generator for dimension k of a vector instance.
+*/
+
+generator_options dimension_options(generator_options options, unsigned int k)
+{
+	options.seed += k;
+	return(options);
+}
+
+/*!
+	Writes a vector instance. The text format lists the d demands of every
+	item in turn, so the dimensions are generated in lockstep; the binary
+	format stores one dimension after the other.
+
+	@param options	Parameters of the instance
+	@param d	Number of dimensions
+	@param binary	Whether to use the binary format
+	@param out	Output file
+
+	@return true on success.
+*/
+
+bool write_vector_instance(const generator_options& options, unsigned int d, bool binary, FILE* out)
+{
+	vector<unsigned int> capacity(d, options.K);
+
+	if(binary)
+	{
+		vector_instance_header header;
+		header.magic	= vector_instance_magic;
+		header.n	= static_cast<uint32_t>(options.n);
+		header.d	= d;
+
+		fwrite(&header, sizeof(header), 1, out);
+		fwrite(&capacity[0], sizeof(unsigned int), d, out);
+
+		vector<unsigned int> block(block_size);
+		for(unsigned int k = 0; k < d; k++)
+		{
+			instance_generator generator(dimension_options(options, k));
+			for(unsigned int i = 0; i < options.n; i += block_size)
+			{
+				unsigned int count = min(block_size, static_cast<unsigned int>(options.n-i));
+				generator.fill(&block[0], count);
+				fwrite(&block[0], sizeof(unsigned int), count, out);
+			}
+		}
+
+		return(fflush(out) == 0 && !ferror(out));
+	}
+
+	text_writer* text = new text_writer(out);
+	text->write(options.n);
+	for(unsigned int k = 0; k < d; k++)
+		text->write(capacity[k]);
+
+	vector<instance_generator> generators;
+	for(unsigned int k = 0; k < d; k++)
+		generators.push_back(instance_generator(dimension_options(options, k)));
+
+	vector< vector<unsigned int> > blocks(d, vector<unsigned int>(block_size));
+	for(unsigned int i = 0; i < options.n; i += block_size)
+	{
+		unsigned int count = min(block_size, static_cast<unsigned int>(options.n-i));
+		for(unsigned int k = 0; k < d; k++)
+			generators[k].fill(&blocks[k][0], count);
+
+		for(unsigned int j = 0; j < count; j++)
+			for(unsigned int k = 0; k < d; k++)
+				text->write(blocks[k][j]);
+	}
+
+	delete text;
+	return(fflush(out) == 0 && !ferror(out));
+}
+
+/*!
+	Generates the demands of a vector instance as structure of arrays.
+*/
+
+vector<unsigned int> generate_vector_items(const generator_options& options, unsigned int d)
+{
+	vector<unsigned int> items(static_cast<size_t>(options.n)*d);
+	for(unsigned int k = 0; k < d; k++)
+	{
+		instance_generator generator(dimension_options(options, k));
+		for(unsigned int i = 0; i < options.n; i += block_size)
+			generator.fill(&items[static_cast<size_t>(k)*options.n+i], min(block_size, static_cast<unsigned int>(options.n-i)));
+	}
+
+	return(items);
+}
+
+/*!
+	Packs vector instances of the family for several numbers of
+	dimensions and reports the cost per item of every vector heuristic,
+	relative to the 1D First-Fit on the first dimension of the same
+	instance.
+
+	@param options		Family, n, K and seed
+	@param dimensions	Numbers of dimensions
+*/
+
+int vector_benchmark(const generator_options& options, const vector<unsigned int>& dimensions)
+{
+	bp_context* ctx = bp_context_create();
+
+	cout	<< setw(4) << right << "d" << "  "
+		<< setw(30) << left << "Heuristic"
+		<< setw(10) << right << "Bins"
+		<< setw(12) << "Time [s]"
+		<< setw(12) << "ns/item"
+		<< setw(10) << "vs. 1D" << "\n";
+
+	for(size_t t = 0; t < dimensions.size(); t++)
+	{
+		unsigned int d = dimensions[t];
+		vector<unsigned int> items = generate_vector_items(options, d);
+		vector<unsigned int> capacity(d, options.K);
+
+		// The first dimension is an ordinary 1D instance
+		bp_result reference;
+		if(	bp_set_instance(ctx, &items[0], options.n, options.K) != BP_OK ||
+			bp_run(ctx, BP_FIRST_FIT, NULL, &reference) != BP_OK ||
+			bp_set_vector_instance(ctx, &items[0], options.n, d, &capacity[0]) != BP_OK)
+		{
+			cerr << "generate-problem: Unable to pack instance\n";
+			bp_context_destroy(ctx);
+			return(-1);
+		}
+
+		cout	<< setw(4) << right << 1 << "  "
+			<< setw(30) << left << bp_heuristic_name(BP_FIRST_FIT)
+			<< setw(10) << right << reference.num_bins
+			<< setw(12) << fixed << setprecision(4) << reference.time
+			<< setw(12) << setprecision(1) << 1e9*reference.time/options.n
+			<< setw(10) << setprecision(2) << 1.0 << "\n";
+
+		for(int h = 0; h < BP_NUM_VECTOR_HEURISTICS; h++)
+		{
+			bp_vector_heuristic vh = static_cast<bp_vector_heuristic>(h);
+
+			bp_result result;
+			if(bp_run_vector(ctx, vh, NULL, &result) != BP_OK)
+				continue;
+
+			cout	<< setw(4) << right << d << "  "
+				<< setw(30) << left << bp_vector_heuristic_name(vh)
+				<< setw(10) << right << result.num_bins
+				<< setw(12) << fixed << setprecision(4) << result.time
+				<< setw(12) << setprecision(1) << 1e9*result.time/options.n
+				<< setw(10) << setprecision(2) << (reference.time > 0 ? result.time/reference.time : 0.0) << "\n";
+		}
+
+		cout << "\n";
+	}
+
+	bp_context_destroy(ctx);
+	return(0);
+}
+
+/*!
+	Packs an instance of the family with the sequential and the sharded
+	First-Fit-Decreasing, one thread per shard, and reports the penalty
+	in bins and the speedup for every number of shards. Sorting is done
+	once and counts for neither. Both heuristics report an assignment,
+	since the sharded one needs it for the merge anyway.
+
+	@param options	Family, n, K and seed
+	@param shards	Numbers of shards
+*/
+
+int shard_benchmark(const generator_options& options, const vector<unsigned int>& shards)
+{
+	vector<unsigned int> items(options.n);
+
+	instance_generator generator(options);
+	for(unsigned int i = 0; i < options.n; i += block_size)
+		generator.fill(&items[i], min(block_size, static_cast<unsigned int>(options.n-i)));
+
+	vector<unsigned int> assignment(options.n);
+	bp_context* ctx = bp_context_create();
+
+	bp_result reference;
+	if(	bp_set_instance(ctx, &items[0], options.n, options.K) != BP_OK ||
+		bp_run(ctx, BP_FIRST_FIT_DECREASING_MAP, &assignment[0], &reference) != BP_OK)
+	{
+		cerr << "generate-problem: Unable to pack instance\n";
+		bp_context_destroy(ctx);
+		return(-1);
+	}
+
+	cout	<< setw(8) << right << "Shards"
+		<< setw(12) << "Bins"
+		<< setw(10) << "Penalty"
+		<< setw(12) << "Penalty %"
+		<< setw(12) << "Time [s]"
+		<< setw(10) << "Speedup" << "\n";
+
+	cout	<< setw(8) << "-"
+		<< setw(12) << reference.num_bins
+		<< setw(10) << 0
+		<< setw(12) << fixed << setprecision(4) << 0.0
+		<< setw(12) << reference.time
+		<< setw(10) << setprecision(2) << 1.0 << "\n";
+
+	for(size_t t = 0; t < shards.size(); t++)
+	{
+		bp_result result;
+		if(	bp_set_num_threads(ctx, shards[t]) != BP_OK ||
+			bp_run(ctx, BP_FIRST_FIT_DECREASING_SHARDED, &assignment[0], &result) != BP_OK)
+			continue;
+
+		long long penalty = static_cast<long long>(result.num_bins)-reference.num_bins;
+
+		cout	<< setw(8) << shards[t]
+			<< setw(12) << result.num_bins
+			<< setw(10) << penalty
+			<< setw(12) << setprecision(4) << 100.0*penalty/reference.num_bins
+			<< setw(12) << result.time
+			<< setw(10) << setprecision(2) << (result.time > 0 ? reference.time/result.time : 0.0) << "\n";
+	}
+
+	bp_context_destroy(ctx);
+	return(0);
+}
+
+/*!
+	Number of items that a producer of the concurrent benchmark passes
+	at once.
+*/
+
+static const size_t producer_block = 1024;
+
+/*!
+	Adds the items of one producer to the shared bins, block by block.
+
+	@param status	Receives the first error
+*/
+
+void produce(bp_concurrent* conc, unsigned int producer, const unsigned int* items, unsigned int* assignment, size_t count, int* status)
+{
+	*status = BP_OK;
+	for(size_t i = 0; i < count && *status == BP_OK; i += producer_block)
+		*status = bp_concurrent_add(conc, producer, items+i, min(producer_block, count-i), assignment+i);
+}
+
+/*!
+	Packs an instance of the family with several producer threads at
+	once, every thread adding a contiguous slice of the items to shared
+	bins, and reports the throughput in wall-clock time and the bins
+	compared to the sequential "Best-Fit" and "Next-Fit". Every
+	assignment is verified.
+
+	@param options		Family, n, K and seed
+	@param producers	Numbers of producers
+*/
+
+int concurrent_benchmark(const generator_options& options, const vector<unsigned int>& producers)
+{
+	vector<unsigned int> items(options.n);
+
+	instance_generator generator(options);
+	for(unsigned int i = 0; i < options.n; i += block_size)
+		generator.fill(&items[i], min(block_size, static_cast<unsigned int>(options.n-i)));
+
+	// The lookup table of "Best-Fit" is only affordable for small K
+	bp_heuristic reference = (options.K <= (1u << 16)) ? BP_BEST_FIT_LOOKUP : BP_BEST_FIT_HEAP;
+	bp_context* ctx = bp_context_create();
+
+	bp_result best_fit, next_fit;
+	if(	bp_set_instance(ctx, &items[0], options.n, options.K) != BP_OK ||
+		bp_run(ctx, reference, NULL, &best_fit) != BP_OK ||
+		bp_run(ctx, BP_NEXT_FIT, NULL, &next_fit) != BP_OK)
+	{
+		cerr << "generate-problem: Unable to pack instance\n";
+		bp_context_destroy(ctx);
+		return(-1);
+	}
+
+	bp_context_destroy(ctx);
+
+	cout	<< "Best-Fit: " << best_fit.num_bins << " bins in " << fixed << setprecision(4) << best_fit.time << " s, "
+		<< "Next-Fit: " << next_fit.num_bins << " bins in " << next_fit.time << " s\n\n";
+
+	cout	<< setw(10) << right << "Producers"
+		<< setw(12) << "Bins"
+		<< setw(12) << "Penalty %"
+		<< setw(12) << "Time [s]"
+		<< setw(12) << "Mitems/s"
+		<< setw(10) << "Speedup"
+		<< setw(10) << "Hint %"
+		<< setw(10) << "Pool %"
+		<< setw(12) << "Retries" << "\n";
+
+	vector<unsigned int> assignment(options.n);
+	double first_time = 0.0;	// Speedups are relative to the first number of producers
+
+	for(size_t t = 0; t < producers.size(); t++)
+	{
+		unsigned int num_producers = producers[t];
+
+		bp_concurrent* conc = bp_concurrent_create(options.K, num_producers);
+		if(conc == NULL)
+			continue;
+
+		vector<thread> threads;
+		vector<int> status(num_producers);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for(unsigned int p = 0; p < num_producers; p++)
+		{
+			size_t first = options.n*p/num_producers;
+			size_t last  = options.n*(p+1)/num_producers;
+
+			threads.push_back(thread(produce, conc, p, &items[first], &assignment[first], last-first, &status[p]));
+		}
+
+		for(size_t p = 0; p < threads.size(); p++)
+			threads[p].join();
+
+		double time = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+		bp_concurrent_stats stats;
+		bp_concurrent_get_stats(conc, &stats);
+		bp_concurrent_destroy(conc);
+
+		bool failed = false;
+		for(unsigned int p = 0; p < num_producers; p++)
+			failed = failed || (status[p] != BP_OK);
+
+		if(failed || bp_verify_assignment(&items[0], options.n, options.K, &assignment[0], stats.num_bins, NULL) != BP_OK)
+		{
+			cerr << "generate-problem: Invalid assignment with " << num_producers << " producers\n";
+			return(-1);
+		}
+
+		if(t == 0)
+			first_time = time;
+
+		long long penalty = static_cast<long long>(stats.num_bins)-best_fit.num_bins;
+
+		cout	<< setw(10) << num_producers
+			<< setw(12) << stats.num_bins
+			<< setw(12) << setprecision(4) << 100.0*penalty/best_fit.num_bins
+			<< setw(12) << time
+			<< setw(12) << setprecision(2) << (time > 0 ? options.n/time/1e6 : 0.0)
+			<< setw(10) << (time > 0 ? first_time/time : 0.0)
+			<< setw(10) << 100.0*stats.hint_hits/options.n
+			<< setw(10) << 100.0*stats.pool_hits/options.n
+			<< setw(12) << stats.cas_failures << "\n";
+	}
+
+	return(0);
+}
+
+/*!
+	A single measurement of the sweep.
+*/
+
+struct sweep_sample
+{
+	unsigned int n;
+	unsigned int K;
+	double time;
+};
+
+/*!
+	Fits log(t) = c + a*log(n) + b*log(K) by least squares. Samples below
+	the resolution of the timer are ignored. If K does not vary, b is set
+	to 0.
+
+	@return false if there are not enough samples.
+*/
+
+bool fit_power_law(const vector<sweep_sample>& samples, double& c, double& a, double& b)
+{
+	const double resolution = 1e-3;
+
+	// Normal equations for the parameters (c, a, b)
+	double m[3][4] = { { 0 } };
+	unsigned int num_samples = 0;
+	bool varying_K = false;
+
+	for(size_t i = 0; i < samples.size(); i++)
+	{
+		if(samples[i].time < resolution)
+			continue;
+
+		double x[3] = { 1.0, log(static_cast<double>(samples[i].n)), log(static_cast<double>(samples[i].K)) };
+		double y = log(samples[i].time);
+
+		for(unsigned int r = 0; r < 3; r++)
+		{
+			for(unsigned int s = 0; s < 3; s++)
+				m[r][s] += x[r]*x[s];
+
+			m[r][3] += x[r]*y;
+		}
+
+		varying_K = varying_K || samples[i].K != samples[0].K;
+		num_samples++;
+	}
+
+	unsigned int dimension = varying_K ? 3 : 2;
+	if(num_samples < dimension+1)
+		return(false);
+
+	// Gaussian elimination with partial pivoting
+	for(unsigned int col = 0; col < dimension; col++)
+	{
+		unsigned int pivot = col;
+		for(unsigned int r = col+1; r < dimension; r++)
+			if(fabs(m[r][col]) > fabs(m[pivot][col]))
+				pivot = r;
+
+		if(fabs(m[pivot][col]) < 1e-12)
+			return(false);
+
+		for(unsigned int s = 0; s < 4; s++)
+			swap(m[col][s], m[pivot][s]);
+
+		for(unsigned int r = 0; r < dimension; r++)
+		{
+			if(r == col)
+				continue;
+
+			double factor = m[r][col]/m[col][col];
+			for(unsigned int s = col; s < 4; s++)
+				m[r][s] -= factor*m[col][s];
+		}
+	}
+
+	c = exp(m[0][3]/m[0][0]);
+	a = m[1][3]/m[1][1];
+	b = varying_K ? m[2][3]/m[2][2] : 0.0;
+
+	return(true);
+}
+
+/*!
+	Packs instances of a family with every heuristic for n = n_min,
+	2*n_min, ..., n_max and every capacity in a list. A heuristic is no
+	longer run for larger n once a single run of it exceeds the time
+	budget for a given K.
+
+	@param options		Family and seed; n is the largest n
+	@param capacities	Capacities to sweep
+	@param n_min		Smallest n
+	@param budget		Time budget for a single run, in seconds
+*/
+
+int sweep(generator_options options, const vector<unsigned int>& capacities, unsigned int n_min, double budget)
+{
+	const unsigned int n_max = static_cast<unsigned int>(options.n);
+
+	bp_context* ctx = bp_context_create();
+	vector< vector<sweep_sample> > samples(BP_NUM_HEURISTICS);
+
+	cout	<< setw(10) << right << "n" << setw(10) << "K" << "  "
+		<< setw(26) << left << "Heuristic"
+		<< setw(10) << right << "Bins"
+		<< setw(12) << "Time [s]" << "\n";
+
+	for(size_t k = 0; k < capacities.size(); k++)
+	{
+		options.K = capacities[k];
+		vector<bool> exhausted(BP_NUM_HEURISTICS, false);
+
+		for(unsigned long long n = n_min; n <= n_max; n *= 2)
+		{
+			options.n = static_cast<unsigned int>(n);
+
+			const char* error = check_options(options);
+			if(error != NULL)
+			{
+				cerr << "generate-problem: " << error << "\n";
+				bp_context_destroy(ctx);
+				return(-1);
+			}
+
+			vector<unsigned int> items(options.n);
+			instance_generator generator(options);
+			for(unsigned int i = 0; i < options.n; i += block_size)
+				generator.fill(&items[i], min(block_size, static_cast<unsigned int>(options.n-i)));
+
+			bp_set_instance(ctx, &items[0], options.n, options.K);
+
+			for(int h = 0; h < BP_NUM_HEURISTICS; h++)
+			{
+				if(exhausted[h])
+					continue;
+
+				bp_result result;
+				if(bp_run(ctx, static_cast<bp_heuristic>(h), NULL, &result) != BP_OK)
+					continue;
+
+				sweep_sample s = { static_cast<unsigned int>(options.n), options.K, result.time };
+				samples[h].push_back(s);
+
+				exhausted[h] = result.time > budget;
+
+				cout	<< setw(10) << right << options.n << setw(10) << options.K << "  "
+					<< setw(26) << left << bp_heuristic_name(static_cast<bp_heuristic>(h))
+					<< setw(10) << right << result.num_bins
+					<< setw(12) << fixed << setprecision(4) << result.time << "\n";
+			}
+		}
+	}
+
+	bp_context_destroy(ctx);
+
+	cout << "\nFitted running times t = c * n^a * K^b:\n\n";
+	for(int h = 0; h < BP_NUM_HEURISTICS; h++)
+	{
+		cout << setw(26) << left << (string(bp_heuristic_name(static_cast<bp_heuristic>(h))) + ":");
+
+		double c, a, b;
+		if(fit_power_law(samples[h], c, a, b))
+		{
+			cout	<< scientific << setprecision(2) << "c = " << c << ", "
+				<< fixed << "a = " << a << ", b = " << b << "\n";
+		}
+		else
+			cout << "not enough samples above the timer resolution\n";
+	}
+
+	return(0);
+}
+
+/*!
+	Measures the running time of a heuristic, including the time for
+	sorting if it requires the items to be sorted. The instance is set
+	again before every run, so that sorting is not shared between the
+	heuristics. The fastest of several runs is taken.
+
+	@return false if the heuristic could not pack the instance.
+*/
+
+bool measure(bp_context* ctx, const vector<unsigned int>& items, unsigned int n, unsigned int K, bp_heuristic heuristic, bp_result& result)
+{
+	const unsigned int repetitions = 3;
+
+	// Long runs are hardly affected by noise
+	for(unsigned int r = 0; r < repetitions && (r == 0 || result.time < 0.1); r++)
+	{
+		bp_result run;
+		if(	bp_set_instance(ctx, &items[0], n, K) != BP_OK ||
+			bp_run(ctx, heuristic, NULL, &run) != BP_OK)
+			return(false);
+
+		double sorting;
+		if(bp_sorting_time(ctx, &sorting) == BP_OK)
+			run.time += sorting;
+
+		if(r == 0 || run.time < result.time)
+			result = run;
+	}
+
+	return(true);
+}
+
+/*!
+	Writes the calibration table of the cost model that selects
+	heuristics automatically (see heuristic-selection.cpp). Instances of
+	every family are packed for every capacity by all heuristics the
+	model knows about. For each of them, the table contains the features
+	of the instance and, per heuristic, the number of bins relative to
+	sum/K, the running time for n items, and the exponent of n in the
+	running time, which is estimated from a run on the first n/4 items.
+
+	@param options		Seed and n of the calibration instances
+	@param capacities	Capacities of the calibration instances
+*/
+
+int calibrate(generator_options options, const vector<unsigned int>& capacities)
+{
+	static const char* names[] = { "uniform", "triplets", "heavy", "few", "adversarial-ff", "adversarial-nf" };
+	static const family families[] = { FAMILY_UNIFORM, FAMILY_TRIPLETS, FAMILY_HEAVY, FAMILY_FEW, FAMILY_ADVERSARIAL_FIT, FAMILY_ADVERSARIAL_NF };
+
+	const unsigned int n = static_cast<unsigned int>(options.n);
+	bp_context* ctx = bp_context_create();
+
+	for(unsigned int f = 0; f < sizeof(families)/sizeof(families[0]); f++)
+	{
+		for(size_t k = 0; k < capacities.size(); k++)
+		{
+			options.f = families[f];
+			options.K = capacities[k];
+
+			// Not every family exists for every capacity
+			if(check_options(options) != NULL)
+				continue;
+
+			vector<unsigned int> items(n);
+			instance_generator generator(options);
+			for(unsigned int i = 0; i < n; i += block_size)
+				generator.fill(&items[i], min(block_size, n-i));
+
+			// The selection reports all heuristics of the model
+			bp_selection selection;
+			if(	bp_set_instance(ctx, &items[0], n, options.K) != BP_OK ||
+				bp_select_heuristics(ctx, HUGE_VAL, &selection) != BP_OK)
+			{
+				cerr << "generate-problem: Unable to pack instance\n";
+				bp_context_destroy(ctx);
+				return(-1);
+			}
+
+			const bp_features& features = selection.features;
+
+			vector<bp_heuristic> heuristics;
+			for(size_t i = 0; i < selection.num_predictions; i++)
+				heuristics.push_back(selection.predictions[i].heuristic);
+
+			sort(heuristics.begin(), heuristics.end());
+
+			cout	<< "\t{ \"" << names[f] << "\", " << n << ", " << options.K << ", " << features.distinct << ", "
+				<< fixed << setprecision(4) << features.mean << ", " << features.deviation << ", "
+				<< features.skew << ", " << features.large << ",\n";
+
+			for(size_t i = 0; i < heuristics.size(); i++)
+			{
+				bp_result small, large;
+				if(	!measure(ctx, items, n/4, options.K, heuristics[i], small) ||
+					!measure(ctx, items, n, options.K, heuristics[i], large))
+				{
+					cerr << "generate-problem: Unable to pack instance\n";
+					bp_context_destroy(ctx);
+					return(-1);
+				}
+
+				// Times below the resolution of the timer are assumed
+				// to grow linearly
+				double exponent = 1.0;
+				if(small.time >= 1e-4)
+					exponent = log(large.time/small.time)/log(4.0);
+
+				exponent = max(1.0, min(exponent, 2.0));
+
+				cout	<< (i == 0 ? "\t  { " : "\t    ")
+					<< "{ " << heuristics[i] << ", "
+					<< setprecision(4) << large.num_bins/features.fill << ", "
+					<< scientific << setprecision(3) << large.time << ", "
+					<< fixed << setprecision(2) << exponent << " }"
+					<< (i+1 < heuristics.size() ? "," : " } },")
+					<< "\t// " << bp_heuristic_name(heuristics[i]) << "\n";
+			}
+		}
+	}
+
+	bp_context_destroy(ctx);
+	return(0);
+}
+
+/*!
+	Number of items from which only heuristics with a linear-time
+	reference are validated.
+*/
+
+static const unsigned int max_quadratic_items = 1 << 16;
+
+/*!
+	Items of the instance on which the parallel "Next-Fit" is validated;
+	large enough to be split into several chunks.
+*/
+
+static const unsigned int parallel_items = 1 << 20;
+
+/*!
+	Edge cases of the validation. Each of them is generated for every
+	capacity in edge_capacities.
+*/
+
+static const char* edge_cases[] =
+{
+	"a single item of size K",
+	"a single item of size 1",
+	"a single item of size 0",
+	"all items of size K",
+	"all items of size 0",
+	"items of size K/2 and K-K/2",
+	"items of size K/2+1",
+	"items of size K and 0 alternating",
+	"items of size 1 to K/10",
+	"items of size 0 to K"
+};
+
+static const unsigned int edge_capacities[] = { 1, 2, 3, 100, 1000, 1001, 65536, 0x7FFFFFFFu, 0xFFFFFFFFu };
+
+/*!
+	Generates an edge case of the validation.
+
+	@param c	Index in edge_cases
+	@param K	Capacity of bins
+	@param rng	Source of the random sizes
+
+	@return Items of the instance.
+*/
+
+vector<unsigned int> generate_edge_case(unsigned int c, unsigned int K, random_generator& rng)
+{
+	const unsigned int n = c < 3 ? 1 : 1000;
+	vector<unsigned int> items(n);
+
+	for(unsigned int i = 0; i < n; i++)
+	{
+		switch(c)
+		{
+			case 0:
+			case 3:
+				items[i] = K;
+				break;
+			case 1:
+				items[i] = 1;
+				break;
+			case 2:
+			case 4:
+				items[i] = 0;
+				break;
+			case 5:
+				items[i] = (i % 2) ? K-K/2 : K/2;
+				break;
+			case 6:
+				items[i] = K/2+1;
+				break;
+			case 7:
+				items[i] = (i % 2) ? 0 : K;
+				break;
+			case 8:
+				items[i] = rng.uniform(1, max(1u, K/10));
+				break;
+			default:
+				items[i] = rng.uniform(0, K);
+				break;
+		}
+	}
+
+	return(items);
+}
+
+/*!
+	Outcomes of the validation of a single heuristic.
+*/
+
+struct validation_counts
+{
+	unsigned int instances;
+	unsigned int skipped;		///< Instances too large for the heuristic
+	unsigned int outcomes[BP_MISMATCH_INVALID_REFERENCE+1];
+};
+
+/*!
+	Compares every optimized heuristic with its reference implementation
+	on an instance and reports all mismatches.
+
+	@param ctx		Context for packing
+	@param items		Items of the instance
+	@param K		Capacity of bins
+	@param description	Describes the instance in reports
+	@param counts		Outcomes so far, per heuristic
+
+	@return false if a mismatch has been found or a heuristic has failed.
+	Heuristics whose tables for K do not fit into memory are skipped.
+*/
+
+bool validate_instance(bp_context* ctx, const vector<unsigned int>& items, unsigned int K, const string& description, vector<validation_counts>& counts)
+{
+	const unsigned int n = static_cast<unsigned int>(items.size());
+	if(bp_set_instance(ctx, &items[0], n, K) != BP_OK)
+	{
+		cerr << "generate-problem: Unable to set instance " << description << "\n";
+		return(false);
+	}
+
+	bool valid = true;
+	for(unsigned int h = 0; h < BP_NUM_HEURISTICS; h++)
+	{
+		bp_heuristic heuristic = static_cast<bp_heuristic>(h);
+		bp_heuristic reference = bp_reference_heuristic(heuristic);
+
+		// Quadratic references take too long for large instances
+		if(	reference == heuristic ||
+			(n > max_quadratic_items && reference != BP_NEXT_FIT && reference != BP_NEXT_FIT_DECREASING))
+			continue;
+
+		bp_comparison comparison;
+		int status = bp_compare_heuristic(ctx, heuristic, &comparison);
+		if(status == BP_ERROR_OUT_OF_MEMORY)
+		{
+			counts[h].skipped++;
+			continue;
+		}
+		else if(status != BP_OK)
+		{
+			cerr << bp_heuristic_name(heuristic) << ", " << description << ": " << bp_strerror(status) << "\n";
+			valid = false;
+			continue;
+		}
+
+		counts[h].instances++;
+		counts[h].outcomes[comparison.outcome]++;
+
+		if(comparison.outcome <= BP_MATCH_TIES)
+			continue;
+
+		valid = false;
+
+		cout << bp_heuristic_name(heuristic) << " differs from " << bp_heuristic_name(reference) << ", " << description << ": ";
+		if(comparison.outcome >= BP_MISMATCH_INVALID)
+		{
+			cout	<< (comparison.outcome == BP_MISMATCH_INVALID ? "" : "reference has an ")
+				<< "invalid assignment (violation " << comparison.violation.kind << ", bin " << comparison.violation.bin
+				<< ", load " << comparison.violation.load << ")\n";
+			continue;
+		}
+
+		cout << comparison.variant_bins << " instead of " << comparison.reference_bins << " bins";
+		if(comparison.item < n)
+		{
+			cout	<< ", item " << comparison.item << " of size " << items[comparison.item]
+				<< " goes to a bin of load " << comparison.variant_load << " instead of " << comparison.reference_load;
+		}
+		cout << "\n";
+	}
+
+	return(valid);
+}
+
+/*!
+	Validates the optimized heuristics: every heuristic that has a
+	reference implementation is compared with it on instances of all
+	families, on edge cases, and on large instances for the parallel
+	"Next-Fit". Assignments may only differ by bins of the same load
+	being swapped (see bp_compare_heuristic()). The parallel heuristics
+	use several threads even on a single core, so that the merging of
+	their chunks is always exercised.
+
+	@param options		Seed and n of the instances of the families
+	@param capacities	Capacities of the instances of the families
+
+	@return 0 if all heuristics agree with their references, 1 if there
+	is a mismatch, and -1 on errors.
+*/
+
+int validate(generator_options options, const vector<unsigned int>& capacities)
+{
+	static const char* names[] = { "uniform", "triplets", "heavy", "few", "adversarial-ff", "adversarial-nf" };
+	static const family families[] = { FAMILY_UNIFORM, FAMILY_TRIPLETS, FAMILY_HEAVY, FAMILY_FEW, FAMILY_ADVERSARIAL_FIT, FAMILY_ADVERSARIAL_NF };
+
+	bp_context* ctx = bp_context_create();
+	if(ctx == NULL || bp_set_num_threads(ctx, 4) != BP_OK)
+	{
+		cerr << "generate-problem: Unable to create context\n";
+		bp_context_destroy(ctx);
+		return(-1);
+	}
+
+	validation_counts none = { 0, 0, { 0 } };
+	vector<validation_counts> counts(BP_NUM_HEURISTICS, none);
+	bool valid = true;
+
+	for(unsigned int f = 0; f < sizeof(families)/sizeof(families[0]); f++)
+	{
+		for(size_t k = 0; k < capacities.size(); k++)
+		{
+			options.f = families[f];
+			options.K = capacities[k];
+
+			if(check_options(options) != NULL)
+				continue;
+
+			const unsigned int n = static_cast<unsigned int>(options.n);
+			vector<unsigned int> items(n);
+			instance_generator generator(options);
+			for(unsigned int i = 0; i < n; i += block_size)
+				generator.fill(&items[i], min(block_size, n-i));
+
+			string description = string(names[f]) + ", n = " + to_string(n) + ", K = " + to_string(options.K);
+			valid = validate_instance(ctx, items, options.K, description, counts) && valid;
+		}
+	}
+
+	random_generator rng(options.seed);
+	for(unsigned int c = 0; c < sizeof(edge_cases)/sizeof(edge_cases[0]); c++)
+	{
+		for(unsigned int k = 0; k < sizeof(edge_capacities)/sizeof(edge_capacities[0]); k++)
+		{
+			vector<unsigned int> items = generate_edge_case(c, edge_capacities[k], rng);
+			string description = string(edge_cases[c]) + ", K = " + to_string(edge_capacities[k]);
+
+			valid = validate_instance(ctx, items, edge_capacities[k], description, counts) && valid;
+		}
+	}
+
+	// Chunks of the parallel "Next-Fit" start in the middle of bins,
+	// for an instantiated capacity as well as for another one
+	static const unsigned int parallel_capacities[] = { 1000, 1001 };
+	for(unsigned int k = 0; k < sizeof(parallel_capacities)/sizeof(parallel_capacities[0]); k++)
+	{
+		options.f = FAMILY_UNIFORM;
+		options.n = parallel_items;
+		options.K = parallel_capacities[k];
+
+		vector<unsigned int> items(parallel_items);
+		instance_generator generator(options);
+		for(unsigned int i = 0; i < parallel_items; i += block_size)
+			generator.fill(&items[i], min(block_size, parallel_items-i));
+
+		string description = "uniform, n = " + to_string(parallel_items) + ", K = " + to_string(options.K);
+		valid = validate_instance(ctx, items, options.K, description, counts) && valid;
+	}
+
+	bp_context_destroy(ctx);
+
+	cout << (valid ? "" : "\n");
+	for(unsigned int h = 0; h < BP_NUM_HEURISTICS; h++)
+	{
+		const validation_counts& c = counts[h];
+		if(c.instances == 0)
+			continue;
+
+		unsigned int mismatches = c.instances-c.outcomes[BP_MATCH_IDENTICAL]-c.outcomes[BP_MATCH_TIES];
+
+		cout	<< setw(24) << left << (string(bp_heuristic_name(static_cast<bp_heuristic>(h))) + ":")
+			<< setw(5) << right << c.instances << " instances, "
+			<< setw(5) << c.outcomes[BP_MATCH_IDENTICAL] << " identical, "
+			<< setw(5) << c.outcomes[BP_MATCH_TIES] << " up to ties, "
+			<< setw(5) << mismatches << " mismatches, "
+			<< setw(5) << c.skipped << " skipped\n";
+	}
+
+	return(valid ? 0 : 1);
+}
+
+void usage()
+{
+	cerr	<< "Usage: generate-problem [-f family] [-n items] [-K capacity] [-s seed]\n"
+		<< "                        [-a alpha] [-d distinct sizes] [-b] [-o file]\n"
+		<< "       generate-problem -S [-f family] [-m min. items] [-n max. items]\n"
+		<< "                        [-k capacity]... [-t budget] [-s seed]\n"
+		<< "       generate-problem -D dims [options of a single instance]\n"
+		<< "       generate-problem -V [-f family] [-n items] [-K capacity] [-D dims]...\n"
+		<< "       generate-problem -P [-f family] [-n items] [-K capacity] [-p shards]...\n"
+		<< "       generate-problem -O [-f family] [-n items] [-K capacity] [-p producers]...\n"
+		<< "       generate-problem -A [-n items] [-k capacity]... [-s seed]\n"
+		<< "       generate-problem -C [-n items] [-k capacity]... [-s seed]\n\n"
+		<< "Families: uniform, triplets, heavy, few, adversarial-ff, adversarial-bf,\n"
+		<< "          adversarial-nf\n";
+}
+
+int main(int argc, char* argv[])
+{
+	generator_options options;
+	options.f		= FAMILY_UNIFORM;
+	options.n		= 1000;
+	options.K		= 1000;
+	options.seed		= 1;
+	options.alpha		= 1.5;
+	options.distinct	= 8;
+
+	bool binary	= false;
+	bool sweeping	= false;
+	bool has_n	= false;
+	const char* output = NULL;
+
+	vector<unsigned int> capacities;
+	unsigned int n_min = 1000;
+	double budget = 1.0;
+
+	vector<unsigned int> dimensions;
+	bool benchmark = false;
+
+	vector<unsigned int> shards;
+	bool shard_mode = false;
+	bool concurrent_mode = false;
+
+	bool calibrating = false;
+	bool validating = false;
+
+	int c;
+	while((c = getopt(argc, argv, "f:n:K:s:a:d:bo:Sm:k:t:D:VPOp:AC")) != -1)
+	{
+		switch(c)
+		{
+			case 'f':
+				options.f = parse_family(optarg);
+				break;
+			case 'n':
+				options.n = strtoull(optarg, NULL, 10);
+				has_n	  = true;
+				break;
+			case 'K':
+				options.K = strtoul(optarg, NULL, 10);
+				break;
+			case 's':
+				options.seed = strtoull(optarg, NULL, 10);
+				break;
+			case 'a':
+				options.alpha = atof(optarg);
+				break;
+			case 'd':
+				options.distinct = strtoul(optarg, NULL, 10);
+				break;
+			case 'b':
+				binary = true;
+				break;
+			case 'o':
+				output = optarg;
+				break;
+			case 'S':
+				sweeping = true;
+				break;
+			case 'm':
+				n_min = strtoul(optarg, NULL, 10);
+				break;
+			case 'k':
+				capacities.push_back(strtoul(optarg, NULL, 10));
+				break;
+			case 't':
+				budget = atof(optarg);
+				break;
+			case 'D':
+				dimensions.push_back(strtoul(optarg, NULL, 10));
+				break;
+			case 'V':
+				benchmark = true;
+				break;
+			case 'P':
+				shard_mode = true;
+				break;
+			case 'O':
+				concurrent_mode = true;
+				break;
+			case 'p':
+				shards.push_back(strtoul(optarg, NULL, 10));
+				break;
+			case 'A':
+				calibrating = true;
+				break;
+			case 'C':
+				validating = true;
+				break;
+			default:
+				usage();
+				return(-1);
+		}
+	}
+
+	if(options.f == FAMILY_UNKNOWN)
+	{
+		usage();
+		return(-1);
+	}
+
+	// Only single instances are streamed; everything else keeps the
+	// items in memory with 32 bit indices
+	if(options.n > UINT_MAX && (sweeping || shard_mode || concurrent_mode || benchmark || calibrating || validating || !dimensions.empty()))
+	{
+		cerr << "generate-problem: More than 2^32-1 items are only supported for single instances\n";
+		return(-1);
+	}
+
+	if(sweeping)
+	{
+		if(!has_n)
+			options.n = 1 << 20;
+
+		if(capacities.empty())
+		{
+			capacities.push_back(100);
+			capacities.push_back(1000);
+			capacities.push_back(10000);
+		}
+
+		if(n_min == 0 || n_min > options.n)
+		{
+			cerr << "generate-problem: Invalid range of n\n";
+			return(-1);
+		}
+
+		return(sweep(options, capacities, n_min, budget));
+	}
+
+	if(calibrating)
+	{
+		if(!has_n)
+			options.n = 1 << 18;
+
+		if(capacities.empty())
+		{
+			for(unsigned int K = 100; K <= 100000; K *= 10)
+				capacities.push_back(K);
+		}
+
+		if(options.n < 4)
+		{
+			cerr << "generate-problem: Invalid number of items\n";
+			return(-1);
+		}
+
+		return(calibrate(options, capacities));
+	}
+
+	if(validating)
+	{
+		if(!has_n)
+			options.n = 10000;
+
+		if(capacities.empty())
+		{
+			capacities.push_back(100);
+			capacities.push_back(1000);
+			capacities.push_back(1001);
+			capacities.push_back(100000);
+		}
+
+		if(options.n == 0)
+		{
+			cerr << "generate-problem: Invalid number of items\n";
+			return(-1);
+		}
+
+		return(validate(options, capacities));
+	}
+
+	const char* error = check_options(options);
+	if(error == NULL && find(dimensions.begin(), dimensions.end(), 0u) != dimensions.end())
+		error = "the number of dimensions has to be positive";
+
+	if(error != NULL)
+	{
+		cerr << "generate-problem: " << error << "\n";
+		return(-1);
+	}
+
+	if(shard_mode)
+	{
+		if(!has_n)
+			options.n = 10000000;
+
+		if(shards.empty())
+		{
+			for(unsigned int t = 1; t <= 16; t *= 2)
+				shards.push_back(t);
+		}
+
+		return(shard_benchmark(options, shards));
+	}
+
+	if(concurrent_mode)
+	{
+		if(!has_n)
+			options.n = 10000000;
+
+		if(shards.empty())
+		{
+			for(unsigned int t = 1; t <= 16; t *= 2)
+				shards.push_back(t);
+		}
+
+		if(find(shards.begin(), shards.end(), 0u) != shards.end())
+		{
+			cerr << "generate-problem: The number of producers has to be positive\n";
+			return(-1);
+		}
+
+		return(concurrent_benchmark(options, shards));
+	}
+
+	if(benchmark)
+	{
+		if(!has_n)
+			options.n = 20000;
+
+		if(dimensions.empty())
+		{
+			dimensions.push_back(2);
+			dimensions.push_back(4);
+			dimensions.push_back(8);
+		}
+
+		return(vector_benchmark(options, dimensions));
+	}
+
+	FILE* out = output != NULL ? fopen(output, "wb") : stdout;
+	if(out == NULL)
+	{
+		cerr << "generate-problem: Unable to open " << output << ": " << strerror(errno) << "\n";
+		return(-1);
+	}
+
+	bool written = dimensions.empty() ? write_instance(options, binary, out) : write_vector_instance(options, dimensions.back(), binary, out);
+	if(output != NULL)
+		written = (fclose(out) == 0) && written;
+
+	if(!written)
+	{
+		cerr << "generate-problem: Unable to write instance\n";
+		return(-1);
+	}
+
+	return(0);
+}
@@ -0,0 +1,504 @@
+/*!
+	@file	heuristic-selection.cpp
+	@brief	Features of instances and automatic selection of heuristics
+
+	@author Bastian Rieck
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <vector>
+
+#include "heuristic-selection.h"
+#include "sorted-view.h"
+#include "workspace.h"
+#include "trace.h"
+
+/*!
+	@return true if both heuristics are implementations of the same
+	heuristic and open the same bins.
+*/
+
+static bool same_packing(bp_heuristic a, bp_heuristic b)
+{
+	return(bp_reference_heuristic(a) == bp_reference_heuristic(b));
+}
+
+/*!
+	Predictions that differ by less than this relative amount are not
+	told apart, so all such heuristics are run if the budget permits.
+*/
+
+static const double tolerance = 0.005;
+
+/*!
+	Number of objects from which the distinct sizes are counted if the
+	sizes are too spread out for a bitmap.
+*/
+
+static const unsigned int sample_size = 1 << 16;
+
+/*!
+	Measurement of a candidate on a calibration instance.
+*/
+
+struct calibration_entry
+{
+	int heuristic;
+	double ratio;		///< Bins divided by sum/K
+	double time;		///< Running time in seconds, including sorting
+	double exponent;	///< Exponent of n in the running time
+};
+
+/*!
+	Calibration instance with its features and the measurements of all
+	heuristics the cost model knows about.
+*/
+
+struct reference_instance
+{
+	const char* family;
+	unsigned int n;
+	unsigned int K;
+	unsigned int distinct;
+	double mean;
+	double deviation;
+	double skew;
+	double large;
+
+	calibration_entry entries[num_candidates];
+};
+
+/*!
+	Calibration table, as written by "generate-problem -A" with its
+	default settings: 2^18 items of every family for K = 10^2, ..., 10^5.
+*/
+
+static const reference_instance references[] =
+{
+	{ "uniform", 262144, 100, 100, 0.5062, 0.2889, -0.0052, 0.5019,
+	  { { 1, 1.1656, 2.064e-02, 1.08 },	// Max-Rest+
+	    { 4, 1.0076, 1.178e-02, 1.00 },	// First-Fit++
+	    { 7, 1.0021, 6.895e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.3266, 1.442e-03, 1.05 },	// Next-Fit
+	    { 9, 1.2794, 1.002e-03, 1.04 },	// Next-Fit-Decreasing
+	    { 12, 1.0043, 6.962e-03, 1.05 } } },	// Best-Fit++
+	{ "uniform", 262144, 1000, 1000, 0.5017, 0.2889, -0.0051, 0.5019,
+	  { { 1, 1.1710, 1.999e-02, 1.05 },	// Max-Rest+
+	    { 4, 1.0106, 9.753e-02, 1.10 },	// First-Fit++
+	    { 7, 1.0022, 4.596e-02, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.3322, 1.441e-03, 1.04 },	// Next-Fit
+	    { 9, 1.2885, 1.076e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.0055, 2.705e-02, 1.05 } } },	// Best-Fit++
+	{ "uniform", 262144, 10000, 10000, 0.5012, 0.2889, -0.0051, 0.5019,
+	  { { 1, 1.1716, 1.929e-02, 1.03 },	// Max-Rest+
+	    { 4, 1.0110, 7.286e-01, 1.04 },	// First-Fit++
+	    { 7, 1.0022, 5.368e-01, 1.29 },	// First-Fit-Decreasing++
+	    { 8, 1.3328, 1.572e-03, 1.00 },	// Next-Fit
+	    { 9, 1.2894, 1.212e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.0058, 2.775e-01, 1.00 } } },	// Best-Fit++
+	{ "uniform", 262144, 100000, 92648, 0.5012, 0.2889, -0.0051, 0.5019,
+	  { { 1, 1.1716, 2.044e-02, 1.03 },	// Max-Rest+
+	    { 4, 1.0110, 5.678e+00, 1.53 },	// First-Fit++
+	    { 7, 1.0022, 3.854e+00, 1.29 },	// First-Fit-Decreasing++
+	    { 8, 1.3328, 1.476e-03, 1.05 },	// Next-Fit
+	    { 9, 1.2895, 2.632e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.0058, 2.984e+00, 1.07 } } },	// Best-Fit++
+	{ "triplets", 262144, 100, 26, 0.3333, 0.0705, 0.6811, 0.0000,
+	  { { 1, 1.1043, 5.085e-03, 1.00 },	// Max-Rest+
+	    { 4, 1.1065, 8.812e-03, 1.00 },	// First-Fit++
+	    { 7, 1.1096, 1.820e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.2066, 7.530e-04, 1.01 },	// Next-Fit
+	    { 9, 1.1817, 6.400e-04, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.1065, 9.808e-03, 1.01 } } },	// Best-Fit++
+	{ "triplets", 262144, 1000, 251, 0.3333, 0.0683, 0.6891, 0.0000,
+	  { { 1, 1.1099, 7.123e-03, 1.10 },	// Max-Rest+
+	    { 4, 1.1098, 1.693e-02, 1.00 },	// First-Fit++
+	    { 7, 1.1300, 5.936e-03, 1.03 },	// First-Fit-Decreasing++
+	    { 8, 1.2129, 9.350e-04, 1.00 },	// Next-Fit
+	    { 9, 1.2067, 7.740e-04, 1.02 },	// Next-Fit-Decreasing
+	    { 12, 1.1098, 5.511e-02, 1.00 } } },	// Best-Fit++
+	{ "triplets", 262144, 10000, 2501, 0.3333, 0.0681, 0.6900, 0.0000,
+	  { { 1, 1.1105, 7.152e-03, 1.07 },	// Max-Rest+
+	    { 4, 1.1100, 1.976e-01, 1.09 },	// First-Fit++
+	    { 7, 1.1338, 8.085e-02, 1.02 },	// First-Fit-Decreasing++
+	    { 8, 1.2136, 1.068e-03, 1.05 },	// Next-Fit
+	    { 9, 1.2107, 1.154e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.1100, 5.229e-01, 1.00 } } },	// Best-Fit++
+	{ "triplets", 262144, 100000, 24908, 0.3333, 0.0680, 0.6901, 0.0000,
+	  { { 1, 1.1106, 7.474e-03, 1.11 },	// Max-Rest+
+	    { 4, 1.1101, 1.298e+00, 1.41 },	// First-Fit++
+	    { 7, 1.1343, 6.970e-01, 1.11 },	// First-Fit-Decreasing++
+	    { 8, 1.2136, 9.700e-04, 1.02 },	// Next-Fit
+	    { 9, 1.2112, 1.407e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.1101, 7.599e+00, 1.05 } } },	// Best-Fit++
+	{ "heavy", 262144, 100, 99, 0.0340, 0.0525, 11.0931, 0.0027,
+	  { { 1, 1.0044, 8.482e-03, 1.16 },	// Max-Rest+
+	    { 4, 1.0044, 3.447e-03, 1.07 },	// First-Fit++
+	    { 7, 1.0018, 2.567e-03, 1.10 },	// First-Fit-Decreasing++
+	    { 8, 1.0544, 4.660e-04, 1.00 },	// Next-Fit
+	    { 9, 1.0395, 1.328e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.0044, 1.325e-02, 1.00 } } },	// Best-Fit++
+	{ "heavy", 262144, 1000, 239, 0.0035, 0.0101, 49.4714, 0.0001,
+	  { { 1, 1.0013, 5.004e-03, 1.12 },	// Max-Rest+
+	    { 4, 1.0013, 1.748e-03, 1.00 },	// First-Fit++
+	    { 7, 1.0002, 2.449e-03, 1.03 },	// First-Fit-Decreasing++
+	    { 8, 1.0164, 3.800e-04, 1.00 },	// Next-Fit
+	    { 9, 1.0143, 1.290e-03, 1.14 },	// Next-Fit-Decreasing
+	    { 12, 1.0013, 1.054e-01, 1.03 } } },	// Best-Fit++
+	{ "heavy", 262144, 10000, 969, 0.0030, 0.0101, 49.2740, 0.0001,
+	  { { 1, 1.0007, 8.418e-03, 1.11 },	// Max-Rest+
+	    { 4, 1.0007, 3.030e-03, 1.03 },	// First-Fit++
+	    { 7, 1.0007, 2.316e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.0188, 4.100e-04, 1.00 },	// Next-Fit
+	    { 9, 1.0175, 1.081e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.0007, 1.008e+00, 1.00 } } },	// Best-Fit++
+	{ "heavy", 262144, 100000, 3946, 0.0029, 0.0101, 49.2722, 0.0001,
+	  { { 1, 1.0009, 8.098e-03, 1.14 },	// Max-Rest+
+	    { 4, 1.0009, 7.134e-03, 1.09 },	// First-Fit++
+	    { 7, 1.0009, 2.945e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.0219, 3.970e-04, 1.00 },	// Next-Fit
+	    { 9, 1.0179, 1.210e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.0009, 9.665e+00, 1.05 } } },	// Best-Fit++
+	{ "few", 262144, 100, 7, 0.6730, 0.1881, 0.2487, 0.7512,
+	  { { 1, 1.2076, 1.116e-02, 1.04 },	// Max-Rest+
+	    { 4, 1.2076, 6.306e-03, 1.01 },	// First-Fit++
+	    { 7, 1.2076, 2.858e-03, 1.07 },	// First-Fit-Decreasing++
+	    { 8, 1.3489, 5.490e-04, 1.02 },	// Next-Fit
+	    { 9, 1.3012, 9.010e-04, 1.03 },	// Next-Fit-Decreasing
+	    { 12, 1.2076, 8.622e-03, 1.00 } } },	// Best-Fit++
+	{ "few", 262144, 1000, 7, 0.6680, 0.1878, 0.2408, 0.7512,
+	  { { 1, 1.2166, 1.119e-02, 1.04 },	// Max-Rest+
+	    { 4, 1.2166, 6.269e-03, 1.00 },	// First-Fit++
+	    { 7, 1.2166, 2.510e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.3590, 6.080e-04, 1.02 },	// Next-Fit
+	    { 9, 1.3109, 9.000e-04, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.2166, 5.377e-02, 1.00 } } },	// Best-Fit++
+	{ "few", 262144, 10000, 8, 0.6674, 0.1878, 0.2382, 0.7512,
+	  { { 1, 1.2176, 1.146e-02, 1.01 },	// Max-Rest+
+	    { 4, 1.2176, 6.791e-03, 1.00 },	// First-Fit++
+	    { 7, 1.2176, 3.207e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.3601, 5.960e-04, 1.00 },	// Next-Fit
+	    { 9, 1.3120, 9.900e-04, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.2176, 4.949e-01, 1.00 } } },	// Best-Fit++
+	{ "few", 262144, 100000, 8, 0.6674, 0.1878, 0.2380, 0.7512,
+	  { { 1, 1.2177, 1.164e-02, 1.03 },	// Max-Rest+
+	    { 4, 1.2177, 6.544e-03, 1.00 },	// First-Fit++
+	    { 7, 1.2177, 3.159e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.3601, 6.000e-04, 1.02 },	// Next-Fit
+	    { 9, 1.3120, 1.004e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.2177, 4.603e+00, 1.00 } } },	// Best-Fit++
+	{ "adversarial-ff", 262144, 1000, 3, 0.3260, 0.1463, -0.0819, 0.3333,
+	  { { 1, 1.7042, 2.404e-03, 1.82 },	// Max-Rest+
+	    { 4, 1.7042, 1.593e-03, 1.43 },	// First-Fit++
+	    { 7, 1.0225, 2.435e-03, 1.18 },	// First-Fit-Decreasing++
+	    { 8, 1.7042, 2.370e-04, 1.00 },	// Next-Fit
+	    { 9, 1.7042, 1.348e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.7042, 8.674e-02, 1.00 } } },	// Best-Fit++
+	{ "adversarial-ff", 262144, 10000, 3, 0.3255, 0.1459, -0.0814, 0.3333,
+	  { { 1, 1.7070, 3.632e-03, 1.84 },	// Max-Rest+
+	    { 4, 1.7070, 1.904e-03, 1.29 },	// First-Fit++
+	    { 7, 1.0242, 2.600e-03, 1.24 },	// First-Fit-Decreasing++
+	    { 8, 1.7070, 3.420e-04, 1.00 },	// Next-Fit
+	    { 9, 1.7070, 1.570e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.7070, 1.035e+00, 1.19 } } },	// Best-Fit++
+	{ "adversarial-ff", 262144, 100000, 3, 0.3254, 0.1459, -0.0814, 0.3333,
+	  { { 1, 1.7073, 4.014e-03, 1.66 },	// Max-Rest+
+	    { 4, 1.7073, 1.561e-03, 1.03 },	// First-Fit++
+	    { 7, 1.0244, 2.802e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.7073, 3.410e-04, 1.00 },	// Next-Fit
+	    { 9, 1.7073, 1.549e-03, 1.01 },	// Next-Fit-Decreasing
+	    { 12, 1.7073, 9.162e+00, 1.00 } } },	// Best-Fit++
+	{ "adversarial-nf", 262144, 100, 2, 0.2550, 0.2450, -0.0000, 0.0000,
+	  { { 1, 1.9608, 8.981e-03, 1.09 },	// Max-Rest+
+	    { 4, 1.0000, 1.689e-03, 1.00 },	// First-Fit++
+	    { 7, 1.0000, 2.602e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.9608, 3.100e-04, 1.00 },	// Next-Fit
+	    { 9, 1.0000, 1.154e-03, 1.05 },	// Next-Fit-Decreasing
+	    { 12, 1.0000, 4.806e-03, 1.00 } } },	// Best-Fit++
+	{ "adversarial-nf", 262144, 1000, 2, 0.2505, 0.2495, 0.0000, 0.0000,
+	  { { 1, 1.9960, 8.716e-03, 1.14 },	// Max-Rest+
+	    { 4, 1.0000, 1.526e-03, 1.02 },	// First-Fit++
+	    { 7, 1.0000, 2.341e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.9960, 4.070e-04, 1.00 },	// Next-Fit
+	    { 9, 1.0000, 1.119e-03, 1.02 },	// Next-Fit-Decreasing
+	    { 12, 1.0000, 5.540e-02, 1.01 } } },	// Best-Fit++
+	{ "adversarial-nf", 262144, 10000, 2, 0.2500, 0.2500, -0.0000, 0.0000,
+	  { { 1, 1.9996, 8.941e-03, 1.05 },	// Max-Rest+
+	    { 4, 1.0000, 1.807e-03, 1.00 },	// First-Fit++
+	    { 7, 1.0000, 2.415e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 1.9996, 4.210e-04, 1.01 },	// Next-Fit
+	    { 9, 1.0000, 1.158e-03, 1.06 },	// Next-Fit-Decreasing
+	    { 12, 1.0000, 4.608e-01, 1.00 } } },	// Best-Fit++
+	{ "adversarial-nf", 262144, 100000, 2, 0.2500, 0.2500, 0.0000, 0.0000,
+	  { { 1, 2.0000, 5.493e-03, 1.00 },	// Max-Rest+
+	    { 4, 1.0000, 1.183e-03, 1.00 },	// First-Fit++
+	    { 7, 1.0000, 2.229e-03, 1.00 },	// First-Fit-Decreasing++
+	    { 8, 2.0000, 3.690e-04, 1.00 },	// Next-Fit
+	    { 9, 1.0000, 1.054e-03, 1.00 },	// Next-Fit-Decreasing
+	    { 12, 1.0000, 4.779e+00, 1.00 } } },	// Best-Fit++
+};
+
+static const unsigned int num_references = sizeof(references)/sizeof(references[0]);
+
+/*!
+	Maps features to a vector in which all components are roughly within
+	[0,1], so that they weigh about equally in the distance.
+
+	@param v Will contain 6 components
+*/
+
+static void normalize(	unsigned int n, unsigned int K, unsigned int distinct,
+			double mean, double deviation, double skew, double large,
+			double* v)
+{
+	// Most distinct sizes an instance of this n and K may have
+	double most = std::min(static_cast<double>(n), static_cast<double>(K)+1.0);
+
+	v[0] = mean;
+	v[1] = 2.0*deviation;
+	v[2] = skew/(1.0+fabs(skew));
+	v[3] = large;
+	v[4] = most > 1.0 ? log(std::max(distinct, 1u))/log(most) : 0.0;
+	v[5] = log10(static_cast<double>(K))/6.0;
+}
+
+/*!
+	Extracts the features of a problem. If the objects have already been
+	counted for the sorted view, only the histogram is read; otherwise,
+	the objects are read once, and the distinct sizes are marked in a
+	bitmap of the range of sizes. If the range is too large for that, the
+	distinct sizes of a sample are counted instead.
+
+	@param p Problem with at least one object
+
+	@return Features of the problem
+*/
+
+instance_features extract_features(const problem& p)
+{
+	trace_span span("features", "selection");
+	clock_t start = clock();
+
+	instance_features f;
+	f.n	  = p.n;
+	f.K	  = p.K;
+	f.sampled = false;
+
+	const double scale = 1.0/p.K;
+	const unsigned int range = p.max_size - p.min_size + 1;
+
+	// Moments of the sizes relative to K
+	double m1 = 0.0, m2 = 0.0, m3 = 0.0;
+	unsigned int large = 0;
+	unsigned int distinct = 0;
+
+	const unsigned int* histogram = p.view->available() ? p.view->histogram(p) : NULL;
+	if(histogram != NULL)
+	{
+		for(unsigned int i = 0; i < range; i++)
+		{
+			if(histogram[i] == 0)
+				continue;
+
+			unsigned int s = p.min_size+i;
+			double x = s*scale;
+			double c = histogram[i];
+
+			m1 += c*x;
+			m2 += c*x*x;
+			m3 += c*x*x*x;
+
+			large += (2ull*s > p.K) ? histogram[i] : 0;
+			distinct++;
+		}
+	}
+	else
+	{
+		bool bitmap = range <= max_histogram_range;
+		unsigned long long* bits = NULL;
+		if(bitmap)
+			bits = p.ws->borrow_zeroed<unsigned long long>(WS_SIZES, range/64+1);
+
+		for(unsigned int i = 0; i < p.n; i++)
+		{
+			unsigned int s = p.objects[i];
+			double x = s*scale;
+
+			m1 += x;
+			m2 += x*x;
+			m3 += x*x*x;
+
+			large += (2ull*s > p.K);
+
+			if(bitmap)
+				bits[(s-p.min_size) >> 6] |= 1ull << ((s-p.min_size) & 63);
+		}
+
+		if(bitmap)
+		{
+			for(unsigned int i = 0; i < range/64+1; i++)
+				distinct += __builtin_popcountll(bits[i]);
+		}
+		else
+		{
+			std::vector<unsigned int> sample;
+			unsigned int step = std::max(p.n/sample_size, 1u);
+			for(unsigned int i = 0; i < p.n; i += step)
+				sample.push_back(p.objects[i]);
+
+			std::sort(sample.begin(), sample.end());
+			distinct = static_cast<unsigned int>(std::unique(sample.begin(), sample.end())-sample.begin());
+			f.sampled = true;
+		}
+	}
+
+	m1 /= p.n;
+	m2 /= p.n;
+	m3 /= p.n;
+
+	double variance = std::max(m2-m1*m1, 0.0);
+
+	f.distinct  = distinct;
+	f.mean	    = m1;
+	f.deviation = sqrt(variance);
+	f.skew	    = variance > 0.0 ? (m3-3.0*m1*variance-m1*m1*m1)/(variance*f.deviation) : 0.0;
+	f.large	    = static_cast<double>(large)/p.n;
+	f.fill	    = m1*p.n;
+
+	clock_t end = clock();
+	f.time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+
+	return(f);
+}
+
+/*!
+	Orders predictions by predicted quality, then by predicted time.
+*/
+
+static bool better(const prediction& a, const prediction& b)
+{
+	if(a.ratio != b.ratio)
+		return(a.ratio < b.ratio);
+
+	return(a.time < b.time);
+}
+
+/*!
+	Predicts bins and running time of every candidate and selects the
+	heuristics to run. The candidate with the best predicted quality
+	whose predicted time is within the budget is selected, together with
+	all candidates that are predicted to be about as good and fit into
+	the rest of the budget. If no candidate fits into the budget, the
+	fastest one is selected.
+
+	@param features	Features of the instance
+	@param budget	Time budget for all selected heuristics, in seconds
+
+	@return Predictions for all candidates, best predicted quality first
+*/
+
+selection select_heuristics(const instance_features& features, double budget)
+{
+	double v[6];
+	normalize(	features.n, features.K, features.distinct,
+			features.mean, features.deviation, features.skew, features.large, v);
+
+	// Nearest calibration instance
+	unsigned int nearest = 0;
+	double nearest_distance = HUGE_VAL;
+
+	for(unsigned int r = 0; r < num_references; r++)
+	{
+		const reference_instance& ref = references[r];
+
+		double w[6];
+		normalize(ref.n, ref.K, ref.distinct, ref.mean, ref.deviation, ref.skew, ref.large, w);
+
+		double distance = 0.0;
+		for(unsigned int i = 0; i < 6; i++)
+			distance += (v[i]-w[i])*(v[i]-w[i]);
+
+		if(distance < nearest_distance)
+		{
+			nearest = r;
+			nearest_distance = distance;
+		}
+	}
+
+	const reference_instance& ref = references[nearest];
+
+	selection s;
+	s.reference   = ref.family;
+	s.reference_K = ref.K;
+	s.distance    = sqrt(nearest_distance);
+
+	for(unsigned int c = 0; c < num_candidates; c++)
+	{
+		const calibration_entry& e = ref.entries[c];
+
+		prediction& pred = s.predictions[c];
+		pred.heuristic = static_cast<bp_heuristic>(e.heuristic);
+		pred.ratio     = e.ratio;
+		pred.time      = e.time*pow(static_cast<double>(features.n)/ref.n, e.exponent);
+		pred.decision  = BP_SKIPPED_QUALITY;
+	}
+
+	// Only the faster implementation of a heuristic is considered
+	for(unsigned int c = 0; c < num_candidates; c++)
+	{
+		for(unsigned int d = 0; d < c; d++)
+		{
+			if(!same_packing(s.predictions[c].heuristic, s.predictions[d].heuristic))
+				continue;
+
+			prediction& slower = s.predictions[c].time < s.predictions[d].time ? s.predictions[d] : s.predictions[c];
+			slower.decision = BP_SKIPPED_EQUIVALENT;
+		}
+	}
+
+	std::sort(s.predictions, s.predictions+num_candidates, better);
+
+	int best = -1;
+	for(unsigned int c = 0; c < num_candidates && best < 0; c++)
+	{
+		if(s.predictions[c].decision != BP_SKIPPED_EQUIVALENT && s.predictions[c].time <= budget)
+			best = c;
+	}
+
+	if(best < 0)
+	{
+		for(unsigned int c = 0; c < num_candidates; c++)
+		{
+			if(	s.predictions[c].decision != BP_SKIPPED_EQUIVALENT &&
+				(best < 0 || s.predictions[c].time < s.predictions[best].time))
+				best = c;
+		}
+	}
+
+	s.predictions[best].decision = BP_SELECTED;
+	double spent = s.predictions[best].time;
+
+	for(unsigned int c = 0; c < num_candidates; c++)
+	{
+		prediction& pred = s.predictions[c];
+		if(static_cast<int>(c) == best || pred.decision == BP_SKIPPED_EQUIVALENT)
+			continue;
+
+		// Better candidates have not been selected because of their time
+		if(static_cast<int>(c) < best)
+			pred.decision = BP_SKIPPED_BUDGET;
+		else if(pred.ratio > s.predictions[best].ratio*(1.0+tolerance))
+			pred.decision = BP_SKIPPED_QUALITY;
+		else if(spent+pred.time <= budget)
+		{
+			pred.decision = BP_SELECTED;
+			spent += pred.time;
+		}
+		else
+			pred.decision = BP_SKIPPED_BUDGET;
+	}
+
+	return(s);
+}
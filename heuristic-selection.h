@@ -0,0 +1,81 @@
+/*!
+	@file	heuristic-selection.h
+	@brief	Features of instances and automatic selection of heuristics
+
+	A handful of features is extracted from an instance in a single pass
+	over its objects, or over its histogram if the objects have already
+	been counted while they were read. The cost model then looks up the
+	calibration instance whose features are closest and predicts, for
+	every candidate heuristic, the number of bins relative to the lower
+	bound sum/K and the running time. The running time is scaled from the
+	calibration instance to the actual number of objects with a power law
+	that has been fitted for every heuristic and calibration instance.
+
+	The calibration table is written by "generate-problem -A", which
+	packs instances of every family of the generator and prints the
+	table in the format used here.
+
+	@author Bastian Rieck
+*/
+
+#ifndef HEURISTIC_SELECTION_H
+#define HEURISTIC_SELECTION_H
+
+#include "bin-packing.h"
+#include "bin-packing-api.h"
+
+/*!
+	Cheap features of an instance.
+*/
+
+struct instance_features
+{
+	unsigned int n;
+	unsigned int K;
+	unsigned int distinct;	///< Number of distinct sizes
+	bool sampled;		///< distinct has been counted on a sample
+	double mean;		///< Mean size, relative to K
+	double deviation;	///< Standard deviation of the sizes, relative to K
+	double skew;		///< Skewness of the sizes
+	double large;		///< Fraction of objects larger than K/2
+	double fill;		///< Sum of all sizes divided by K
+	double time;		///< Time required for extracting the features
+};
+
+/*!
+	Number of heuristics the cost model knows about. The other heuristics
+	pack like one of them, but are slower, or their running time depends
+	on the number of cores.
+*/
+
+static const unsigned int num_candidates = 6;
+
+/*!
+	Prediction of the cost model for a single heuristic.
+*/
+
+struct prediction
+{
+	bp_heuristic heuristic;
+	double time;		///< Predicted running time in seconds
+	double ratio;		///< Predicted number of bins divided by sum/K
+	int decision;		///< BP_SELECTED or the reason for skipping it
+};
+
+/*!
+	Predictions for all candidates, ordered by predicted quality, and
+	the calibration instance they are based on.
+*/
+
+struct selection
+{
+	const char* reference;		///< Family of the calibration instance
+	unsigned int reference_K;	///< Capacity of the calibration instance
+	double distance;		///< Distance of the features
+	prediction predictions[num_candidates];
+};
+
+instance_features extract_features(const problem& p);
+selection select_heuristics(const instance_features& features, double budget);
+
+#endif
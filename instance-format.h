@@ -0,0 +1,53 @@
+/*!
+	@file	instance-format.h
+	@brief	Binary format of problem instances
+
+	A binary instance starts with a header, followed by n item sizes. All
+	fields are unsigned 32 bit integers in host byte order. The magic
+	number distinguishes binary instances from the text format, which
+	always starts with a digit or whitespace. Instances with 2^32 or more
+	items use a header with a 64 bit count instead; only the out-of-core
+	mode of bin-packing reads them.
+
+	A binary vector instance starts with its own header, followed by the
+	capacities of all d dimensions and the demands of all items, stored
+	dimension by dimension: first the demands of all n items in the first
+	dimension, then all demands in the second dimension, and so on. This
+	is the structure of arrays that the vector heuristics use.
+
+	@author Bastian Rieck
+*/
+
+#ifndef INSTANCE_FORMAT_H
+#define INSTANCE_FORMAT_H
+
+#include <stdint.h>
+
+static const uint32_t instance_magic = 0x4E495042;	///< "BPIN"
+
+struct instance_header
+{
+	uint32_t magic;
+	uint32_t n;		///< Number of items
+	uint32_t K;		///< Capacity of bins
+};
+
+static const uint32_t large_instance_magic = 0x4C495042;	///< "BPIL"
+
+struct large_instance_header
+{
+	uint32_t magic;
+	uint32_t K;		///< Capacity of bins
+	uint64_t n;		///< Number of items
+};
+
+static const uint32_t vector_instance_magic = 0x56495042;	///< "BPIV"
+
+struct vector_instance_header
+{
+	uint32_t magic;
+	uint32_t n;		///< Number of items
+	uint32_t d;		///< Number of dimensions
+};
+
+#endif
@@ -0,0 +1,504 @@
+/*!
+	@file	lower-bound.cpp
+	@brief	Lower bound from the LP relaxation of Gilmore and Gomory
+
+	@author Bastian Rieck
+*/
+
+#include <algorithm>
+#include <climits>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "lower-bound.h"
+#include "first-fit.h"
+#include "run-control.h"
+#include "sorted-view.h"
+#include "workspace.h"
+#include "trace.h"
+
+/*!
+	Tolerance for reduced costs and for the ratio test.
+*/
+
+static const double epsilon = 1e-9;
+
+/*!
+	Number of objects of one size in a pattern.
+*/
+
+struct pattern_entry
+{
+	unsigned int row;	///< Index of the size
+	unsigned int count;
+};
+
+/*!
+	Pattern, i.e. the contents of a bin, as entries in increasing order
+	of their rows.
+*/
+
+typedef std::vector<pattern_entry> pattern;
+
+/*!
+	Part of a size for the knapsack. A size that may occur up to b times
+	in a pattern is split into parts of 1, 2, 4, ... objects, so that
+	every count up to b is the sum of some of them.
+*/
+
+struct knapsack_part
+{
+	unsigned int row;
+	unsigned int count;
+	unsigned int weight;	///< Sum of the sizes of the part
+};
+
+/*!
+	@return Wall-clock time since start, in seconds; the budget of the
+	bound and the deadline of its warm start are both measured this way.
+*/
+
+static double elapsed(std::chrono::steady_clock::time_point start)
+{
+	return(std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count());
+}
+
+/*!
+	Rounds a lower bound up to the next number of bins, allowing for
+	rounding errors of the floating point computation.
+*/
+
+static unsigned int round_bound(double value)
+{
+	return(static_cast<unsigned int>(ceil(value*(1.0-1e-9)-1e-9)));
+}
+
+/*!
+	@return Value of a pattern for the given dual values.
+*/
+
+static double value(const pattern& a, const std::vector<double>& y)
+{
+	double v = 0.0;
+	for(size_t e = 0; e < a.size(); e++)
+		v += y[a[e].row]*a[e].count;
+
+	return(v);
+}
+
+/*!
+	Solves the pricing problem, a bounded knapsack over the sizes with
+	the dual values as profits, by dynamic programming over the capacity.
+	Only sizes with a positive dual value are considered.
+
+	@param parts	Parts of all sizes
+	@param y	Dual values
+	@param K	Capacity
+	@param table	Decisions of the dynamic program, K+1 per part
+	@param a	Will contain the best pattern
+
+	@return Value of the best pattern.
+*/
+
+static double knapsack(	const std::vector<knapsack_part>& parts, const std::vector<double>& y, unsigned int K,
+			std::vector<unsigned char>& table, pattern& a)
+{
+	std::vector<double> best(static_cast<size_t>(K)+1, 0.0);
+
+	for(size_t j = 0; j < parts.size(); j++)
+	{
+		const knapsack_part& part = parts[j];
+		unsigned char* take = &table[j*(static_cast<size_t>(K)+1)];
+
+		double v = y[part.row]*part.count;
+		if(v <= epsilon)
+		{
+			std::fill(take, take+K+1, 0);
+			continue;
+		}
+
+		std::fill(take, take+part.weight, 0);
+		for(unsigned int c = K; c >= part.weight; c--)
+		{
+			double candidate = best[c-part.weight]+v;
+			take[c] = candidate > best[c];
+			if(take[c])
+				best[c] = candidate;
+		}
+	}
+
+	// Collect the parts that have been taken for capacity K
+	std::vector<unsigned int> counts(y.size(), 0);
+	unsigned int c = K;
+	for(size_t j = parts.size(); j-- > 0; )
+	{
+		if(table[j*(static_cast<size_t>(K)+1)+c])
+		{
+			counts[parts[j].row] += parts[j].count;
+			c -= parts[j].weight;
+		}
+	}
+
+	a.clear();
+	for(unsigned int i = 0; i < counts.size(); i++)
+	{
+		if(counts[i] > 0)
+		{
+			pattern_entry e = { i, counts[i] };
+			a.push_back(e);
+		}
+	}
+
+	return(best[K]);
+}
+
+/*!
+	Collects the distinct patterns of a "First-Fit-Decreasing" packing.
+	The bins are stored as lists of rows, which are hashed, so that equal
+	bins end up next to each other when the bins are sorted.
+
+	@param sorted		Objects in decreasing order
+	@param rows		Row of every object; objects of size 0 have none
+	@param n		Number of objects
+	@param positions	Bin of every object
+	@param num_bins		Number of bins
+
+	@return Distinct patterns
+*/
+
+static std::vector<pattern> ffd_patterns(	const unsigned int* sorted, const std::vector<unsigned int>& rows, unsigned int n,
+						const unsigned int* positions, unsigned int num_bins)
+{
+	std::vector<unsigned int> offsets(static_cast<size_t>(num_bins)+1, 0);
+	for(unsigned int i = 0; i < n; i++)
+	{
+		if(sorted[i] > 0)
+			offsets[positions[i]+1]++;
+	}
+
+	for(unsigned int b = 0; b < num_bins; b++)
+		offsets[b+1] += offsets[b];
+
+	// Rows of the objects of every bin; they are increasing, because the
+	// objects are sorted
+	std::vector<unsigned int> contents(offsets[num_bins]);
+	std::vector<unsigned int> cursor(offsets.begin(), offsets.end()-1);
+	std::vector<unsigned long long> hashes(num_bins, 0xCBF29CE484222325ull);
+
+	for(unsigned int i = 0; i < n; i++)
+	{
+		if(sorted[i] == 0)
+			continue;
+
+		unsigned int b = positions[i];
+		contents[cursor[b]++] = rows[i];
+		hashes[b] = (hashes[b] ^ rows[i])*0x100000001B3ull;
+	}
+
+	std::vector<unsigned int> bins(num_bins);
+	for(unsigned int b = 0; b < num_bins; b++)
+		bins[b] = b;
+
+	std::sort(bins.begin(), bins.end(), [&hashes](unsigned int a, unsigned int b)
+	{
+		return(hashes[a] < hashes[b]);
+	});
+
+	std::vector<pattern> patterns;
+	for(unsigned int k = 0; k < num_bins; k++)
+	{
+		unsigned int b = bins[k];
+		if(offsets[b] == offsets[b+1])
+			continue;
+
+		// Equal bins are only compared to their predecessor; a collision
+		// at most adds a pattern twice
+		if(k > 0)
+		{
+			unsigned int prev = bins[k-1];
+			if(	hashes[prev] == hashes[b] &&
+				offsets[prev+1]-offsets[prev] == offsets[b+1]-offsets[b] &&
+				std::equal(&contents[offsets[b]], &contents[0]+offsets[b+1], &contents[offsets[prev]]))
+				continue;
+		}
+
+		pattern a;
+		for(unsigned int i = offsets[b]; i < offsets[b+1]; i++)
+		{
+			if(!a.empty() && a.back().row == contents[i])
+				a.back().count++;
+			else
+			{
+				pattern_entry e = { contents[i], 1 };
+				a.push_back(e);
+			}
+		}
+
+		patterns.push_back(a);
+	}
+
+	return(patterns);
+}
+
+/*!
+	Computes a lower bound on the number of bins by column generation on
+	the LP relaxation of Gilmore and Gomory. The restricted master LP is
+	solved by the revised simplex method with a dense basis inverse.
+
+	Column generation stops when the LP is solved, when the bound reaches
+	the target or the bins of the "First-Fit-Decreasing" packing, or when
+	the time budget is exhausted. If there are too many distinct sizes or
+	K is too large for the knapsack table, only ceil(sum/K) is reported;
+	the "First-Fit-Decreasing" packing is skipped in this case as well.
+
+	@param p	Problem
+	@param budget	Wall-clock time for the bound, in seconds
+	@param target	Stop as soon as the bound reaches it; 0 for none
+
+	@return Bounds and statistics
+*/
+
+lp_bound gilmore_gomory(const problem& p, double budget, unsigned int target)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// The bound is computed in one go; it is neither cancelled nor
+	// stopped by the deadline of a heuristic
+	problem q = p;
+	q.control = NULL;
+
+	lp_bound b;
+	b.solved    = false;
+	b.converged = false;
+	b.columns   = 0;
+
+	const unsigned int* sorted = q.view->objects(q);
+	const unsigned int K = q.K;
+
+	// Distinct sizes in decreasing order; objects of size 0 do not need
+	// any capacity
+	std::vector<unsigned int> sizes;
+	std::vector<unsigned int> demand;
+	std::vector<unsigned int> rows(q.n);
+	unsigned long long sum = 0;
+
+	for(unsigned int i = 0; i < q.n; i++)
+	{
+		unsigned int s = sorted[i];
+		sum += s;
+
+		if(s == 0)
+			continue;
+
+		if(sizes.empty() || sizes.back() != s)
+		{
+			sizes.push_back(s);
+			demand.push_back(0);
+		}
+
+		demand.back()++;
+		rows[i] = static_cast<unsigned int>(sizes.size()-1);
+	}
+
+	const unsigned int m = static_cast<unsigned int>(sizes.size());
+
+	b.lp_value	= sum/static_cast<double>(K);
+	b.simple_bound	= std::max(static_cast<unsigned int>((sum+K-1)/K), q.n > 0 ? 1u : 0u);
+	b.lower_bound	= b.simple_bound;
+
+	std::vector<knapsack_part> parts;
+	for(unsigned int i = 0; i < m; i++)
+	{
+		unsigned int bound = std::min(demand[i], K/sizes[i]);
+		for(unsigned int k = 1; bound > 0; k *= 2)
+		{
+			knapsack_part part = { i, std::min(k, bound), std::min(k, bound)*sizes[i] };
+			parts.push_back(part);
+			bound -= part.count;
+		}
+	}
+
+	b.upper_bound = 0;
+	if(	(target > 0 && b.lower_bound >= target) || m > max_lp_rows ||
+		parts.size()*(static_cast<unsigned long>(K)+1) > max_knapsack_table)
+	{
+		b.time = elapsed(start);
+		return(b);
+	}
+
+	// Warm start; the packing has to finish within the budget, too, or
+	// column generation starts from the initial basis alone
+	run_control control;
+	control.has_deadline = true;
+	control.deadline     = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(budget));
+	control.start(q.n);
+	q.control = &control;
+
+	unsigned int* positions = q.ws->borrow<unsigned int>(WS_POSITIONS, q.n);
+	double ffd_time;
+	unsigned int ffd_bins = first_fit_decreasing_map(q, positions, ffd_time);
+
+	q.control = NULL;
+
+	std::vector<pattern> pool;
+	if(control.reason == STOP_NONE)
+	{
+		b.upper_bound = ffd_bins;
+		pool = ffd_patterns(sorted, rows, q.n, positions, b.upper_bound);
+	}
+
+	unsigned int stop = target > 0 ? target : UINT_MAX;
+	if(b.upper_bound > 0)
+		stop = std::min(stop, b.upper_bound);
+
+	if(b.lower_bound >= stop)
+	{
+		b.time = elapsed(start);
+		return(b);
+	}
+
+	b.solved = true;
+
+	trace_span span("column generation", "bound");
+
+	std::vector<bool> used(pool.size(), false);
+	std::vector<unsigned char> table(parts.size()*(static_cast<size_t>(K)+1));
+
+	// The initial basis holds one pattern per size with as many objects
+	// of that size as fit, so the basis inverse is diagonal
+	std::vector<double> inverse(static_cast<size_t>(m)*m, 0.0);
+	std::vector<double> x(m);
+
+	for(unsigned int i = 0; i < m; i++)
+	{
+		double count = std::min(demand[i], K/sizes[i]);
+		inverse[static_cast<size_t>(i)*m+i] = 1.0/count;
+		x[i] = demand[i]/count;
+	}
+
+	std::vector<double> y(m);
+	std::vector<double> column(m);
+	pattern priced;
+
+	for(;;)
+	{
+		// Dual values y = 1^T B^-1, as all patterns cost one bin
+		std::fill(y.begin(), y.end(), 0.0);
+		for(unsigned int i = 0; i < m; i++)
+		{
+			const double* row = &inverse[static_cast<size_t>(i)*m];
+			for(unsigned int j = 0; j < m; j++)
+				y[j] += row[j];
+		}
+
+		if(elapsed(start) > budget)
+			break;
+
+		// Patterns of the warm start are priced first
+		const pattern* entering = NULL;
+		double best = 1.0+epsilon;
+
+		for(size_t k = 0; k < pool.size(); k++)
+		{
+			if(used[k])
+				continue;
+
+			double v = value(pool[k], y);
+			if(v > best)
+			{
+				best	 = v;
+				entering = &pool[k];
+			}
+		}
+
+		if(entering != NULL)
+			used[entering-&pool[0]] = true;
+		else
+		{
+			double v = knapsack(parts, y, K, table, priced);
+
+			double dual = 0.0;
+			for(unsigned int i = 0; i < m; i++)
+				dual += y[i]*demand[i];
+
+			// Farley's bound holds for any dual values
+			double bound = dual/std::max(v, 1.0);
+			if(bound > b.lp_value)
+			{
+				b.lp_value    = bound;
+				b.lower_bound = std::max(b.lower_bound, round_bound(bound));
+			}
+
+			if(v <= 1.0+epsilon)
+			{
+				b.converged = true;
+				break;
+			}
+
+			if(b.lower_bound >= stop)
+				break;
+
+			entering = &priced;
+			b.columns++;
+		}
+
+		// Ratio test for the column B^-1 a of the entering pattern
+		const pattern& a = *entering;
+		for(unsigned int i = 0; i < m; i++)
+		{
+			const double* row = &inverse[static_cast<size_t>(i)*m];
+
+			double c = 0.0;
+			for(size_t e = 0; e < a.size(); e++)
+				c += row[a[e].row]*a[e].count;
+
+			column[i] = c;
+		}
+
+		int leaving = -1;
+		double ratio = HUGE_VAL;
+
+		for(unsigned int i = 0; i < m; i++)
+		{
+			if(column[i] <= epsilon)
+				continue;
+
+			double r = x[i]/column[i];
+			if(r < ratio-epsilon || (r <= ratio+epsilon && column[i] > column[leaving]))
+			{
+				ratio	= r;
+				leaving = i;
+			}
+		}
+
+		// Cannot happen in exact arithmetic, as every size is covered
+		if(leaving < 0)
+			break;
+
+		// Pivot
+		for(unsigned int i = 0; i < m; i++)
+			x[i] = std::max(x[i]-ratio*column[i], 0.0);
+
+		x[leaving] = ratio;
+
+		double* pivot = &inverse[static_cast<size_t>(leaving)*m];
+		double scale = 1.0/column[leaving];
+		for(unsigned int j = 0; j < m; j++)
+			pivot[j] *= scale;
+
+		for(unsigned int i = 0; i < m; i++)
+		{
+			if(static_cast<int>(i) == leaving || column[i] == 0.0)
+				continue;
+
+			double* row = &inverse[static_cast<size_t>(i)*m];
+			double factor = column[i];
+			for(unsigned int j = 0; j < m; j++)
+				row[j] -= factor*pivot[j];
+		}
+	}
+
+	b.time = elapsed(start);
+	return(b);
+}
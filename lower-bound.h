@@ -0,0 +1,61 @@
+/*!
+	@file	lower-bound.h
+	@brief	Lower bound from the LP relaxation of Gilmore and Gomory
+
+	The LP relaxation of the pattern formulation chooses x_p >= 0 copies
+	of every pattern p, i.e. of every way to fill a bin, so that every
+	size i is covered d_i times, and minimizes the number of bins. It is
+	solved by column generation: a restricted master LP over a subset of
+	the patterns yields dual values y, and a bounded knapsack over the
+	histogram finds the pattern of largest value y*a. If that value does
+	not exceed 1, the LP is solved; otherwise the pattern is added.
+
+	Every pricing step yields Farley's bound y*d / max(y*a), which is a
+	lower bound on the LP for any y. The bound is therefore valid when
+	column generation is stopped early, and it does not depend on the
+	accuracy of the simplex method.
+
+	The restricted master starts with one pattern per size and is warm
+	started with the patterns of a "First-Fit-Decreasing" packing, which
+	also provides an upper bound.
+
+	@author Bastian Rieck
+*/
+
+#ifndef LOWER_BOUND_H
+#define LOWER_BOUND_H
+
+#include "bin-packing.h"
+
+/*!
+	Largest number of distinct sizes for which the LP is solved; the
+	basis inverse is kept as a dense matrix.
+*/
+
+static const unsigned int max_lp_rows = 2048;
+
+/*!
+	Largest table of the knapsack, in bytes, for which the LP is solved.
+*/
+
+static const unsigned long max_knapsack_table = 1ul << 26;
+
+/*!
+	Result of the column generation.
+*/
+
+struct lp_bound
+{
+	unsigned int lower_bound;	///< No packing uses fewer bins
+	unsigned int simple_bound;	///< ceil(sum/K)
+	unsigned int upper_bound;	///< Bins of the "First-Fit-Decreasing" packing, or 0
+	double lp_value;		///< Best lower bound on the LP relaxation
+	bool solved;			///< Column generation has run
+	bool converged;			///< The LP relaxation has been solved
+	unsigned int columns;		///< Patterns added by pricing
+	double time;			///< Wall-clock time, in seconds
+};
+
+lp_bound gilmore_gomory(const problem& p, double budget, unsigned int target);
+
+#endif
@@ -11,44 +11,50 @@
 #include <queue>
 
 #include "bin-packing.h"
+#include "run-control.h"
+#include "bin-scan.h"
+#include "workspace.h"
+#include "fixed-capacity.h"
+#include "trace.h"
 
 /*!
-	Performs the "Max-Rest" heuristic for the current problem. Worst-case
-	running time is O(n^2).
+	Implementation of the "Max-Rest" heuristic for bins whose fill levels
+	are stored using a certain unsigned integer type.
 */
 
-unsigned int max_rest(const unsigned int* objects, unsigned int* positions, double& time)
+template<typename bin_t> static unsigned int max_rest_bins(const problem& p, unsigned int* positions, double& time)
 {
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = p.K;
+	const unsigned int min_size = p.min_size;
+
 	unsigned int num_open_bins = 1;
 	unsigned int num_full_bins = 0;
-	unsigned int* bins = new unsigned int[n];
+	bin_t* bins = p.ws->borrow_zeroed<bin_t>(WS_BINS, n);
 
-	memset(bins, 0, n*sizeof(unsigned int));
-	memset(positions, 0, n*sizeof(unsigned int));
+	// Open bins are moved around when full bins are removed, so their
+	// original indices are kept separately
+	unsigned int* ids = p.ws->borrow_zeroed<unsigned int>(WS_NEXT, n);
 
 	unsigned int limit_capacity = K-min_size;
 
 	clock_t start = clock();
+	long long traced = trace_begin();
 	for(unsigned int i = 0; i < n; i++)
 	{
-		unsigned int max_bin = n;	// bin with maximum _remaining_ capacity
-		unsigned int max_rem_cap = K;	// capacity for said bin
+		if(stop_requested(p, i, num_open_bins+num_full_bins))
+			break;
 
-		for(unsigned int j = 0; j < num_open_bins; j++)
-		{
-			if(bins[j] < max_rem_cap)
-			{
-				max_rem_cap = bins[j];
-				max_bin	= j;
-			}
-		}
+		// Bin with maximum _remaining_ capacity
+		unsigned int max_bin = scan_max_rest(bins, num_open_bins);
 
 		// Check whether object fits into the bin with maximum
 		// remaining capacity...
-		if((max_bin < n) && (bins[max_bin]+objects[i]) <= K)
+		if(max_bin < num_open_bins && bins[max_bin] <= K-objects[i])
 		{
 			bins[max_bin] += objects[i];
-			positions[i] = max_bin;
+			positions[i] = ids[max_bin];
 
 			// Remove (almost) full bins
 			if(bins[max_bin] > limit_capacity)
@@ -56,6 +62,7 @@ unsigned int max_rest(const unsigned int* objects, unsigned int* positions, doub
 				num_open_bins--;
 				num_full_bins++;
 				bins[max_bin] = bins[num_open_bins];
+				ids[max_bin]  = ids[num_open_bins];
 			}
 		}
 
@@ -63,26 +70,72 @@ unsigned int max_rest(const unsigned int* objects, unsigned int* positions, doub
 		else
 		{
 			bins[num_open_bins] = objects[i];
-			positions[i] = num_open_bins++;
+			ids[num_open_bins]  = num_open_bins+num_full_bins;
+			positions[i] = ids[num_open_bins++];
 		}
 	}
 
 	clock_t end = clock();
+	trace_end("pack", "pack", traced);
 	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
 
-	delete[] bins;
 	return(num_open_bins+num_full_bins);
 }
 
+/*!
+	Performs the "Max-Rest" heuristic for the current problem. Worst-case
+	running time is O(n^2). The bins are scanned using vectorized kernels;
+	if K permits it, fill levels are stored as 16 bit integers.
+*/
+
+unsigned int max_rest(const problem& p, unsigned int* positions, double& time)
+{
+	if(p.K < 0xFFFF)
+		return(max_rest_bins<unsigned short>(p, positions, time));
+	else
+		return(max_rest_bins<unsigned int>(p, positions, time));
+}
 
 /*!
-	Performs the "Max-Rest" heuristic using priority queue for bin
-	selection. In order to facilitate the algorithm, the positions of
-	objects are not saved.
+	Type of the elements of the priority queue used by max_rest_pq. If
+	positions are recorded, the id of a bin is stored in the lower half of
+	a 64 bit key, below its fill level, so that a single comparison still
+	orders the bins.
 */
 
-unsigned int max_rest_pq(const unsigned int* objects, double& time)
+template<bool record> struct max_rest_key
+{
+	typedef unsigned int type;
+
+	static type make(unsigned int fill, unsigned int)	{ return(fill); }
+	static unsigned int fill(type key)			{ return(key); }
+	static unsigned int id(type)				{ return(0); }
+};
+
+template<> struct max_rest_key<true>
 {
+	typedef unsigned long long type;
+
+	static type make(unsigned int fill, unsigned int id)	{ return((static_cast<type>(fill) << 32) | id); }
+	static unsigned int fill(type key)			{ return(static_cast<unsigned int>(key >> 32)); }
+	static unsigned int id(type key)			{ return(static_cast<unsigned int>(key)); }
+};
+
+/*!
+	Implementation of the "Max-Rest" heuristic using a priority queue for
+	bin selection. C is the capacity if it is known at compile time, else
+	0.
+*/
+
+template<bool record, unsigned int C> static unsigned int max_rest_pq_bins(const problem& p, unsigned int* positions, double& time)
+{
+	typedef max_rest_key<record> key;
+
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = C ? C : p.K;
+	const unsigned int min_size = p.min_size;
+
 	unsigned int num_open_bins = 1;
 	unsigned int num_full_bins = 0;
 
@@ -90,24 +143,32 @@ unsigned int max_rest_pq(const unsigned int* objects, double& time)
 	// (i.e. bins with _greater_ remaining capacity) are preferred. The
 	// queue is initialized using a single element which corresponds to 1
 	// empty bin.
-	std::priority_queue<unsigned int, std::vector<unsigned int>, std::greater<unsigned int > > pq;
-	pq.push(0);
+	std::priority_queue<typename key::type, std::vector<typename key::type>, std::greater<typename key::type> > pq;
+	pq.push(key::make(0, 0));
 
 	unsigned int limit_capacity = K-min_size;
 	unsigned int bin = 0;
 
 	clock_t start = clock();
+	long long traced = trace_begin();
 	for(unsigned int i = 0; i < n; i++)
 	{
+		if(stop_requested(p, i, num_open_bins+num_full_bins))
+			break;
+
 		// No more bins available, make sure that a new one
 		// is created.
 		if(pq.empty())
 			bin = K;
 		else
-			bin = pq.top();
+			bin = key::fill(pq.top());
 
-		if((bin + objects[i]) <= K)
+		if(!pq.empty() && bin <= K-objects[i])
 		{
+			unsigned int id = key::id(pq.top());
+			if(record)
+				positions[i] = id;
+
 			bin += objects[i];
 			pq.pop();	// always remove the bin; it will be added later
 					// on if its capacity is sufficiently large
@@ -118,20 +179,46 @@ unsigned int max_rest_pq(const unsigned int* objects, double& time)
 				num_full_bins++;
 			}
 			else
-				pq.push(bin);
+				pq.push(key::make(bin, id));
 		}
 
 		// Create a new bin by pushing the object size to the priority
 		// queue
 		else
 		{
+			if(record)
+				positions[i] = num_open_bins+num_full_bins;
+
+			pq.push(key::make(objects[i], num_open_bins+num_full_bins));
 			num_open_bins++;
-			pq.push(objects[i]);
 		}
 	}
 
 	clock_t end = clock();
+	trace_end("pack", "pack", traced);
 	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
 
 	return(num_open_bins+num_full_bins);
 }
+
+struct max_rest_pq_kernel
+{
+	template<unsigned int C> static unsigned int run(const problem& p, unsigned int* positions, double& time)
+	{
+		if(positions != NULL)
+			return(max_rest_pq_bins<true, C>(p, positions, time));
+		else
+			return(max_rest_pq_bins<false, C>(p, positions, time));
+	}
+};
+
+/*!
+	Performs the "Max-Rest" heuristic using priority queue for bin
+	selection. The positions array may be NULL, in which case the queue
+	only stores fill levels.
+*/
+
+unsigned int max_rest_pq(const problem& p, unsigned int* positions, double& time)
+{
+	return(dispatch_capacity<max_rest_pq_kernel>(p, positions, time));
+}
@@ -8,7 +8,9 @@
 #ifndef MAX_REST_H
 #define MAX_REST_H
 
-unsigned int max_rest(const unsigned int*, unsigned int*, double&);
-unsigned int max_rest_pq(const unsigned int* objects, double& time);
+struct problem;
+
+unsigned int max_rest(const problem&, unsigned int*, double&);
+unsigned int max_rest_pq(const problem&, unsigned int*, double&);
 
 #endif
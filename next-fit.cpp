@@ -5,73 +5,321 @@
 	@author Bastian Rieck
 */
 
+#include <chrono>
+#include <system_error>
+#include <thread>
+#include <vector>
+
 #include <cstring>
 #include <ctime>
 #include <cstdlib>
 
 #include "bin-packing.h"
+#include "sorted-view.h"
+#include "fixed-capacity.h"
+#include "trace.h"
 
 /*!
-	Applies the "Next-Fit" heuristic to the current problem. Worst-case
-	running-time is O(n) because the heuristic loops once over the object
-	set and can open new bins in constant time.
+	Implementation of the "Next-Fit" heuristic. C is the capacity if it is
+	known at compile time, else 0. Only the current bin can take objects,
+	so its fill level is the only state that needs to be kept.
 */
 
-unsigned int next_fit(const unsigned int* objects, unsigned int* positions, double& time)
+template<unsigned int C> static unsigned int next_fit_capacity(const problem& p, unsigned int* positions, double& time)
 {
-	unsigned int cur_bin = 0;
-	unsigned int* bins = new unsigned int[n];
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = C ? C : p.K;
 
-	memset(bins, 0, n*sizeof(unsigned int));
-	memset(positions, 0, n*sizeof(unsigned int));
+	unsigned int cur_bin = 0;
+	unsigned int fill = 0;
 
 	clock_t start = clock();
+	long long traced = trace_begin();
 	for(unsigned int i = 0; i < n; i++)
 	{
 		// Check whether the object fits in the current bin...
-		if((bins[cur_bin]+objects[i]) <= K)
-			bins[cur_bin] += objects[i];
+		if(fill <= K-objects[i])
+			fill += objects[i];
 
 		// ...else open a new one
 		else
-			bins[++cur_bin] += objects[i];
+		{
+			fill = objects[i];
+			cur_bin++;
+		}
 
 		positions[i] = cur_bin;
 	}
 
 	clock_t end = clock();
+	trace_end("pack", "pack", traced);
 	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
 
-	delete[] bins;
 	return(cur_bin+1);
 }
 
+struct next_fit_kernel
+{
+	template<unsigned int C> static unsigned int run(const problem& p, unsigned int* positions, double& time)
+	{
+		return(next_fit_capacity<C>(p, positions, time));
+	}
+};
+
 /*!
-	Applies the "Next-Fit-Decreasing" heuristic to the current problem.
-	Since the worst-case running time of "Next-Fit" is O(n), the running
-	time of "Next-Fit-Decreasing" is dominated by the sorting procedure.
-	Hence, the worst-case running time is O(n log n) when using quicksort or
-	O(n) when using csort.
+	Applies the "Next-Fit" heuristic to the current problem. Worst-case
+	running-time is O(n) because the heuristic loops once over the object
+	set and can open new bins in constant time.
 */
 
-unsigned int next_fit_decreasing(	const unsigned* objects,
-					double& time,
-					void (*sort)(void*, size_t, size_t, int (*)(const void*, const void*)))
+unsigned int next_fit(const problem& p, unsigned int* positions, double& time)
 {
-	unsigned int* sorted_objects = new unsigned int[n];
-	unsigned int* positions = new unsigned int[n];
-	memcpy(sorted_objects, objects, n*sizeof(unsigned int));
+	return(dispatch_capacity<next_fit_kernel>(p, positions, time));
+}
+
+/*!
+	Minimum number of objects per chunk of the parallel "Next-Fit"; below
+	that, starting threads costs more than it saves.
+*/
 
-	unsigned int num_bins;
+static const unsigned int min_chunk_size = 1 << 18;
 
-	clock_t start = clock();
-	sort(sorted_objects, n, sizeof(unsigned int), compare_uints); 
-	num_bins = next_fit(sorted_objects, positions, time);
-	clock_t end = clock();
-	
-	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+/*!
+	State of "Next-Fit" at the end of a chunk: the current bin and its fill
+	level.
+*/
+
+struct next_fit_state
+{
+	unsigned int bin;
+	unsigned int fill;
+};
+
+/*!
+	Runs "Next-Fit" on the objects [begin, end) from a given state and
+	returns the state after the last object.
+*/
+
+template<bool record, unsigned int C> static next_fit_state next_fit_chunk(	const problem& p, unsigned int* positions,
+										unsigned int begin, unsigned int end,
+										next_fit_state state)
+{
+	const unsigned int* objects = p.objects;
+	const unsigned int K = C ? C : p.K;
+
+	unsigned int cur_bin = state.bin;
+	unsigned int fill = state.fill;
+
+	for(unsigned int i = begin; i < end; i++)
+	{
+		if(fill <= K-objects[i])
+			fill += objects[i];
+		else
+		{
+			fill = objects[i];
+			cur_bin++;
+		}
+
+		if(record)
+			positions[i] = cur_bin;
+	}
+
+	next_fit_state result = { cur_bin, fill };
+	return(result);
+}
+
+/*!
+	Implementation of the parallel "Next-Fit" heuristic.
+
+	The only state carried from one object to the next is the fill level
+	of the current bin. Every chunk is therefore packed speculatively, in
+	parallel, from an empty bin with local bin numbers. The true state at
+	the start of a chunk is only known once all previous chunks are done;
+	the reconciliation pass walks the chunks in order and replays each
+	chunk from its true state and from the speculative one side by side.
+	As soon as both fill levels agree, both runs make the same decisions
+	for the rest of the chunk, so the speculative result only needs to be
+	shifted by a constant number of bins. Runs agree as soon as both have
+	opened a bin for the same object, which usually takes a few bins, so
+	the sequential part is short. If they never agree, the replay simply
+	covers the whole chunk and the result is still exact.
+
+	Positions are recorded if the array is not NULL. Because several
+	threads are running, the time is wall-clock time rather than processor
+	time.
+*/
+
+template<bool record, unsigned int C> static unsigned int next_fit_parallel_bins(const problem& p, unsigned int* positions, double& time)
+{
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int K = C ? C : p.K;
+
+	unsigned int num_chunks = p.num_threads ? p.num_threads : std::thread::hardware_concurrency();
+	if(num_chunks > n/min_chunk_size)
+		num_chunks = n/min_chunk_size;
+	if(num_chunks == 0)
+		num_chunks = 1;
+
+	std::vector<unsigned int> begin(num_chunks+1);
+	for(unsigned int c = 0; c <= num_chunks; c++)
+		begin[c] = static_cast<unsigned int>(static_cast<unsigned long long>(n)*c/num_chunks);
 
-	delete[] sorted_objects;
-	delete[] positions;
-	return(num_bins);
+	std::vector<next_fit_state> speculative(num_chunks);
+	next_fit_state empty = { 0, 0 };
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Speculation: every chunk starts with an empty bin 0. The first
+	// chunk is packed by the calling thread; its start state is the true
+	// one. Chunks for which no thread can be started are packed by the
+	// calling thread as well.
+	std::vector<std::thread> threads;
+	for(unsigned int c = 1; c < num_chunks; c++)
+	{
+		auto speculate = [&, c]
+		{
+			trace_span span("speculate", "pack");
+			speculative[c] = next_fit_chunk<record, C>(p, positions, begin[c], begin[c+1], empty);
+		};
+
+		try
+		{
+			threads.emplace_back(speculate);
+		}
+		catch(std::system_error&)
+		{
+			speculate();
+		}
+	}
+
+	{
+		trace_span span("speculate", "pack");
+		speculative[0] = next_fit_chunk<record, C>(p, positions, begin[0], begin[1], empty);
+	}
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	long long traced = trace_begin();
+
+	// Reconciliation: replay every chunk from its true state until the
+	// replay agrees with the speculation. Objects before that point get
+	// their true positions here; all later ones are off by delta.
+	std::vector<unsigned int> delta(num_chunks, 0);
+	std::vector<unsigned int> merged(num_chunks, 0);
+
+	next_fit_state state = speculative[0];
+	for(unsigned int c = 1; c < num_chunks; c++)
+	{
+		next_fit_state replay = state;
+		unsigned int spec_bin  = 0;
+		unsigned int spec_fill = 0;
+
+		unsigned int i = begin[c];
+		for(; i < begin[c+1] && replay.fill != spec_fill; i++)
+		{
+			if(replay.fill <= K-objects[i])
+				replay.fill += objects[i];
+			else
+			{
+				replay.fill = objects[i];
+				replay.bin++;
+			}
+
+			if(spec_fill <= K-objects[i])
+				spec_fill += objects[i];
+			else
+			{
+				spec_fill = objects[i];
+				spec_bin++;
+			}
+
+			if(record)
+				positions[i] = replay.bin;
+		}
+
+		merged[c] = i;
+		delta[c]  = replay.bin-spec_bin;
+
+		// Once merged, the chunk ends like the speculation did
+		if(replay.fill == spec_fill)
+		{
+			state.bin  = speculative[c].bin+delta[c];
+			state.fill = speculative[c].fill;
+		}
+		else
+			state = replay;
+	}
+
+	trace_end("reconcile", "pack", traced);
+
+	// Shift the speculative positions of all objects after the merge
+	// points
+	if(record)
+	{
+		threads.clear();
+		for(unsigned int c = 1; c < num_chunks; c++)
+		{
+			auto shift = [&, c]
+			{
+				trace_span span("shift", "pack");
+				for(unsigned int i = merged[c]; i < begin[c+1]; i++)
+					positions[i] += delta[c];
+			};
+
+			try
+			{
+				threads.emplace_back(shift);
+			}
+			catch(std::system_error&)
+			{
+				shift();
+			}
+		}
+
+		for(size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+	}
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	time = std::chrono::duration<double>(end-start).count();
+
+	return(state.bin+1);
+}
+
+struct next_fit_parallel_kernel
+{
+	template<unsigned int C> static unsigned int run(const problem& p, unsigned int* positions, double& time)
+	{
+		if(positions != NULL)
+			return(next_fit_parallel_bins<true, C>(p, positions, time));
+		else
+			return(next_fit_parallel_bins<false, C>(p, positions, time));
+	}
+};
+
+/*!
+	Applies the "Next-Fit" heuristic to the current problem using several
+	threads. The result is identical to next_fit(), bin for bin. The
+	positions array may be NULL.
+*/
+
+unsigned int next_fit_parallel(const problem& p, unsigned int* positions, double& time)
+{
+	return(dispatch_capacity<next_fit_parallel_kernel>(p, positions, time));
+}
+
+/*!
+	Applies the "Next-Fit-Decreasing" heuristic to the current problem.
+	Since the worst-case running time of "Next-Fit" is O(n), the running
+	time of "Next-Fit-Decreasing" is dominated by the sorting procedure,
+	which is O(n) for the counting sort of the shared sorted view. The
+	time does not include sorting.
+*/
+
+unsigned int next_fit_decreasing(const problem& p, unsigned int* positions, double& time)
+{
+	return(next_fit(decreasing(p), positions, time));
 }
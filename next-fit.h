@@ -8,9 +8,10 @@
 #ifndef NEXT_FIT_H
 #define NEXT_FIT_H
 
-unsigned int next_fit(const unsigned int*, unsigned int*, double&);
-unsigned int next_fit_decreasing(	const unsigned*,
-					double&,
-					void (*)(void*, size_t, size_t, int (*)(const void*, const void*)));
+struct problem;
+
+unsigned int next_fit(const problem&, unsigned int*, double&);
+unsigned int next_fit_parallel(const problem&, unsigned int*, double&);
+unsigned int next_fit_decreasing(const problem&, unsigned int*, double&);
 
 #endif
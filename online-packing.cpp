@@ -0,0 +1,136 @@
+/*!
+	@file	online-packing.cpp
+	@brief	Heuristics that pack objects while they arrive
+
+	@author Bastian Rieck
+*/
+
+#include "online-packing.h"
+
+/*!
+	Creates a packer without any bins.
+
+	@param K Capacity of bins
+*/
+
+online_next_fit::online_next_fit(unsigned int K)
+	: K(K), cur_bin(0), fill(0), empty(true)
+{
+}
+
+/*!
+	Packs the next chunk of objects.
+
+	@param objects		Objects of the chunk
+	@param count		Number of objects
+	@param positions	Optional array that will contain the bin of every
+				object of the chunk
+*/
+
+void online_next_fit::add(const unsigned int* objects, unsigned int count, unsigned int* positions)
+{
+	if(count == 0)
+		return;
+
+	unsigned int i = 0;
+	if(empty)
+	{
+		fill  = objects[i];
+		empty = false;
+
+		if(positions != NULL)
+			positions[i] = cur_bin;
+
+		i++;
+	}
+
+	for(; i < count; i++)
+	{
+		if(fill <= K-objects[i])
+			fill += objects[i];
+		else
+		{
+			fill = objects[i];
+			cur_bin++;
+		}
+
+		if(positions != NULL)
+			positions[i] = cur_bin;
+	}
+}
+
+/*!
+	@return Number of bins opened so far.
+*/
+
+unsigned int online_next_fit::num_bins() const
+{
+	return(empty ? 0 : cur_bin+1);
+}
+
+/*!
+	Creates a packer without any bins.
+
+	@param K Capacity of bins
+*/
+
+online_max_rest::online_max_rest(unsigned int K)
+	: K(K), num_opened(0), full_bin(0)
+{
+}
+
+/*!
+	Packs the next chunk of objects. Every object goes to the emptiest
+	bin, or to a new bin if it does not fit there. Among equally full
+	bins, the one that has been opened first is chosen.
+
+	@param objects		Objects of the chunk
+	@param count		Number of objects
+	@param positions	Optional array that will contain the bin of every
+				object of the chunk
+*/
+
+void online_max_rest::add(const unsigned int* objects, unsigned int count, unsigned int* positions)
+{
+	for(unsigned int i = 0; i < count; i++)
+	{
+		unsigned int bin;
+
+		if(!pq.empty() && static_cast<unsigned int>(pq.top() >> 32) <= K-objects[i])
+		{
+			unsigned int fill = static_cast<unsigned int>(pq.top() >> 32)+objects[i];
+			bin = static_cast<unsigned int>(pq.top());
+
+			pq.pop();
+			if(fill < K)
+				pq.push((static_cast<key>(fill) << 32) | bin);
+			else
+				full_bin = bin;
+		}
+
+		// Objects of size 0 still fit into a full bin
+		else if(objects[i] == 0 && num_opened > 0)
+			bin = full_bin;
+
+		else
+		{
+			bin = num_opened++;
+			if(objects[i] < K)
+				pq.push((static_cast<key>(objects[i]) << 32) | bin);
+			else
+				full_bin = bin;
+		}
+
+		if(positions != NULL)
+			positions[i] = bin;
+	}
+}
+
+/*!
+	@return Number of bins opened so far.
+*/
+
+unsigned int online_max_rest::num_bins() const
+{
+	return(num_opened);
+}
@@ -0,0 +1,61 @@
+/*!
+	@file	online-packing.h
+	@brief	Heuristics that pack objects while they arrive
+
+	"Next-Fit" and "Max-Rest" decide the bin of an object without looking
+	at the objects that follow it. They can therefore pack an instance
+	chunk by chunk while the rest of it is still being read. The packers
+	keep the state between two chunks and produce the same number of bins
+	as the heuristics that are run on the whole instance.
+
+	@author Bastian Rieck
+*/
+
+#ifndef ONLINE_PACKING_H
+#define ONLINE_PACKING_H
+
+#include <queue>
+#include <vector>
+#include <functional>
+
+/*!
+	Packs objects with the "Next-Fit" heuristic as they arrive.
+*/
+
+class online_next_fit {
+	public:
+		online_next_fit(unsigned int K);
+
+		void add(const unsigned int* objects, unsigned int count, unsigned int* positions);
+		unsigned int num_bins() const;
+
+	private:
+		unsigned int K;
+		unsigned int cur_bin;
+		unsigned int fill;
+		bool empty;	///< No object has been added yet
+};
+
+/*!
+	Packs objects with the "Max-Rest" heuristic as they arrive. Since the
+	smallest object is not known in advance, only bins that are filled
+	completely leave the queue; the others stay, which only costs time.
+*/
+
+class online_max_rest {
+	public:
+		online_max_rest(unsigned int K);
+
+		void add(const unsigned int* objects, unsigned int count, unsigned int* positions);
+		unsigned int num_bins() const;
+
+	private:
+		typedef unsigned long long key;	///< Fill level in the upper, id in the lower half
+
+		unsigned int K;
+		unsigned int num_opened;
+		unsigned int full_bin;		///< A bin that has been filled completely
+		std::priority_queue<key, std::vector<key>, std::greater<key> > pq;
+};
+
+#endif
@@ -0,0 +1,310 @@
+/*!
+	@file	packing-load.cpp
+	@brief	Load generator for the packing server
+
+	Opens a number of connections to the server and sends random
+	instances over each of them, keeping a fixed number of requests in
+	flight per connection. Reports the latency distribution and the
+	throughput.
+
+	Every connection uses one thread for sending and one for receiving,
+	so that a client blocked by backpressure never stops reading its
+	responses.
+
+	@author Bastian Rieck
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <random>
+
+#include <cstdlib>
+#include <cstring>
+
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "bin-packing-api.h"
+#include "packing-protocol.h"
+
+using namespace std;
+
+typedef chrono::steady_clock load_clock;
+
+/*!
+	Options of the load generator.
+*/
+
+struct load_options
+{
+	const char* path;		///< Path of the socket
+	unsigned int num_connections;	///< Number of concurrent connections
+	unsigned int num_requests;	///< Number of requests per connection
+	unsigned int depth;		///< Requests in flight per connection
+	unsigned int n;			///< Number of items per instance
+	unsigned int K;			///< Capacity of bins
+	bp_heuristic heuristic;
+	bool assignment;		///< Request assignments
+};
+
+/*!
+	Results of a single connection.
+*/
+
+struct connection_results
+{
+	vector<double> latencies;	///< Latency of every request, in seconds
+	unsigned long errors;
+	unsigned long long num_bins;
+};
+
+/*!
+	Number of distinct instances sent by each connection.
+*/
+
+static const unsigned int num_instances = 16;
+
+/*!
+	Runs a single connection until all of its requests have been
+	answered.
+*/
+
+void run_connection(unsigned int index, const load_options* options, connection_results* results)
+{
+	results->errors   = 0;
+	results->num_bins = 0;
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, options->path, sizeof(address.sun_path)-1);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0 || connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0)
+	{
+		cerr << "bin-packing-load: Unable to connect to " << options->path << ": " << strerror(errno) << "\n";
+		results->errors = options->num_requests;
+
+		if(fd >= 0)
+			close(fd);
+		return;
+	}
+
+	// Instances are generated in advance, so the sender measures the
+	// server rather than the random number generator
+	mt19937 rng(index);
+	uniform_int_distribution<unsigned int> size(1, options->K);
+
+	vector< vector<unsigned int> > instances(num_instances);
+	for(unsigned int i = 0; i < num_instances; i++)
+	{
+		instances[i].resize(options->n);
+		for(unsigned int j = 0; j < options->n; j++)
+			instances[i][j] = size(rng);
+	}
+
+	vector<load_clock::time_point> sent(options->num_requests);
+	results->latencies.assign(options->num_requests, -1.0);
+
+	mutex lock;
+	condition_variable window;
+	unsigned int in_flight = 0;
+	bool failed = false;
+
+	thread receiver([&]
+	{
+		vector<unsigned int> assignment;
+		for(unsigned int i = 0; i < options->num_requests; i++)
+		{
+			response_header r;
+			bool ok = read_full(fd, &r, sizeof(r)) && r.magic == response_magic && r.id < options->num_requests;
+			if(ok && r.n > 0)
+			{
+				assignment.resize(r.n);
+				ok = read_full(fd, assignment.data(), r.n*sizeof(unsigned int));
+			}
+
+			load_clock::time_point now = load_clock::now();
+
+			lock_guard<mutex> guard(lock);
+			if(!ok)
+			{
+				failed = true;
+				results->errors += options->num_requests-i;
+				window.notify_all();
+				break;
+			}
+
+			results->latencies[r.id] = chrono::duration<double>(now-sent[r.id]).count();
+			if(r.status != BP_OK)
+				results->errors++;
+			else
+				results->num_bins += r.num_bins;
+
+			in_flight--;
+			window.notify_all();
+		}
+	});
+
+	for(unsigned int i = 0; i < options->num_requests; i++)
+	{
+		const vector<unsigned int>& items = instances[i % num_instances];
+
+		request_header h;
+		h.magic		= request_magic;
+		h.id		= i;
+		h.heuristic	= options->heuristic;
+		h.flags		= options->assignment ? want_assignment : 0;
+		h.capacity	= options->K;
+		h.n		= options->n;
+
+		{
+			unique_lock<mutex> guard(lock);
+			window.wait(guard, [&] { return(in_flight < options->depth || failed); });
+
+			if(failed)
+				break;
+
+			in_flight++;
+			sent[i] = load_clock::now();
+		}
+
+		if(	!write_full(fd, &h, sizeof(h)) ||
+			!write_full(fd, items.data(), items.size()*sizeof(unsigned int)))
+		{
+			cerr << "bin-packing-load: Connection closed by server\n";
+			break;
+		}
+	}
+
+	receiver.join();
+	close(fd);
+}
+
+/*!
+	@return Value at a given fraction of a sorted sample.
+*/
+
+double percentile(const vector<double>& sorted, double fraction)
+{
+	if(sorted.empty())
+		return(0.0);
+
+	size_t index = static_cast<size_t>(fraction*(sorted.size()-1) + 0.5);
+	return(sorted[index]);
+}
+
+void usage()
+{
+	cerr	<< "Usage: bin-packing-load [-s socket] [-c connections] [-r requests per connection]\n"
+		<< "                        [-d depth] [-n items] [-K capacity] [-h heuristic] [-A]\n";
+}
+
+int main(int argc, char* argv[])
+{
+	load_options options;
+	options.path		= default_socket_path;
+	options.num_connections	= 4;
+	options.num_requests	= 1000;
+	options.depth		= 8;
+	options.n		= 1000;
+	options.K		= 1000;
+	options.heuristic	= BP_FIRST_FIT_DECREASING_MAP;
+	options.assignment	= false;
+
+	int c;
+	while((c = getopt(argc, argv, "s:c:r:d:n:K:h:A")) != -1)
+	{
+		switch(c)
+		{
+			case 's':
+				options.path = optarg;
+				break;
+			case 'c':
+				options.num_connections = atoi(optarg);
+				break;
+			case 'r':
+				options.num_requests = atoi(optarg);
+				break;
+			case 'd':
+				options.depth = atoi(optarg);
+				break;
+			case 'n':
+				options.n = atoi(optarg);
+				break;
+			case 'K':
+				options.K = atoi(optarg);
+				break;
+			case 'h':
+				options.heuristic = static_cast<bp_heuristic>(atoi(optarg));
+				break;
+			case 'A':
+				options.assignment = true;
+				break;
+			default:
+				usage();
+				return(-1);
+		}
+	}
+
+	if(	options.num_connections == 0 || options.num_requests == 0 || options.depth == 0 ||
+		options.n == 0 || options.K == 0 || bp_heuristic_name(options.heuristic) == NULL)
+	{
+		usage();
+		return(-1);
+	}
+
+	vector<connection_results> results(options.num_connections);
+	vector<thread> threads;
+
+	load_clock::time_point start = load_clock::now();
+	for(unsigned int i = 0; i < options.num_connections; i++)
+		threads.push_back(thread(run_connection, i, &options, &results[i]));
+
+	for(unsigned int i = 0; i < options.num_connections; i++)
+		threads[i].join();
+
+	double elapsed = chrono::duration<double>(load_clock::now()-start).count();
+
+	vector<double> latencies;
+	unsigned long errors = 0;
+	unsigned long long num_bins = 0;
+
+	for(unsigned int i = 0; i < options.num_connections; i++)
+	{
+		// Requests that have not been answered are not counted
+		for(size_t j = 0; j < results[i].latencies.size(); j++)
+			if(results[i].latencies[j] >= 0.0)
+				latencies.push_back(results[i].latencies[j]);
+
+		errors   += results[i].errors;
+		num_bins += results[i].num_bins;
+	}
+
+	sort(latencies.begin(), latencies.end());
+
+	unsigned long total     = static_cast<unsigned long>(options.num_connections)*options.num_requests;
+	unsigned long succeeded = total-errors;
+
+	cout	<< "Heuristic:    " << bp_heuristic_name(options.heuristic) << (options.assignment ? " (with assignment)" : "") << "\n"
+		<< "Connections:  " << options.num_connections << " x " << options.num_requests
+				  << " requests, depth " << options.depth << "\n"
+		<< "Instances:    " << options.n << " items, capacity " << options.K << "\n"
+		<< "Errors:       " << errors << "\n"
+		<< fixed << setprecision(3)
+		<< "Latency p50:  " << 1000.0*percentile(latencies, 0.50) << " ms\n"
+		<< "Latency p99:  " << 1000.0*percentile(latencies, 0.99) << " ms\n"
+		<< "Latency max:  " << 1000.0*(latencies.empty() ? 0.0 : latencies.back()) << " ms\n"
+		<< setprecision(1)
+		<< "Throughput:   " << succeeded/elapsed << " requests/s\n"
+		<< "Mean bins:    " << (succeeded > 0 ? num_bins/static_cast<double>(succeeded) : 0.0) << "\n";
+
+	return(errors == 0 ? 0 : -1);
+}
@@ -0,0 +1,98 @@
+/*!
+	@file	packing-protocol.h
+	@brief	Binary framing used by the packing server and its clients
+
+	Every request consists of a request header followed by n item sizes.
+	Every response consists of a response header followed by the
+	assignment of items to bins, if it was requested. All fields are
+	unsigned 32 bit integers in host byte order, which is sufficient for a
+	Unix domain socket. Responses are sent in the order of the requests
+	of a connection, so clients may pipeline requests.
+
+	@author Bastian Rieck
+*/
+
+#ifndef PACKING_PROTOCOL_H
+#define PACKING_PROTOCOL_H
+
+#include <cerrno>
+#include <cstddef>
+#include <stdint.h>
+#include <unistd.h>
+
+static const uint32_t request_magic	= 0x51525042;	///< "BPRQ"
+static const uint32_t response_magic	= 0x53525042;	///< "BPRS"
+
+static const uint32_t want_assignment	= 1;		///< Request flag
+
+static const char* default_socket_path	= "/tmp/bin-packing.sock";
+
+struct request_header
+{
+	uint32_t magic;
+	uint32_t id;		///< Chosen by the client; echoed in the response
+	uint32_t heuristic;	///< Value of bp_heuristic
+	uint32_t flags;
+	uint32_t capacity;
+	uint32_t n;		///< Number of items that follow
+};
+
+struct response_header
+{
+	uint32_t magic;
+	uint32_t id;
+	uint32_t status;	///< Status code of the library
+	uint32_t num_bins;	///< Bins of the partial result for BP_ERROR_DEADLINE
+	uint32_t n;		///< Number of assignment entries that follow
+	uint32_t time_us;	///< Processing time within the server
+};
+
+/*!
+	Reads exactly the requested number of bytes from a file descriptor.
+
+	@return true on success, false on EOF or error.
+*/
+
+inline bool read_full(int fd, void* buffer, size_t bytes)
+{
+	char* p = static_cast<char*>(buffer);
+	while(bytes > 0)
+	{
+		ssize_t r = read(fd, p, bytes);
+		if(r < 0 && errno == EINTR)
+			continue;
+		if(r <= 0)
+			return(false);
+
+		p     += r;
+		bytes -= r;
+	}
+
+	return(true);
+}
+
+/*!
+	Writes exactly the requested number of bytes to a file descriptor.
+
+	@return true on success, false on error.
+*/
+
+inline bool write_full(int fd, const void* buffer, size_t bytes)
+{
+	const char* p = static_cast<const char*>(buffer);
+	while(bytes > 0)
+	{
+		ssize_t w = write(fd, p, bytes);
+		if(w < 0 && errno == EINTR)
+			continue;
+		if(w <= 0)
+			return(false);
+
+		p     += w;
+		bytes -= w;
+	}
+
+	return(true);
+}
+
+#endif
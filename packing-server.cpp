@@ -0,0 +1,787 @@
+/*!
+	@file	packing-server.cpp
+	@brief	Long-running packing daemon listening on a Unix domain socket
+
+	The server keeps a pool of worker threads, each of which owns a
+	context of the library. Contexts are warmed up at start, so their
+	scratch buffers are already reserved when the first request arrives.
+
+	Every connection is served by a reader thread that parses requests
+	and puts them into a bounded queue shared by all workers. Clients may
+	pipeline requests; responses are sent in the order of the requests.
+	Backpressure is applied in two places: a connection may only have a
+	limited number of requests in flight, and the reader blocks if the
+	queue is full. In both cases, the server stops reading from the
+	socket, so the client eventually blocks when sending.
+
+	Requests are either framed as described in packing-protocol.h, or
+	use the text format of the data files (n, K, followed by all sizes).
+	A connection uses the text format if its first byte is not the start
+	of the request magic. Text requests are answered with the number of
+	bins on a single line; the heuristic is chosen when starting the
+	server.
+
+	Optionally, all workers share an in-memory result cache, so repeated
+	instances are answered without packing them again. Requests may also
+	be given a deadline; a heuristic that misses it is stopped, so a slow
+	request cannot hold up a worker for long.
+
+	@author Bastian Rieck
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include <cctype>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "bin-packing-api.h"
+#include "packing-protocol.h"
+
+using namespace std;
+
+/*!
+	Options of the server.
+*/
+
+struct server_options
+{
+	const char* path;		///< Path of the socket
+	unsigned int num_workers;	///< Number of worker threads
+	unsigned int queue_size;	///< Maximum number of queued requests
+	unsigned int window;		///< Maximum number of requests in flight per connection
+	unsigned int max_items;		///< Maximum number of items per request
+	unsigned int warmup;		///< Number of items used for warming up contexts
+	bp_heuristic text_heuristic;	///< Heuristic for requests in text format
+	double deadline;		///< Seconds per request from its arrival; 0 for none
+	bp_cache* cache;		///< Results shared by all workers, or NULL
+	const char* trace_path;		///< Trace written on termination, or NULL
+};
+
+/*!
+	State of a single client connection. The connection is closed as soon
+	as the reader is done and all of its requests have been answered.
+*/
+
+struct connection
+{
+	connection(int fd)
+		: fd(fd), next_seq(0), next_write(0), in_flight(0), writing(false), broken(false)
+	{
+	}
+
+	~connection()
+	{
+		close(fd);
+	}
+
+	void complete(unsigned long seq, string& response);
+
+	int fd;
+
+	mutex lock;
+	condition_variable window;	///< Signalled whenever a response has been sent
+
+	unsigned long next_seq;		///< Sequence number of the next request
+	unsigned long next_write;	///< Sequence number of the next response
+	unsigned int in_flight;		///< Requests read but not yet answered
+	bool writing;			///< A thread is currently sending responses
+	bool broken;			///< Sending failed; the client is gone
+
+	map<unsigned long, string> ready; ///< Responses waiting for their predecessors
+};
+
+/*!
+	Stores the response to a request and sends all responses that are now
+	in order. Only one thread writes to the socket at any time; the other
+	threads leave their responses to it.
+
+	@param seq		Sequence number of the request
+	@param response		Response; the contents are taken over
+*/
+
+void connection::complete(unsigned long seq, string& response)
+{
+	unique_lock<mutex> guard(lock);
+	ready[seq].swap(response);
+
+	if(writing)
+		return;
+
+	writing = true;
+	while(!ready.empty() && ready.begin()->first == next_write)
+	{
+		string data;
+		data.swap(ready.begin()->second);
+		ready.erase(ready.begin());
+
+		guard.unlock();
+		bool sent = !broken && write_full(fd, data.data(), data.size());
+		guard.lock();
+
+		if(!sent && !broken)
+		{
+			broken = true;
+			shutdown(fd, SHUT_RDWR);
+		}
+
+		next_write++;
+		in_flight--;
+		window.notify_all();
+	}
+
+	writing = false;
+}
+
+/*!
+	@return Monotonic time in microseconds.
+*/
+
+unsigned long long now_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return(ts.tv_sec*1000000ull + ts.tv_nsec/1000);
+}
+
+/*!
+	A request that has been read from a connection but not yet processed.
+*/
+
+struct job
+{
+	shared_ptr<connection> conn;
+	unsigned long seq;
+	bool text;
+
+	request_header header;
+	vector<unsigned int> items;
+
+	int status;			///< Error detected while reading, else BP_OK
+	unsigned long long arrival;	///< Time the request has been read, see now_us()
+};
+
+/*!
+	Bounded queue of requests. Pushing blocks while the queue is full,
+	popping blocks while it is empty.
+*/
+
+class job_queue
+{
+	public:
+		job_queue(unsigned int capacity)
+			: capacity(capacity)
+		{
+		}
+
+		void push(job* j)
+		{
+			unique_lock<mutex> guard(lock);
+			not_full.wait(guard, [this] { return(jobs.size() < capacity); });
+
+			jobs.push_back(j);
+			not_empty.notify_one();
+		}
+
+		job* pop()
+		{
+			unique_lock<mutex> guard(lock);
+			not_empty.wait(guard, [this] { return(!jobs.empty()); });
+
+			job* j = jobs.front();
+			jobs.pop_front();
+
+			not_full.notify_one();
+			return(j);
+		}
+
+	private:
+		size_t capacity;
+		deque<job*> jobs;
+
+		mutex lock;
+		condition_variable not_empty;
+		condition_variable not_full;
+};
+
+/*!
+	Buffered reader for a socket that is able to parse both the binary
+	framing and the text format.
+*/
+
+class stream_reader
+{
+	public:
+		stream_reader(int fd)
+			: fd(fd), begin(0), end(0)
+		{
+		}
+
+		/*!
+			@return Next byte without consuming it, or -1 on EOF.
+		*/
+
+		int peek()
+		{
+			if(begin == end && !fill())
+				return(-1);
+
+			return(static_cast<unsigned char>(buffer[begin]));
+		}
+
+		/*!
+			Reads a fixed number of bytes.
+
+			@return true on success, false on EOF or error.
+		*/
+
+		bool read(void* destination, size_t bytes)
+		{
+			char* p = static_cast<char*>(destination);
+			while(bytes > 0)
+			{
+				if(begin == end && !fill())
+					return(false);
+
+				size_t chunk = end-begin < bytes ? end-begin : bytes;
+				memcpy(p, buffer+begin, chunk);
+
+				begin += chunk;
+				p     += chunk;
+				bytes -= chunk;
+			}
+
+			return(true);
+		}
+
+		/*!
+			Reads an unsigned number in text format, skipping any
+			whitespace in front of it.
+
+			@return true on success, false on EOF or if the next
+			token is not a number.
+		*/
+
+		bool read_number(unsigned int& x)
+		{
+			int c;
+			while((c = peek()) >= 0 && isspace(c))
+				begin++;
+
+			if(c < 0 || !isdigit(c))
+				return(false);
+
+			unsigned long long value = 0;
+			while((c = peek()) >= 0 && isdigit(c))
+			{
+				value = 10*value + (c-'0');
+				if(value > 0xFFFFFFFFull)
+					return(false);
+
+				begin++;
+			}
+
+			x = static_cast<unsigned int>(value);
+			return(true);
+		}
+
+	private:
+		bool fill()
+		{
+			ssize_t r;
+			do
+				r = ::read(fd, buffer, sizeof(buffer));
+			while(r < 0 && errno == EINTR);
+
+			if(r <= 0)
+				return(false);
+
+			begin = 0;
+			end   = r;
+			return(true);
+		}
+
+		int fd;
+		char buffer[65536];
+		size_t begin;
+		size_t end;
+};
+
+/*!
+	Reads a single request from a connection.
+
+	@param in		Reader of the connection
+	@param j		Job that will contain the request
+	@param options		Options of the server
+
+	@return false if no further requests can be read from the connection.
+	If the request is malformed, the status of the job is set and the
+	connection is closed after it has been answered.
+*/
+
+bool read_request(stream_reader& in, job& j, const server_options& options)
+{
+	j.status = BP_OK;
+	memset(&j.header, 0, sizeof(j.header));
+
+	if(j.text)
+	{
+		unsigned int n, K;
+		if(!in.read_number(n) || !in.read_number(K))
+			return(false);
+
+		j.header.heuristic = options.text_heuristic;
+		j.header.capacity  = K;
+		j.header.n	   = n;
+	}
+	else
+	{
+		if(!in.read(&j.header, sizeof(j.header)))
+			return(false);
+
+		if(j.header.magic != request_magic)
+		{
+			j.status = BP_ERROR_INVALID_ARGUMENT;
+			return(true);
+		}
+	}
+
+	if(j.header.n > options.max_items)
+	{
+		j.status = BP_ERROR_OUT_OF_MEMORY;
+		return(true);
+	}
+
+	// Waiting for the next request is not part of the span
+	bp_span span;
+	bp_span_begin(&span, "read items", "parse");
+
+	j.items.resize(j.header.n);
+	if(j.text)
+	{
+		for(unsigned int i = 0; i < j.header.n; i++)
+			if(!in.read_number(j.items[i]))
+				return(false);
+	}
+	else if(!in.read(j.items.data(), j.header.n*sizeof(unsigned int)))
+		return(false);
+
+	bp_span_end(&span);
+	return(true);
+}
+
+/*!
+	Reads all requests of a connection and hands them to the workers.
+	Runs in a thread of its own for every connection.
+*/
+
+void serve_connection(shared_ptr<connection> conn, job_queue* queue, const server_options* options)
+{
+	stream_reader in(conn->fd);
+	bp_trace_thread_name("connection");
+
+	int first = in.peek();
+	if(first < 0)
+		return;
+
+	bool text = (first != static_cast<int>(request_magic & 0xFF));
+
+	for(;;)
+	{
+		// Stop reading while too many requests are in flight; the
+		// client is throttled by the socket buffers
+		{
+			unique_lock<mutex> guard(conn->lock);
+			conn->window.wait(guard, [&] { return(conn->in_flight < options->window || conn->broken); });
+
+			if(conn->broken)
+				break;
+		}
+
+		job* j = new job;
+		j->conn = conn;
+		j->text = text;
+
+		if(!read_request(in, *j, *options))
+		{
+			delete j;
+			break;
+		}
+
+		j->arrival = now_us();
+
+		{
+			lock_guard<mutex> guard(conn->lock);
+			j->seq = conn->next_seq++;
+			conn->in_flight++;
+		}
+
+		bool malformed = (j->status != BP_OK);
+		queue->push(j);
+
+		// The stream cannot be resynchronized after a malformed
+		// request
+		if(malformed)
+			break;
+	}
+
+	shutdown(conn->fd, SHUT_RD);
+}
+
+/*!
+	Packs a synthetic instance with the fast heuristics, so that the
+	scratch buffers of a context are reserved before the first request.
+
+	@param ctx	Context to warm up
+	@param n	Number of items of the synthetic instance
+*/
+
+void warm_up(bp_context* ctx, unsigned int n)
+{
+	if(n == 0)
+		return;
+
+	const unsigned int K = 1000;
+	vector<unsigned int> items(n);
+	vector<unsigned int> assignment(n);
+
+	unsigned int state = 12345;
+	for(unsigned int i = 0; i < n; i++)
+	{
+		state = state*1103515245u + 12345u;
+		items[i] = 1 + (state >> 16) % K;
+	}
+
+	bp_result result;
+	bp_set_instance(ctx, items.data(), n, K);
+
+	bp_run(ctx, BP_MAX_REST_PQ, NULL, &result);
+	bp_run(ctx, BP_FIRST_FIT_MAP, assignment.data(), &result);
+	bp_run(ctx, BP_FIRST_FIT_DECREASING, assignment.data(), &result);
+	bp_run(ctx, BP_BEST_FIT_HEAP, NULL, &result);
+	bp_run(ctx, BP_BEST_FIT_LOOKUP, NULL, &result);
+}
+
+/*!
+	Processes a request and returns the encoded response. Repeated
+	instances are answered from the result cache, if there is one.
+
+	If the request has a deadline, the time it has spent in the queue
+	counts as well. A request that misses its deadline is answered with
+	BP_ERROR_DEADLINE and the number of bins of the partial result.
+*/
+
+string process(bp_context* ctx, bp_cache* cache, double deadline, const job& j)
+{
+	unsigned long long start = now_us();
+
+	const request_header& h = j.header;
+	bp_result result;
+	result.num_bins = 0;
+
+	bool assign = !j.text && (h.flags & want_assignment);
+	string response;
+
+	// The assignment is written directly behind the header of the
+	// response, so it does not have to be copied
+	if(!j.text)
+		response.resize(sizeof(response_header) + (assign ? h.n*sizeof(unsigned int) : 0));
+
+	unsigned int* assignment = NULL;
+	if(assign)
+		assignment = reinterpret_cast<unsigned int*>(&response[sizeof(response_header)]);
+
+	bp_heuristic heuristic = static_cast<bp_heuristic>(h.heuristic);
+	bp_cache_key key;
+
+	int status = j.status;
+	bool cached = false;
+
+	if(status == BP_OK && cache != NULL)
+	{
+		bp_cache_key_items(j.items.data(), h.n, h.capacity, &key);
+		cached = bp_cache_lookup(cache, &key, heuristic, NULL, &result, assignment, h.n) == BP_OK;
+	}
+
+	if(status == BP_OK && !cached)
+		status = bp_set_instance(ctx, j.items.data(), h.n, h.capacity);
+
+	if(status == BP_OK && !cached && deadline > 0.0)
+	{
+		double remaining = deadline - (now_us()-j.arrival)/1e6;
+		if(remaining > 0.0)
+			bp_set_deadline(ctx, remaining);
+		else
+			status = BP_ERROR_DEADLINE;
+	}
+
+	// Results are always stored with an assignment, so that they can
+	// answer every kind of request later on
+	static thread_local vector<unsigned int> scratch;
+	unsigned int* bins = assignment;
+
+	if(status == BP_OK && !cached && cache != NULL && bins == NULL)
+	{
+		scratch.resize(h.n);
+		bins = scratch.data();
+	}
+
+	if(status == BP_OK && !cached)
+		status = bp_run(ctx, heuristic, bins, &result);
+
+	if(status == BP_OK && !cached && cache != NULL)
+	{
+		bp_instance_info info;
+		bp_get_instance_info(ctx, &info);
+		bp_cache_store(cache, &key, heuristic, &info, &result, bins);
+	}
+
+	if(j.text)
+	{
+		if(status == BP_OK)
+			response = to_string(result.num_bins) + "\n";
+		else
+			response = string("error: ") + bp_strerror(status) + "\n";
+
+		return(response);
+	}
+
+	if(status != BP_OK)
+		response.resize(sizeof(response_header));
+
+	response_header r;
+	r.magic		= response_magic;
+	r.id		= h.id;
+	r.status	= status;
+	r.num_bins	= result.num_bins;
+	r.n		= (status == BP_OK && assign) ? h.n : 0;
+	r.time_us	= static_cast<uint32_t>(now_us()-start);
+
+	memcpy(&response[0], &r, sizeof(r));
+	return(response);
+}
+
+/*!
+	Worker thread. Owns a context for its whole lifetime, so scratch
+	memory is reused across requests.
+*/
+
+void work(job_queue* queue, const server_options* options)
+{
+	bp_context* ctx = bp_context_create();
+	if(ctx == NULL)
+	{
+		cerr << "bin-packing-server: Unable to create context\n";
+		exit(-1);
+	}
+
+	bp_trace_thread_name("worker");
+
+	bp_span span;
+	bp_span_begin(&span, "warm up", "allocation");
+	warm_up(ctx, options->warmup);
+	bp_span_end(&span);
+
+	for(;;)
+	{
+		job* j = queue->pop();
+
+		bp_span span;
+		bp_span_begin(&span, "request", "request");
+
+		string response = process(ctx, options->cache, options->deadline, *j);
+
+		bp_span send;
+		bp_span_begin(&send, "send", "output");
+		j->conn->complete(j->seq, response);
+		bp_span_end(&send);
+
+		bp_span_end(&span);
+		delete j;
+	}
+}
+
+/*!
+	Waits until the server is terminated by SIGINT or SIGTERM, writes the
+	trace, if any, and removes the socket. The signals are blocked in all
+	other threads and accepted here, so that the trace is not written by
+	a signal handler.
+
+	@param signals	SIGINT and SIGTERM
+	@param options	Options of the server
+*/
+
+void wait_for_termination(sigset_t signals, const server_options* options)
+{
+	int signal;
+	while(sigwait(&signals, &signal) != 0)
+		;
+
+	if(options->trace_path != NULL && bp_write_trace(options->trace_path) != BP_OK)
+		cerr << "bin-packing-server: Unable to write the trace to " << options->trace_path << "\n";
+
+	unlink(options->path);
+	_exit(0);
+}
+
+void usage()
+{
+	cerr	<< "Usage: bin-packing-server [-s socket] [-t workers] [-q queue size]\n"
+		<< "                          [-w window] [-m max. items] [-W warm-up items]\n"
+		<< "                          [-h heuristic for text requests] [-C cache MiB]\n"
+		<< "                          [-T deadline ms] [-J trace file]\n";
+}
+
+int main(int argc, char* argv[])
+{
+	server_options options;
+	options.path		= default_socket_path;
+	options.num_workers	= thread::hardware_concurrency();
+	options.queue_size	= 0;
+	options.window		= 32;
+	options.max_items	= 1 << 24;
+	options.warmup		= 100000;
+	options.text_heuristic	= BP_FIRST_FIT_DECREASING_MAP;
+	options.cache		= NULL;
+	options.deadline	= 0.0;
+	options.trace_path	= NULL;
+
+	size_t cache_size = 0;
+
+	int c;
+	while((c = getopt(argc, argv, "s:t:q:w:m:W:h:C:T:J:")) != -1)
+	{
+		switch(c)
+		{
+			case 's':
+				options.path = optarg;
+				break;
+			case 't':
+				options.num_workers = atoi(optarg);
+				break;
+			case 'q':
+				options.queue_size = atoi(optarg);
+				break;
+			case 'w':
+				options.window = atoi(optarg);
+				break;
+			case 'm':
+				options.max_items = atoi(optarg);
+				break;
+			case 'W':
+				options.warmup = atoi(optarg);
+				break;
+			case 'h':
+				options.text_heuristic = static_cast<bp_heuristic>(atoi(optarg));
+				break;
+			case 'C':
+				cache_size = strtoul(optarg, NULL, 10) << 20;
+				break;
+			case 'T':
+				options.deadline = strtoul(optarg, NULL, 10)/1000.0;
+				break;
+			case 'J':
+				options.trace_path = optarg;
+				break;
+			default:
+				usage();
+				return(-1);
+		}
+	}
+
+	if(options.num_workers == 0)
+		options.num_workers = 1;
+	if(options.queue_size == 0)
+		options.queue_size = 4*options.num_workers;
+	if(options.window == 0)
+		options.window = 1;
+
+	if(bp_heuristic_name(options.text_heuristic) == NULL)
+	{
+		cerr << "bin-packing-server: Unknown heuristic\n";
+		return(-1);
+	}
+
+	if(cache_size > 0)
+		options.cache = bp_cache_create(NULL, cache_size);
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if(strlen(options.path) >= sizeof(address.sun_path))
+	{
+		cerr << "bin-packing-server: Socket path too long\n";
+		return(-1);
+	}
+
+	strcpy(address.sun_path, options.path);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(options.path);
+
+	if(	listener < 0 ||
+		bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0 ||
+		listen(listener, 128) < 0)
+	{
+		cerr << "bin-packing-server: Unable to listen on " << options.path << ": " << strerror(errno) << "\n";
+		return(-1);
+	}
+
+	// All threads inherit the blocked signals
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	if(options.trace_path != NULL)
+	{
+		bp_set_tracing(1);
+		bp_trace_thread_name("listener");
+	}
+
+	thread(wait_for_termination, signals, &options).detach();
+
+	job_queue queue(options.queue_size);
+	for(unsigned int i = 0; i < options.num_workers; i++)
+		thread(work, &queue, &options).detach();
+
+	cerr	<< "bin-packing-server: Listening on " << options.path << " with "
+		<< options.num_workers << " workers, queue size " << options.queue_size
+		<< ", window " << options.window << "\n";
+
+	for(;;)
+	{
+		int fd = accept(listener, NULL, NULL);
+		if(fd < 0)
+		{
+			if(errno == EINTR || errno == ECONNABORTED)
+				continue;
+
+			cerr << "bin-packing-server: " << strerror(errno) << "\n";
+			break;
+		}
+
+		thread(serve_connection, make_shared<connection>(fd), &queue, &options).detach();
+	}
+
+	unlink(options.path);
+	return(-1);
+}
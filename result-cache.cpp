@@ -0,0 +1,417 @@
+/*!
+	@file	result-cache.cpp
+	@brief	Content-addressed cache of packing results
+
+	@author Bastian Rieck
+*/
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "result-cache.h"
+#include "assignment.h"
+
+/*!
+	Approximate bookkeeping cost of an entry held in memory.
+*/
+
+static const size_t entry_overhead = 64;
+
+static inline uint64_t rotl(uint64_t x, int r)
+{
+	return((x << r) | (x >> (64-r)));
+}
+
+static inline uint64_t fmix(uint64_t k)
+{
+	k ^= k >> 33;
+	k *= 0xFF51AFD7ED558CCDull;
+	k ^= k >> 33;
+	k *= 0xC4CEB9FE1A85EC53ull;
+	k ^= k >> 33;
+
+	return(k);
+}
+
+/*!
+	Computes a 128 bit hash of a buffer using the MurmurHash3 x64 scheme,
+	which processes 16 bytes per step and runs at several GB/s. The hash
+	is not cryptographic, but collisions of unrelated instances are
+	negligible.
+
+	@param data	Buffer
+	@param size	Size of the buffer in bytes
+	@param seed	Seed that separates different kinds of keys
+	@param hash	Will contain the hash
+*/
+
+void hash_bytes(const void* data, size_t size, uint64_t seed, uint64_t hash[2])
+{
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	const uint64_t c1 = 0x87C37B91114253D5ull;
+	const uint64_t c2 = 0x4CF5AD432745937Full;
+
+	uint64_t h1 = seed;
+	uint64_t h2 = seed;
+
+	size_t blocks = size/16;
+	for(size_t i = 0; i < blocks; i++, p += 16)
+	{
+		uint64_t k1, k2;
+		memcpy(&k1, p,	 sizeof(k1));
+		memcpy(&k2, p+8, sizeof(k2));
+
+		k1 *= c1; k1 = rotl(k1, 31); k1 *= c2; h1 ^= k1;
+		h1 = rotl(h1, 27); h1 += h2; h1 = h1*5+0x52DCE729;
+
+		k2 *= c2; k2 = rotl(k2, 33); k2 *= c1; h2 ^= k2;
+		h2 = rotl(h2, 31); h2 += h1; h2 = h2*5+0x38495AB5;
+	}
+
+	// Remaining bytes; the first eight go into k1, the others into k2
+	uint64_t k1 = 0;
+	uint64_t k2 = 0;
+
+	size_t tail = size & 15;
+	for(size_t i = tail; i > 8; i--)
+		k2 |= static_cast<uint64_t>(p[i-1]) << (8*(i-9));
+	for(size_t i = (tail < 8 ? tail : 8); i > 0; i--)
+		k1 |= static_cast<uint64_t>(p[i-1]) << (8*(i-1));
+
+	if(tail > 8)
+	{
+		k2 *= c2; k2 = rotl(k2, 33); k2 *= c1; h2 ^= k2;
+	}
+
+	if(tail > 0)
+	{
+		k1 *= c1; k1 = rotl(k1, 31); k1 *= c2; h1 ^= k1;
+	}
+
+	h1 ^= size;
+	h2 ^= size;
+
+	h1 += h2;
+	h2 += h1;
+
+	h1 = fmix(h1);
+	h2 = fmix(h2);
+
+	h1 += h2;
+	h2 += h1;
+
+	hash[0] = h1;
+	hash[1] = h2;
+}
+
+/*!
+	Creates a cache.
+
+	@param directory	Directory for entries on disk; NULL to keep
+				entries only in memory. The directory is created
+				if it does not exist.
+	@param memory_limit	Maximum size of the entries held in memory; 0
+				disables the in-memory level
+*/
+
+result_cache::result_cache(const char* directory, size_t memory_limit)
+	: directory(directory != NULL ? directory : ""),
+	  memory_limit(memory_limit),
+	  memory_used(0),
+	  num_hits(0),
+	  num_disk_hits(0),
+	  num_misses(0),
+	  num_stores(0),
+	  num_temporary(0)
+{
+	if(!this->directory.empty())
+		mkdir(directory, 0755);
+}
+
+/*!
+	Looks up the result of a heuristic for an instance.
+
+	@param key		Hash of the instance
+	@param heuristic	Heuristic
+	@param entry		Will contain the cached result
+	@param bins		Optional array that will contain the assignment. If
+				set, entries without an assignment or with more
+				than capacity items count as misses.
+	@param capacity		Number of entries of the array
+
+	@return true on a hit.
+*/
+
+bool result_cache::lookup(const uint64_t key[2], unsigned int heuristic, cache_entry_header& entry, unsigned int* bins, size_t capacity)
+{
+	entry_key k;
+	k.hash[0]   = key[0];
+	k.hash[1]   = key[1];
+	k.heuristic = heuristic;
+
+	std::string blob;
+	bool from_disk = false;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		auto it = index.find(k);
+		if(it != index.end())
+		{
+			// Move to the front of the list; the iterator stays valid
+			lru.splice(lru.begin(), lru, it->second);
+			blob = it->second->second;
+		}
+	}
+
+	if(blob.empty())
+	{
+		from_disk = load(k, blob);
+		if(!from_disk)
+			blob.clear();
+	}
+
+	bool hit = !blob.empty();
+	if(hit)
+	{
+		memcpy(&entry, blob.data(), sizeof(entry));
+		if(bins != NULL)
+		{
+			size_t position	  = sizeof(entry);
+			unsigned int previous = 0;
+
+			hit = 	entry.has_assignment && entry.n <= capacity &&
+				decode_bins(	reinterpret_cast<const unsigned char*>(blob.data()), blob.size(),
+						position, bins, entry.n, previous);
+		}
+	}
+
+	if(from_disk)
+		remember(k, blob);
+
+	std::lock_guard<std::mutex> guard(lock);
+	if(hit)
+	{
+		num_hits++;
+		num_disk_hits += from_disk;
+	}
+	else
+		num_misses++;
+
+	return(hit);
+}
+
+/*!
+	Stores a result. Existing entries are replaced.
+
+	@param entry	Result; the key and heuristic identify the entry
+	@param bins	Optional assignment of entry.n items
+
+	@return false if the entry could not be written to disk.
+*/
+
+bool result_cache::store(const cache_entry_header& entry, const unsigned int* bins)
+{
+	entry_key k;
+	k.hash[0]   = entry.key[0];
+	k.hash[1]   = entry.key[1];
+	k.heuristic = entry.heuristic;
+
+	cache_entry_header header = entry;
+	header.magic		= cache_entry_magic;
+	header.has_assignment	= (bins != NULL);
+
+	std::string blob;
+	blob.resize(sizeof(header) + (bins != NULL ? static_cast<size_t>(header.n)*max_varint_bytes : 0));
+	memcpy(&blob[0], &header, sizeof(header));
+
+	if(bins != NULL)
+	{
+		unsigned int previous = 0;
+		size_t length = encode_bins(bins, header.n, previous, reinterpret_cast<unsigned char*>(&blob[sizeof(header)]));
+
+		blob.resize(sizeof(header)+length);
+		blob.shrink_to_fit();
+	}
+
+	bool success = directory.empty() || save(k, blob);
+	remember(k, blob);
+
+	std::lock_guard<std::mutex> guard(lock);
+	num_stores++;
+
+	return(success);
+}
+
+/*!
+	@return Name of the file of an entry.
+*/
+
+std::string result_cache::file_name(const entry_key& k) const
+{
+	char name[64];
+	snprintf(	name, sizeof(name), "/%016llx%016llx-%u.bpr",
+			static_cast<unsigned long long>(k.hash[0]),
+			static_cast<unsigned long long>(k.hash[1]),
+			k.heuristic);
+
+	return(directory + name);
+}
+
+/*!
+	Reads an entry from disk and checks that its header matches the key.
+*/
+
+bool result_cache::load(const entry_key& k, std::string& blob) const
+{
+	if(directory.empty())
+		return(false);
+
+	int fd = ::open(file_name(k).c_str(), O_RDONLY);
+	if(fd < 0)
+		return(false);
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(cache_entry_header))
+	{
+		::close(fd);
+		return(false);
+	}
+
+	blob.resize(info.st_size);
+
+	size_t offset = 0;
+	while(offset < blob.size())
+	{
+		ssize_t r = ::read(fd, &blob[offset], blob.size()-offset);
+		if(r < 0 && errno == EINTR)
+			continue;
+		if(r <= 0)
+			break;
+
+		offset += r;
+	}
+
+	::close(fd);
+
+	cache_entry_header header;
+	memcpy(&header, blob.data(), sizeof(header));
+
+	return(	offset == blob.size() &&
+		header.magic == cache_entry_magic &&
+		header.key[0] == k.hash[0] && header.key[1] == k.hash[1] &&
+		header.heuristic == k.heuristic);
+}
+
+/*!
+	Writes an entry to disk under a temporary name and renames it.
+*/
+
+bool result_cache::save(const entry_key& k, const std::string& blob)
+{
+	std::string path = file_name(k);
+	std::string temporary;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		temporary = path + "." + std::to_string(getpid()) + "." + std::to_string(num_temporary++);
+	}
+
+	int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+		return(false);
+
+	size_t offset = 0;
+	while(offset < blob.size())
+	{
+		ssize_t w = ::write(fd, blob.data()+offset, blob.size()-offset);
+		if(w < 0 && errno == EINTR)
+			continue;
+		if(w <= 0)
+			break;
+
+		offset += w;
+	}
+
+	bool success = (::close(fd) == 0) && offset == blob.size();
+	success = success && rename(temporary.c_str(), path.c_str()) == 0;
+
+	if(!success)
+		unlink(temporary.c_str());
+
+	return(success);
+}
+
+/*!
+	Keeps an entry in memory, evicting the least recently used entries
+	until the memory limit is met.
+*/
+
+void result_cache::remember(const entry_key& k, const std::string& blob)
+{
+	size_t size = blob.size()+entry_overhead;
+	if(size > memory_limit)
+		return;
+
+	std::lock_guard<std::mutex> guard(lock);
+
+	auto it = index.find(k);
+	if(it != index.end())
+	{
+		memory_used -= it->second->second.size()+entry_overhead;
+		lru.erase(it->second);
+		index.erase(it);
+	}
+
+	while(!lru.empty() && memory_used+size > memory_limit)
+	{
+		memory_used -= lru.back().second.size()+entry_overhead;
+		index.erase(lru.back().first);
+		lru.pop_back();
+	}
+
+	lru.emplace_front(k, blob);
+	index[k] = lru.begin();
+	memory_used += size;
+}
+
+unsigned long result_cache::hits() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return(num_hits);
+}
+
+unsigned long result_cache::disk_hits() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return(num_disk_hits);
+}
+
+unsigned long result_cache::misses() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return(num_misses);
+}
+
+unsigned long result_cache::stores() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return(num_stores);
+}
+
+unsigned long result_cache::entries() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return(index.size());
+}
+
+size_t result_cache::bytes() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return(memory_used);
+}
@@ -0,0 +1,124 @@
+/*!
+	@file	result-cache.h
+	@brief	Content-addressed cache of packing results
+
+	Results are addressed by a 128 bit hash of the instance and the
+	heuristic that has been run on it. The cache consists of an in-memory
+	level with least-recently-used eviction and an optional directory on
+	disk, so repeated instances are answered without packing them again,
+	within a process as well as across processes.
+
+	Every entry stores the properties of the instance, the number of bins
+	and, optionally, the assignment in the varint encoding of assignment
+	files. An entry is kept as a single blob that is written to disk
+	unchanged. Files are written under a temporary name and renamed, so
+	concurrent readers never see a partial entry.
+
+	@author Bastian Rieck
+*/
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstddef>
+#include <stdint.h>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+static const uint32_t cache_entry_magic = 0x43525042;	///< "BPRC"
+
+void hash_bytes(const void* data, size_t size, uint64_t seed, uint64_t hash[2]);
+
+/*!
+	Header of a cached result, followed by the encoded assignment if
+	has_assignment is set.
+*/
+
+struct cache_entry_header
+{
+	uint32_t magic;
+	uint32_t heuristic;
+	uint64_t key[2];
+
+	uint32_t n;
+	uint32_t K;
+	uint32_t min_size;
+	uint32_t max_size;
+	uint64_t sum_size;
+
+	uint32_t num_bins;
+	uint32_t has_assignment;
+	double time;			///< Time that packing originally took
+};
+
+/*!
+	Cache of results. All member functions may be called concurrently.
+*/
+
+class result_cache
+{
+	public:
+		result_cache(const char* directory, size_t memory_limit);
+
+		bool lookup(const uint64_t key[2], unsigned int heuristic, cache_entry_header& entry, unsigned int* bins, size_t capacity);
+		bool store(const cache_entry_header& entry, const unsigned int* bins);
+
+		unsigned long hits() const;
+		unsigned long disk_hits() const;
+		unsigned long misses() const;
+		unsigned long stores() const;
+		unsigned long entries() const;
+		size_t bytes() const;
+
+	private:
+		/*!
+			Identifies an entry: the hash of the instance and the
+			heuristic.
+		*/
+
+		struct entry_key
+		{
+			uint64_t hash[2];
+			unsigned int heuristic;
+
+			bool operator==(const entry_key& other) const
+			{
+				return(	hash[0] == other.hash[0] && hash[1] == other.hash[1] &&
+					heuristic == other.heuristic);
+			}
+		};
+
+		struct entry_key_hash
+		{
+			size_t operator()(const entry_key& k) const
+			{
+				return(static_cast<size_t>(k.hash[0] ^ (k.hash[1] >> 7) ^ k.heuristic));
+			}
+		};
+
+		typedef std::list<std::pair<entry_key, std::string> > lru_list;
+
+		std::string file_name(const entry_key& k) const;
+		bool load(const entry_key& k, std::string& blob) const;
+		bool save(const entry_key& k, const std::string& blob);
+		void remember(const entry_key& k, const std::string& blob);
+
+		std::string directory;		///< Empty if entries are only kept in memory
+		size_t memory_limit;
+
+		mutable std::mutex lock;
+		lru_list lru;			///< Most recently used entry first
+		std::unordered_map<entry_key, lru_list::iterator, entry_key_hash> index;
+		size_t memory_used;
+
+		unsigned long num_hits;
+		unsigned long num_disk_hits;
+		unsigned long num_misses;
+		unsigned long num_stores;
+		unsigned long num_temporary;	///< Counter for names of temporary files
+};
+
+#endif
@@ -0,0 +1,57 @@
+/*!
+	@file	run-control.cpp
+	@brief	Cancellation, deadlines and progress reports for heuristics
+
+	@author Bastian Rieck
+*/
+
+#include "run-control.h"
+
+/*!
+	Creates a run control without any limits or callbacks.
+*/
+
+run_control::run_control()
+	: cancelled(NULL), has_deadline(false), progress(NULL), data(NULL), reason(STOP_NONE), placed(0)
+{
+}
+
+/*!
+	Prepares the run control for a new run. Unless the heuristic stops
+	early, all objects count as placed.
+
+	@param n Number of objects
+*/
+
+void run_control::start(unsigned int n)
+{
+	reason = STOP_NONE;
+	placed = n;
+}
+
+/*!
+	Reports the progress of a heuristic and checks whether it has to stop.
+
+	@param i	Number of objects placed so far
+	@param num_bins	Number of bins opened so far
+
+	@return true if the heuristic has to stop; the reason and the number
+	of placed objects are stored.
+*/
+
+bool run_control::check(unsigned int i, unsigned int num_bins)
+{
+	// Some heuristics start with an empty bin
+	if(progress != NULL)
+		progress(i, i > 0 ? num_bins : 0, data);
+
+	if(cancelled != NULL && cancelled->load(std::memory_order_relaxed))
+		reason = STOP_CANCELLED;
+	else if(has_deadline && std::chrono::steady_clock::now() >= deadline)
+		reason = STOP_DEADLINE;
+	else
+		return(false);
+
+	placed = i;
+	return(true);
+}
@@ -0,0 +1,78 @@
+/*!
+	@file	run-control.h
+	@brief	Cancellation, deadlines and progress reports for heuristics
+
+	Heuristics that may run for a long time check every check_interval
+	objects whether they should stop early. The check costs a single
+	comparison unless a run control has been set for the problem. A
+	heuristic that stops returns the bins it has opened so far; the
+	objects from run_control::placed onwards have not been assigned.
+
+	@author Bastian Rieck
+*/
+
+#ifndef RUN_CONTROL_H
+#define RUN_CONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include "bin-packing.h"
+
+/*!
+	Number of objects between two checks; has to be a power of 2.
+*/
+
+static const unsigned int check_interval = 4096;
+
+/*!
+	Reason why a heuristic has stopped.
+*/
+
+enum stop_reason
+{
+	STOP_NONE,		///< All objects have been placed
+	STOP_CANCELLED,		///< The cancellation token has been set
+	STOP_DEADLINE		///< The deadline has passed
+};
+
+/*!
+	Limits and callbacks of a single heuristic run.
+*/
+
+struct run_control
+{
+	run_control();
+
+	void start(unsigned int n);
+	bool check(unsigned int placed, unsigned int num_bins);
+
+	const std::atomic<bool>* cancelled;	///< Cancellation token, or NULL
+	bool has_deadline;			///< Whether the deadline applies
+	std::chrono::steady_clock::time_point deadline;
+
+	void (*progress)(unsigned int placed, unsigned int num_bins, void* data);
+	void* data;				///< Passed to the progress callback
+
+	stop_reason reason;			///< Why the heuristic has stopped
+	unsigned int placed;			///< Objects placed when it stopped
+};
+
+/*!
+	Checks whether a heuristic has to stop before placing object i. The
+	run control is consulted only for every check_interval-th object.
+
+	@param p	Problem
+	@param i	Index of the next object
+	@param num_bins	Number of bins opened so far
+
+	@return true if the heuristic has to stop.
+*/
+
+inline bool stop_requested(const problem& p, unsigned int i, unsigned int num_bins)
+{
+	return((i & (check_interval-1)) == 0 && p.control != NULL && p.control->check(i, num_bins));
+}
+
+#endif
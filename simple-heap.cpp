@@ -6,41 +6,37 @@
 */
 
 #include "simple-heap.h"
+#include "workspace.h"
 
 /*!
 	Initializes the heap.
 
-	@param max_size Allocates memory for max_size elements.
+	@param ws	Workspace that provides the memory of the heap
+	@param max_size Reserves memory for max_size elements.
+	@param with_ids	Whether an id is stored for every element
 */
 
-simple_heap::simple_heap(unsigned int max_size)
+simple_heap::simple_heap(workspace& ws, unsigned int max_size, bool with_ids)
 {
-	elements = new unsigned int[max_size+2];
+	elements = ws.borrow_zeroed<unsigned int>(WS_HEAP, max_size+2);
+	ids	 = with_ids ? ws.borrow<unsigned int>(WS_NEXT, max_size+2) : NULL;
 	last = 0;
-
-	for(unsigned int i = 0; i < (max_size+2); i++)
-		elements[i] = 0;
-}
-
-/*!
-	Releases memory.
-*/
-
-simple_heap::~simple_heap()
-{
-	delete[] elements;
 }
 
 
 /*!
 	Adds a new element to the heap and performs the reheap operation. 
 
-	@param x Element to add to the heap.
+	@param x	Element to add to the heap.
+	@param id	Id of the element; ignored if the heap has no ids.
 */
 
-void simple_heap::push(unsigned int x)
+void simple_heap::push(unsigned int x, unsigned int id)
 {
 	elements[++last] = x;
+	if(ids != NULL)
+		ids[last] = id;
+
 	reheap_up(last);
 }
 
@@ -63,6 +59,13 @@ void simple_heap::reheap_up(unsigned int start)
 		unsigned int tmp = elements[father];
 		elements[father] = elements[child];
 		elements[child] = tmp;
+
+		if(ids != NULL)
+		{
+			tmp = ids[father];
+			ids[father] = ids[child];
+			ids[child] = tmp;
+		}
 		
 		child /= 2;
 		father /= 2;
@@ -95,6 +98,13 @@ void simple_heap::reheap_down(unsigned int start)
 		unsigned int tmp = elements[start];
 		elements[start] = elements[child];
 		elements[child] = tmp;
+
+		if(ids != NULL)
+		{
+			tmp = ids[start];
+			ids[start] = ids[child];
+			ids[child] = tmp;
+		}
 		
 		reheap_down(child);
 	}
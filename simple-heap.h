@@ -8,19 +8,22 @@
 #ifndef SIMPLE_HEAP_H
 #define SIMPLE_HEAP_H
 
+class workspace;
+
 /*!
 	Describes a heap based on unsigned integers. Only the most basic
-	operations have been implemented.
+	operations have been implemented. Optionally, an id is stored for
+	every element and moved along with it.
 */
 
 class simple_heap {
 	public:
-		simple_heap(unsigned int max_size);
-		~simple_heap();
+		simple_heap(workspace& ws, unsigned int max_size, bool with_ids = false);
 
-		void push(unsigned int item);
+		void push(unsigned int item, unsigned int id = 0);
 		
 		unsigned int* elements;
+		unsigned int* ids;	///< NULL unless ids were requested
 		unsigned int last;
 
 		void reheap_up(unsigned int start);
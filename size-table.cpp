@@ -0,0 +1,74 @@
+/*!
+	@file	size-table.cpp
+	@brief	Implemented functions for the size table class.
+
+	@author Bastian Rieck
+*/
+
+#include <new>
+
+#include <cstring>
+
+#include "size-table.h"
+#include "workspace.h"
+
+/*!
+	Largest size for which a flat array is used.
+*/
+
+static const unsigned int max_flat_size = 1 << 22;
+
+/*!
+	Largest number of slots of the hash table.
+*/
+
+static const unsigned long long max_capacity = 1ull << 31;
+
+/*!
+	Initializes the table.
+
+	@param ws		Workspace that provides the memory of the table
+	@param max_size		Largest size that will be looked up
+	@param max_entries	Largest number of different sizes that will be
+				looked up
+
+	Since the memory of the table is borrowed from the workspace, only one
+	table may be in use per workspace. If the hash table cannot hold
+	max_entries sizes, std::bad_alloc is thrown.
+*/
+
+size_table::size_table(workspace& ws, unsigned int max_size, unsigned int max_entries)
+{
+	unsigned int capacity;
+
+	if(max_size < max_flat_size)
+	{
+		capacity = max_size+1;
+		keys = 0;
+		mask = 0;
+	}
+	else
+	{
+		// Keep the load factor of the hash table below 1/2. The size
+		// is computed in 64 bits; linear probing needs at least one
+		// empty slot, so a table that cannot have one is not created.
+		unsigned long long slots = 2;
+		while(slots < 2ull*max_entries && slots < max_capacity)
+			slots *= 2;
+
+		if(max_entries >= slots)
+			throw std::bad_alloc();
+
+		capacity = static_cast<unsigned int>(slots);
+
+		keys = ws.borrow<unsigned int>(WS_TABLE_KEYS, capacity);
+		mask = capacity-1;
+
+		memset(keys, 0xFF, capacity*sizeof(unsigned int));
+
+		// The size that marks empty slots has a slot of its own
+		capacity++;
+	}
+
+	values = ws.borrow_zeroed<unsigned int>(WS_TABLE_VALUES, capacity);
+}
@@ -0,0 +1,64 @@
+/*!
+	@file	size-table.h
+	@brief	Table that associates object sizes with unsigned integers
+
+	@author Bastian Rieck
+*/
+
+#ifndef SIZE_TABLE_H
+#define SIZE_TABLE_H
+
+class workspace;
+
+/*!
+	Maps object sizes to unsigned integers, which are initialized with 0.
+	Since object sizes are bounded by K, the table is usually a flat array
+	that is indexed by size. For very large K, an open-addressing hash
+	table with linear probing is used instead. In contrast to std::map,
+	lookups require neither pointer chasing nor allocations.
+*/
+
+class size_table {
+	public:
+		size_table(workspace& ws, unsigned int max_size, unsigned int max_entries);
+
+		inline unsigned int& operator[](unsigned int size);
+
+	private:
+		unsigned int* values;
+		unsigned int* keys;	///< Only used for hashing; NULL otherwise
+		unsigned int mask;
+
+		static const unsigned int empty = 0xFFFFFFFF;
+};
+
+/*!
+	Returns a reference to the value that is associated with the given
+	size. If the size has not been seen before, an entry with value 0 is
+	created.
+*/
+
+unsigned int& size_table::operator[](unsigned int size)
+{
+	if(keys == 0)
+		return(values[size]);
+
+	if(size == empty)
+		return(values[mask+1]);
+
+	unsigned int i = (size*2654435761u) & mask;
+	while(keys[i] != size)
+	{
+		if(keys[i] == empty)
+		{
+			keys[i] = size;
+			break;
+		}
+
+		i = (i+1) & mask;
+	}
+
+	return(values[i]);
+}
+
+#endif
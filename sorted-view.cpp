@@ -0,0 +1,303 @@
+/*!
+	@file	sorted-view.cpp
+	@brief	Shared, sorted view of a problem
+
+	All "Decreasing" heuristics require the objects in decreasing order of
+	their sizes. Instead of letting every heuristic copy and sort the
+	objects on its own, the sorted order is computed once, on first use,
+	and shared afterwards. The time required for sorting is recorded
+	separately, so that it can be reported once instead of being added to
+	the time of every heuristic.
+
+	@author Bastian Rieck
+*/
+
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <functional>
+
+#include "sorted-view.h"
+#include "workspace.h"
+#include "trace.h"
+
+/*!
+	Ensures that an array has at least the requested capacity. The
+	contents are not preserved.
+*/
+
+static void reserve(unsigned int*& array, size_t& capacity, size_t count)
+{
+	if(capacity >= count && array != NULL)
+		return;
+
+	trace_span span("allocate", "allocation");
+
+	delete[] array;
+	array = new unsigned int[count > 0 ? count : 1];
+	capacity = count;
+}
+
+/*!
+	Initializes an empty view.
+*/
+
+sorted_view::sorted_view()
+{
+	source = NULL;
+	sorted = NULL;
+	counts = NULL;
+	permutation = NULL;
+
+	sorted_capacity = 0;
+	counts_capacity = 0;
+	permutation_capacity = 0;
+
+	has_counts = false;
+	has_permutation = false;
+	time_sorting = 0.0;
+}
+
+/*!
+	Releases memory.
+*/
+
+sorted_view::~sorted_view()
+{
+	delete[] sorted;
+	delete[] counts;
+	delete[] permutation;
+}
+
+/*!
+	Computes the sorted view of the objects. Counting sort is used
+	whenever the range of object sizes permits it. The counts are kept
+	afterwards as the size histogram of the problem.
+
+	@param p Problem whose objects are to be sorted
+*/
+
+void sorted_view::compute(const problem& p)
+{
+	trace_span span("sort", "sort");
+	clock_t start = clock();
+
+	reserve(sorted, sorted_capacity, p.n);
+
+	// The range is checked before adding 1, which would overflow if the
+	// sizes span all 32 bits
+	has_counts = (p.n > 0 && p.max_size - p.min_size < max_histogram_range);
+	has_permutation = false;
+
+	if(has_counts)
+	{
+		unsigned int range = p.max_size - p.min_size + 1;
+		reserve(counts, counts_capacity, range);
+
+		memset(counts, 0, range*sizeof(unsigned int));
+		for(unsigned int i = 0; i < p.n; i++)
+			counts[p.objects[i] - p.min_size]++;
+
+		expand(p);
+	}
+
+	// The sizes are too spread out for a histogram
+	else
+	{
+		memcpy(sorted, p.objects, p.n*sizeof(unsigned int));
+		std::sort(sorted, sorted+p.n, std::greater<unsigned int>());
+	}
+
+	source = p.objects;
+
+	clock_t end = clock();
+	time_sorting = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+}
+
+/*!
+	Writes the sorted objects from the counts.
+*/
+
+void sorted_view::expand(const problem& p)
+{
+	unsigned int z = 0;
+	for(unsigned int i = p.max_size - p.min_size + 1; i-- > 0; )
+	{
+		for(unsigned int j = 0; j < counts[i]; j++)
+			sorted[z++] = p.min_size + i;
+	}
+}
+
+/*!
+	Sets up the view from a histogram that has been counted elsewhere,
+	e.g. while the objects were read. Only the sorted objects need to be
+	written, so the objects themselves are not touched again.
+
+	@param p		Problem whose objects have been counted
+	@param histogram	Array with max_size-min_size+1 entries; entry i
+				contains the number of objects of size min_size+i
+	@param time		Time that counting took
+*/
+
+void sorted_view::assign_histogram(const problem& p, const unsigned int* histogram, double time)
+{
+	trace_span span("expand histogram", "sort");
+	clock_t start = clock();
+
+	unsigned int range = p.max_size - p.min_size + 1;
+
+	reserve(sorted, sorted_capacity, p.n);
+	reserve(counts, counts_capacity, range);
+
+	memcpy(counts, histogram, range*sizeof(unsigned int));
+	expand(p);
+
+	source = p.objects;
+	has_counts = true;
+	has_permutation = false;
+
+	clock_t end = clock();
+	time_sorting = time + (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+}
+
+/*!
+	Returns the objects of the problem in decreasing order of their sizes.
+
+	@param p Problem whose objects are to be sorted
+
+	@return Array of n object sizes in decreasing order. The array is
+	owned by the view.
+*/
+
+const unsigned int* sorted_view::objects(const problem& p)
+{
+	// The problem has already been sorted
+	if(p.objects == sorted && sorted != NULL)
+		return(sorted);
+
+	if(source != p.objects)
+		compute(p);
+
+	return(sorted);
+}
+
+/*!
+	Returns the number of objects of each size for the problem.
+
+	@param p Problem whose objects are to be counted
+
+	@return Array with max_size-min_size+1 entries; entry i contains the
+	number of objects of size min_size+i. If the range of sizes is too
+	large, NULL is returned.
+*/
+
+const unsigned int* sorted_view::histogram(const problem& p)
+{
+	if(source != p.objects)
+		compute(p);
+
+	return(has_counts ? counts : NULL);
+}
+
+/*!
+	Returns the permutation that sorts the objects, i.e. the index of the
+	object that ended up at each position of the sorted view. Objects of
+	equal size keep their relative order. The permutation is only computed
+	when it is required, e.g. for reporting the positions of objects. The
+	WS_SIZES slot of the problem's workspace is used as scratch memory.
+
+	@param p Problem whose objects are sorted
+
+	@return Array of n object indices.
+*/
+
+const unsigned int* sorted_view::order(const problem& p)
+{
+	if(source != p.objects)
+		compute(p);
+
+	if(has_permutation)
+		return(permutation);
+
+	trace_span span("order", "sort");
+	reserve(permutation, permutation_capacity, p.n);
+
+	if(has_counts)
+	{
+		// Turn the counts into the first sorted position of every size;
+		// bigger objects come first. The offsets are scratch memory of
+		// the problem's workspace, so repeated calls do not allocate.
+		unsigned int range = p.max_size - p.min_size + 1;
+		unsigned int* offsets = p.ws->borrow<unsigned int>(WS_SIZES, range);
+
+		unsigned int offset = 0;
+		for(unsigned int i = range; i-- > 0; )
+		{
+			offsets[i] = offset;
+			offset += counts[i];
+		}
+
+		for(unsigned int i = 0; i < p.n; i++)
+			permutation[offsets[p.objects[i] - p.min_size]++] = i;
+	}
+	else
+	{
+		for(unsigned int i = 0; i < p.n; i++)
+			permutation[i] = i;
+
+		const unsigned int* objects = p.objects;
+		std::stable_sort(permutation, permutation+p.n, [objects](unsigned int a, unsigned int b)
+		{
+			return(objects[a] > objects[b]);
+		});
+	}
+
+	has_permutation = true;
+	return(permutation);
+}
+
+/*!
+	@return true if the sorted view has been computed.
+*/
+
+bool sorted_view::available() const
+{
+	return(source != NULL);
+}
+
+/*!
+	@return Time that was required for computing the sorted view.
+*/
+
+double sorted_view::time() const
+{
+	return(time_sorting);
+}
+
+/*!
+	Discards the sorted view. This function has to be called whenever
+	the objects of the problem change.
+*/
+
+void sorted_view::reset()
+{
+	source = NULL;
+	has_counts = false;
+	has_permutation = false;
+	time_sorting = 0.0;
+}
+
+/*!
+	Returns a copy of the problem whose objects are taken from the shared
+	sorted view, i.e. they are sorted in decreasing order.
+
+	@param p Problem to sort
+*/
+
+problem decreasing(const problem& p)
+{
+	problem sorted_problem = p;
+	sorted_problem.objects = p.view->objects(p);
+
+	return(sorted_problem);
+}
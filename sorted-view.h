@@ -0,0 +1,63 @@
+/*!
+	@file	sorted-view.h
+	@brief	Shared, sorted view of a problem
+
+	@author Bastian Rieck
+*/
+
+#ifndef SORTED_VIEW_H
+#define SORTED_VIEW_H
+
+#include <cstddef>
+
+#include "bin-packing.h"
+
+/*!
+	Largest range of sizes for which counting sort is used.
+*/
+
+static const unsigned int max_histogram_range = 1 << 24;
+
+/*!
+	Keeps the objects of a problem in decreasing order of their sizes,
+	together with the size histogram and the permutation that sorts the
+	objects. Everything is computed on first use and reused until the
+	view is reset.
+*/
+
+class sorted_view {
+	public:
+		sorted_view();
+		~sorted_view();
+
+		const unsigned int* objects(const problem& p);
+		const unsigned int* histogram(const problem& p);
+		const unsigned int* order(const problem& p);
+
+		void assign_histogram(const problem& p, const unsigned int* histogram, double time);
+
+		bool available() const;
+		double time() const;
+		void reset();
+
+	private:
+		void compute(const problem& p);
+		void expand(const problem& p);
+
+		const unsigned int* source;	///< Objects the view has been computed for
+		unsigned int* sorted;		///< Objects in decreasing order
+		unsigned int* counts;		///< Number of objects per size, starting at min_size
+		unsigned int* permutation;	///< Index of the object at each sorted position
+
+		size_t sorted_capacity;
+		size_t counts_capacity;
+		size_t permutation_capacity;
+
+		bool has_counts;
+		bool has_permutation;
+		double time_sorting;
+};
+
+problem decreasing(const problem& p);
+
+#endif
@@ -0,0 +1,249 @@
+/*!
+	@file	trace.cpp
+	@brief	Timeline of the phases of a run, in the Chrome trace format
+
+	Spans are appended to a single list under a lock. Since they only
+	cover whole phases, there are few of them, and the lock is never
+	contended noticeably. Threads are numbered from 1 in the order in
+	which they record their first span; the number of a thread that has
+	exited is reused, so that the short-lived threads of the parallel
+	heuristics do not add a new row to the timeline for every run.
+
+	@author Bastian Rieck
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "trace.h"
+
+std::atomic<bool> trace_enabled(false);
+
+/*!
+	Span that has ended.
+*/
+
+struct trace_event
+{
+	const char* name;
+	const char* category;
+	long long start;	///< Nanoseconds since the start of the process
+	long long duration;	///< Nanoseconds
+	unsigned int thread;	///< Number of the thread
+};
+
+static std::mutex trace_lock;
+static std::vector<trace_event> events;
+static unsigned long dropped = 0;
+
+static std::vector<std::string> thread_names;	///< Indexed by the number of the thread
+static std::vector<unsigned int> free_threads;	///< Numbers of threads that have exited
+
+static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+/*!
+	Number of the calling thread in the timeline. It is assigned when the
+	thread records its first span and released when the thread exits.
+*/
+
+struct trace_thread
+{
+	trace_thread() : number(0)
+	{
+	}
+
+	~trace_thread()
+	{
+		if(number == 0)
+			return;
+
+		std::lock_guard<std::mutex> guard(trace_lock);
+		free_threads.push_back(number);
+	}
+
+	unsigned int number;
+};
+
+static thread_local trace_thread current_thread;
+
+/*!
+	@return Number of the calling thread; trace_lock has to be held.
+*/
+
+static unsigned int thread_number()
+{
+	if(current_thread.number != 0)
+		return(current_thread.number);
+
+	if(!free_threads.empty())
+	{
+		// Prefer small numbers, so that the rows stay in order
+		std::vector<unsigned int>::iterator smallest = std::min_element(free_threads.begin(), free_threads.end());
+		current_thread.number = *smallest;
+		free_threads.erase(smallest);
+	}
+	else
+	{
+		thread_names.resize(thread_names.size()+1);
+		current_thread.number = static_cast<unsigned int>(thread_names.size());
+	}
+
+	return(current_thread.number);
+}
+
+/*!
+	Starts or stops recording spans. Spans that have been recorded before
+	are kept.
+*/
+
+void trace_enable(bool enabled)
+{
+	trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/*!
+	Discards all spans that have been recorded so far.
+*/
+
+void trace_clear()
+{
+	std::lock_guard<std::mutex> guard(trace_lock);
+
+	events.clear();
+	dropped = 0;
+}
+
+/*!
+	@return Nanoseconds since the start of the process.
+*/
+
+long long trace_now()
+{
+	return(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-epoch).count());
+}
+
+/*!
+	Records a span that ends now.
+
+	@param name	Name of the span
+	@param category	Phase of the span
+	@param start	Start of the span, as returned by trace_now()
+*/
+
+void trace_record(const char* name, const char* category, long long start)
+{
+	long long end = trace_now();
+
+	std::lock_guard<std::mutex> guard(trace_lock);
+	if(events.size() >= max_trace_events)
+	{
+		dropped++;
+		return;
+	}
+
+	trace_event event = { name, category, start, end-start, thread_number() };
+	events.push_back(event);
+}
+
+/*!
+	Names the row of the calling thread in the timeline. Threads that
+	reuse the number of an exited thread inherit its name unless they
+	set their own.
+*/
+
+void trace_thread_name(const char* name)
+{
+	std::lock_guard<std::mutex> guard(trace_lock);
+	thread_names[thread_number()-1] = name;
+}
+
+/*!
+	Writes a string as a JSON string literal.
+*/
+
+static void write_string(FILE* out, const char* s)
+{
+	fputc('"', out);
+	for(; *s != '\0'; s++)
+	{
+		unsigned char c = static_cast<unsigned char>(*s);
+		if(c == '"' || c == '\\')
+			fprintf(out, "\\%c", c);
+		else if(c < 0x20)
+			fprintf(out, "\\u%04x", c);
+		else
+			fputc(c, out);
+	}
+	fputc('"', out);
+}
+
+/*!
+	Writes all spans recorded so far to a file in the JSON format of
+	Chrome traces, which chrome://tracing and Perfetto display as a
+	timeline. Times are given in microseconds.
+
+	@param path Path of the file
+
+	@return false if the file could not be written.
+*/
+
+bool trace_write(const char* path)
+{
+	std::vector<trace_event> snapshot;
+	std::vector<std::string> names;
+	unsigned long num_dropped;
+	{
+		std::lock_guard<std::mutex> guard(trace_lock);
+
+		snapshot    = events;
+		names	    = thread_names;
+		num_dropped = dropped;
+	}
+
+	FILE* out = fopen(path, "w");
+	if(out == NULL)
+		return(false);
+
+	const int pid = static_cast<int>(getpid());
+	const char* separator = "\n";
+
+	fprintf(out, "{\"traceEvents\":[");
+	for(size_t i = 0; i < names.size(); i++)
+	{
+		if(names[i].empty())
+			continue;
+
+		fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%zu,\"args\":{\"name\":", separator, pid, i+1);
+		write_string(out, names[i].c_str());
+		fprintf(out, "}}");
+
+		separator = ",\n";
+	}
+
+	for(size_t i = 0; i < snapshot.size(); i++)
+	{
+		const trace_event& e = snapshot[i];
+
+		fprintf(out, "%s{\"name\":", separator);
+		write_string(out, e.name);
+		fprintf(out, ",\"cat\":");
+		write_string(out, e.category);
+		fprintf(out,	",\"ph\":\"X\",\"ts\":%lld.%03lld,\"dur\":%lld.%03lld,\"pid\":%d,\"tid\":%u}",
+				e.start/1000, e.start%1000, e.duration/1000, e.duration%1000, pid, e.thread);
+
+		separator = ",\n";
+	}
+
+	fprintf(out, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_spans\":%lu}}\n", num_dropped);
+
+	bool success = !ferror(out);
+	success = (fclose(out) == 0) && success;
+
+	return(success);
+}
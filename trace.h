@@ -0,0 +1,93 @@
+/*!
+	@file	trace.h
+	@brief	Timeline of the phases of a run, in the Chrome trace format
+
+	Spans mark the phases of a run: loading and parsing the instance,
+	sorting, allocating and zeroing scratch memory, packing, and writing
+	the output. Every span records its thread, so the timeline shows the
+	threads of the parallel heuristics and of the server side by side.
+	The timeline belongs to the process, since spans of different
+	contexts and threads belong to the same picture.
+
+	Spans only cover whole phases, never single objects. While tracing
+	is disabled, a span costs a single relaxed load and a branch.
+
+	@author Bastian Rieck
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+
+/*!
+	Largest number of spans that are kept; later spans are dropped and
+	counted, so that tracing a long-running server cannot exhaust memory.
+*/
+
+static const unsigned long max_trace_events = 1ul << 20;
+
+extern std::atomic<bool> trace_enabled;
+
+void trace_enable(bool enabled);
+void trace_clear();
+bool trace_write(const char* path);
+
+long long trace_now();
+void trace_record(const char* name, const char* category, long long start);
+void trace_thread_name(const char* name);
+
+/*!
+	Starts a span whose end is recorded explicitly by trace_end(). This
+	suits phases that are already delimited by the timing of a heuristic.
+
+	@return Start of the span, or -1 if tracing is disabled.
+*/
+
+inline long long trace_begin()
+{
+	return(trace_enabled.load(std::memory_order_relaxed) ? trace_now() : -1);
+}
+
+/*!
+	Ends a span that has been started by trace_begin(). The strings have
+	to stay valid until the trace has been written; string literals and
+	names of heuristics do.
+
+	@param name	Name of the span
+	@param category	Phase of the span, e.g. "sort" or "pack"
+	@param start	Result of trace_begin()
+*/
+
+inline void trace_end(const char* name, const char* category, long long start)
+{
+	if(start >= 0)
+		trace_record(name, category, start);
+}
+
+/*!
+	Span that lasts for the scope it is declared in.
+*/
+
+class trace_span {
+	public:
+		trace_span(const char* name, const char* category)
+			: name(name), category(category), start(trace_begin())
+		{
+		}
+
+		~trace_span()
+		{
+			trace_end(name, category, start);
+		}
+
+	private:
+		trace_span(const trace_span&);
+		trace_span& operator=(const trace_span&);
+
+		const char* name;
+		const char* category;
+		long long start;
+};
+
+#endif
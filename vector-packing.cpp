@@ -0,0 +1,308 @@
+/*!
+	@file	vector-packing.cpp
+	@brief	Heuristics for d-dimensional (vector) bin packing
+
+	@author Bastian Rieck
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include <ctime>
+
+#include "vector-packing.h"
+#include "bin-scan.h"
+#include "workspace.h"
+#include "trace.h"
+
+/*!
+	Chooses the first bin that can take an item.
+*/
+
+struct first_fit_choice
+{
+	first_fit_choice(const vector_problem&)
+	{
+	}
+
+	unsigned int operator()(const unsigned int* residual, unsigned int stride, unsigned int d, const unsigned int* item, unsigned int num_bins) const
+	{
+		return(scan_first_fit(residual, stride, d, item, 0, num_bins));
+	}
+};
+
+/*!
+	Chooses the bin with the best score among all bins that can take an
+	item; ties are broken in favour of the bin with smallest index. All
+	dimensions are normalized by their capacity, so that no resource
+	dominates the score because of its unit.
+
+	- dot:	maximize the dot product of the item and the load of the bin,
+		i.e. prefer bins that are already heavy where the item is
+	- L2:	minimize the squared length of the residual capacity that is
+		left after adding the item, i.e. prefer the tightest bin
+*/
+
+template<bool dot> struct best_fit_choice
+{
+	best_fit_choice(const vector_problem& p)
+		: K(p.K), weights(p.d)
+	{
+		for(unsigned int k = 0; k < p.d; k++)
+			weights[k] = 1.0/(static_cast<double>(p.K[k])*p.K[k]);
+	}
+
+	unsigned int operator()(const unsigned int* residual, unsigned int stride, unsigned int d, const unsigned int* item, unsigned int num_bins) const
+	{
+		unsigned int best_bin = num_bins;
+		double best_score = 0.0;
+
+		for(unsigned int j = scan_first_fit(residual, stride, d, item, 0, num_bins); j < num_bins;
+		    j = scan_first_fit(residual, stride, d, item, j+1, num_bins))
+		{
+			// Both scores are minimized
+			double score = 0.0;
+			for(unsigned int k = 0; k < d; k++)
+			{
+				double r = residual[k*static_cast<size_t>(stride)+j];
+				if(dot)
+					score -= weights[k]*item[k]*(K[k]-r);
+				else
+					score += weights[k]*(r-item[k])*(r-item[k]);
+			}
+
+			if(best_bin == num_bins || score < best_score)
+			{
+				best_bin   = j;
+				best_score = score;
+			}
+		}
+
+		return(best_bin);
+	}
+
+	const unsigned int* K;
+	std::vector<double> weights;
+};
+
+/*!
+	Packs all objects in a given order; every object goes to the bin
+	chosen by the policy, or to a new bin. The residual capacities of the
+	bins are stored with a stride of n, so there is room for one bin per
+	object.
+
+	@param p		Problem
+	@param order		Order of the objects, or NULL for their original
+				order
+	@param positions	Will contain the bin of every object
+*/
+
+template<typename choice> static unsigned int vector_pack(const vector_problem& p, const unsigned int* order, unsigned int* positions)
+{
+	const unsigned int* objects = p.objects;
+	const unsigned int n = p.n;
+	const unsigned int d = p.d;
+	const unsigned int* K = p.K;
+
+	unsigned int* residual = p.ws->borrow<unsigned int>(WS_BINS, static_cast<size_t>(d)*n);
+	unsigned int* item = p.ws->borrow<unsigned int>(WS_SIZES, d);
+
+	choice choose(p);
+	unsigned int num_bins = 0;
+
+	for(unsigned int t = 0; t < n; t++)
+	{
+		unsigned int i = order != NULL ? order[t] : t;
+		for(unsigned int k = 0; k < d; k++)
+			item[k] = objects[k*static_cast<size_t>(n)+i];
+
+		unsigned int j = choose(residual, n, d, item, num_bins);
+		if(j < num_bins)
+		{
+			for(unsigned int k = 0; k < d; k++)
+				residual[k*static_cast<size_t>(n)+j] -= item[k];
+		}
+		else
+		{
+			for(unsigned int k = 0; k < d; k++)
+				residual[k*static_cast<size_t>(n)+j] = K[k]-item[k];
+
+			num_bins++;
+		}
+
+		positions[i] = j;
+	}
+
+	return(num_bins);
+}
+
+/*!
+	Applies the "First-Fit" heuristic to a vector packing problem. Worst-
+	case running time is O(n^2*d).
+*/
+
+unsigned int vector_first_fit(const vector_problem& p, unsigned int* positions, double& time)
+{
+	clock_t start = clock();
+	long long traced = trace_begin();
+	unsigned int num_bins = vector_pack<first_fit_choice>(p, NULL, positions);
+	clock_t end = clock();
+	trace_end("pack", "pack", traced);
+
+	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+	return(num_bins);
+}
+
+/*!
+	Applies the "First-Fit-Decreasing" heuristic to a vector packing
+	problem. Objects are sorted by the sum of their demands relative to
+	the capacities; ties keep the original order. The time includes
+	sorting.
+*/
+
+unsigned int vector_first_fit_decreasing(const vector_problem& p, unsigned int* positions, double& time)
+{
+	const unsigned int n = p.n;
+
+	clock_t start = clock();
+	long long traced = trace_begin();
+
+	double* keys = p.ws->borrow<double>(WS_TABLE_KEYS, n);
+	unsigned int* order = p.ws->borrow<unsigned int>(WS_NEXT, n);
+
+	for(unsigned int i = 0; i < n; i++)
+	{
+		keys[i]  = 0.0;
+		order[i] = i;
+	}
+
+	for(unsigned int k = 0; k < p.d; k++)
+	{
+		const unsigned int* demands = p.objects+k*static_cast<size_t>(n);
+		double weight = 1.0/p.K[k];
+
+		for(unsigned int i = 0; i < n; i++)
+			keys[i] += weight*demands[i];
+	}
+
+	std::stable_sort(order, order+n, [keys](unsigned int a, unsigned int b) { return(keys[a] > keys[b]); });
+	trace_end("sort", "sort", traced);
+
+	traced = trace_begin();
+	unsigned int num_bins = vector_pack<first_fit_choice>(p, order, positions);
+	clock_t end = clock();
+	trace_end("pack", "pack", traced);
+
+	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+	return(num_bins);
+}
+
+/*!
+	Applies the "Best-Fit" heuristic with dot product scoring to a vector
+	packing problem. Worst-case running time is O(n^2*d).
+*/
+
+unsigned int vector_best_fit_dot(const vector_problem& p, unsigned int* positions, double& time)
+{
+	clock_t start = clock();
+	long long traced = trace_begin();
+	unsigned int num_bins = vector_pack< best_fit_choice<true> >(p, NULL, positions);
+	clock_t end = clock();
+	trace_end("pack", "pack", traced);
+
+	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+	return(num_bins);
+}
+
+/*!
+	Applies the "Best-Fit" heuristic with L2 scoring to a vector packing
+	problem. Worst-case running time is O(n^2*d).
+*/
+
+unsigned int vector_best_fit_l2(const vector_problem& p, unsigned int* positions, double& time)
+{
+	clock_t start = clock();
+	long long traced = trace_begin();
+	unsigned int num_bins = vector_pack< best_fit_choice<false> >(p, NULL, positions);
+	clock_t end = clock();
+	trace_end("pack", "pack", traced);
+
+	time = (end-start)/static_cast<double>(CLOCKS_PER_SEC);
+	return(num_bins);
+}
+
+/*!
+	Checks an assignment of a vector packing problem in O(n*d): every item
+	has to be assigned to one of the bins, no bin may exceed the capacity
+	in any dimension, and no bin may be empty.
+
+	@param p		Problem
+	@param bins		Bin of every item
+	@param num_bins		Number of bins
+	@param item		Will contain the offending item, if any
+	@param bin		Will contain the offending bin, if any
+	@param dimension	Will contain the exceeded dimension, if any
+	@param load		Will contain the load of the offending bin in that
+				dimension, if any
+
+	@return Type of the first violation that has been found. Throws
+	std::bad_alloc if no memory is available for the loads of all bins.
+*/
+
+assignment_violation verify_vector_assignment(	const vector_problem& p, const unsigned int* bins, unsigned int num_bins,
+						size_t& item, unsigned int& bin, unsigned int& dimension, unsigned long long& load)
+{
+	std::vector<bool> used(num_bins, false);
+	for(size_t i = 0; i < p.n; i++)
+	{
+		if(bins[i] >= num_bins)
+		{
+			item	  = i;
+			bin	  = bins[i];
+			dimension = 0;
+			load	  = 0;
+
+			return(VIOLATION_BIN_OUT_OF_RANGE);
+		}
+
+		used[bins[i]] = true;
+	}
+
+	for(unsigned int j = 0; j < num_bins; j++)
+	{
+		if(!used[j])
+		{
+			item	  = p.n;
+			bin	  = j;
+			dimension = 0;
+			load	  = 0;
+
+			return(VIOLATION_EMPTY_BIN);
+		}
+	}
+
+	std::vector<unsigned long long> loads(num_bins);
+	for(unsigned int k = 0; k < p.d; k++)
+	{
+		const unsigned int* demands = p.objects+k*static_cast<size_t>(p.n);
+
+		std::fill(loads.begin(), loads.end(), 0);
+		for(size_t i = 0; i < p.n; i++)
+			loads[bins[i]] += demands[i];
+
+		for(unsigned int j = 0; j < num_bins; j++)
+		{
+			if(loads[j] > p.K[k])
+			{
+				item	  = p.n;
+				bin	  = j;
+				dimension = k;
+				load	  = loads[j];
+
+				return(VIOLATION_OVER_CAPACITY);
+			}
+		}
+	}
+
+	return(VIOLATION_NONE);
+}
@@ -0,0 +1,46 @@
+/*!
+	@file	vector-packing.h
+	@brief	Heuristics for d-dimensional (vector) bin packing
+
+	Items demand a resource in each of d dimensions, e.g. CPU, memory and
+	I/O, and a bin can take an item if its residual capacity suffices in
+	every dimension. Items and bins are stored as structure of arrays:
+	one array per dimension, so that the fit check for a block of bins
+	is a vector compare per dimension.
+
+	@author Bastian Rieck
+*/
+
+#ifndef VECTOR_PACKING_H
+#define VECTOR_PACKING_H
+
+#include <cstddef>
+
+#include "assignment.h"
+
+class workspace;
+
+/*!
+	Describes a vector packing problem. Copying it is cheap; neither the
+	objects nor the capacities are owned by the problem.
+*/
+
+struct vector_problem
+{
+	const unsigned int* objects;	///< Demand k of object i at objects[k*n+i]
+	unsigned int n;			///< Number of objects
+	unsigned int d;			///< Number of dimensions
+	const unsigned int* K;		///< Capacity of bins in every dimension
+
+	workspace* ws;			///< Scratch memory for the heuristics
+};
+
+unsigned int vector_first_fit(const vector_problem&, unsigned int*, double&);
+unsigned int vector_first_fit_decreasing(const vector_problem&, unsigned int*, double&);
+unsigned int vector_best_fit_dot(const vector_problem&, unsigned int*, double&);
+unsigned int vector_best_fit_l2(const vector_problem&, unsigned int*, double&);
+
+assignment_violation verify_vector_assignment(	const vector_problem& p, const unsigned int* bins, unsigned int num_bins,
+						size_t& item, unsigned int& bin, unsigned int& dimension, unsigned long long& load);
+
+#endif
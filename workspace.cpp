@@ -0,0 +1,99 @@
+/*!
+	@file	workspace.cpp
+	@brief	Implemented functions for the workspace class.
+
+	@author Bastian Rieck
+*/
+
+#include <cstdlib>
+#include <new>
+
+#include "workspace.h"
+#include "trace.h"
+
+/*!
+	Initializes an empty workspace.
+*/
+
+workspace::workspace()
+{
+	requests = 0;
+	allocations = 0;
+
+	for(unsigned int i = 0; i < WS_NUM_SLOTS; i++)
+	{
+		buffers[i] = NULL;
+		sizes[i] = 0;
+	}
+}
+
+/*!
+	Releases all buffers.
+*/
+
+workspace::~workspace()
+{
+	for(unsigned int i = 0; i < WS_NUM_SLOTS; i++)
+		free(buffers[i]);
+}
+
+/*!
+	Returns the buffer for a slot, making sure that it has at least the
+	requested size. Buffers are aligned to cache lines, which also suits
+	the vectorized kernels.
+
+	@param slot	Slot of the buffer
+	@param bytes	Minimum size of the buffer
+*/
+
+void* workspace::reserve(workspace_slot slot, size_t bytes)
+{
+	requests++;
+	if(bytes <= sizes[slot] && buffers[slot] != NULL)
+		return(buffers[slot]);
+
+	trace_span span("allocate", "allocation");
+
+	void* buffer = NULL;
+	if(posix_memalign(&buffer, 64, bytes > 0 ? bytes : 1) != 0)
+		throw std::bad_alloc();
+
+	free(buffers[slot]);
+	allocations++;
+
+	buffers[slot] = buffer;
+	sizes[slot] = bytes;
+
+	return(buffer);
+}
+
+/*!
+	@return Number of buffers borrowed from the workspace.
+*/
+
+unsigned long workspace::num_requests() const
+{
+	return(requests);
+}
+
+/*!
+	@return Number of buffers that actually had to be allocated.
+*/
+
+unsigned long workspace::num_allocations() const
+{
+	return(allocations);
+}
+
+/*!
+	@return Total size of all buffers that are currently reserved.
+*/
+
+size_t workspace::bytes_reserved() const
+{
+	size_t bytes = 0;
+	for(unsigned int i = 0; i < WS_NUM_SLOTS; i++)
+		bytes += sizes[i];
+
+	return(bytes);
+}
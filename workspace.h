@@ -0,0 +1,94 @@
+/*!
+	@file	workspace.h
+	@brief	Scratch memory that is shared by all heuristics of a thread
+
+	@author Bastian Rieck
+*/
+
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <cstddef>
+#include <cstring>
+
+#include "trace.h"
+
+/*!
+	Identifies a scratch buffer of a workspace. Buffers that are in use at
+	the same time need to have different slots.
+*/
+
+enum workspace_slot
+{
+	WS_BINS,		///< Fill levels of bins
+	WS_NEXT,		///< Auxiliary per-bin array
+	WS_SIZES,		///< Auxiliary per-size array
+	WS_POSITIONS,		///< Positions of objects
+	WS_TABLE_KEYS,		///< Keys of size_table
+	WS_TABLE_VALUES,	///< Values of size_table
+	WS_HEAP,		///< Elements of simple_heap
+
+	WS_NUM_SLOTS
+};
+
+/*!
+	Owns one scratch buffer per slot. Heuristics borrow their arrays from
+	the workspace of the problem instead of allocating them. The buffers
+	are kept and only grow, so that repeated runs, possibly on different
+	instances, do not allocate (and fault in) fresh memory each time. A
+	workspace must only be used by one thread at a time.
+*/
+
+class workspace {
+	public:
+		workspace();
+		~workspace();
+
+		template<typename T> T* borrow(workspace_slot slot, size_t count);
+		template<typename T> T* borrow_zeroed(workspace_slot slot, size_t count);
+
+		unsigned long num_requests() const;
+		unsigned long num_allocations() const;
+		size_t bytes_reserved() const;
+
+	private:
+		void* reserve(workspace_slot slot, size_t bytes);
+
+		void* buffers[WS_NUM_SLOTS];
+		size_t sizes[WS_NUM_SLOTS];
+
+		unsigned long requests;
+		unsigned long allocations;
+};
+
+/*!
+	Borrows an uninitialized array from the workspace. The array stays
+	valid until the same slot is borrowed again.
+
+	@param slot	Slot of the buffer
+	@param count	Number of elements
+*/
+
+template<typename T> T* workspace::borrow(workspace_slot slot, size_t count)
+{
+	return(reinterpret_cast<T*>(reserve(slot, count*sizeof(T))));
+}
+
+/*!
+	Borrows an array from the workspace whose elements are set to zero.
+
+	@param slot	Slot of the buffer
+	@param count	Number of elements
+*/
+
+template<typename T> T* workspace::borrow_zeroed(workspace_slot slot, size_t count)
+{
+	T* buffer = borrow<T>(slot, count);
+
+	trace_span span("zero", "allocation");
+	memset(buffer, 0, count*sizeof(T));
+
+	return(buffer);
+}
+
+#endif